@@ -0,0 +1,366 @@
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// Arbitrary precision
+// based on: https://github.com/RohanFredriksson/glsl-arbitrary-precision
+// PRECISION is the number of limbs after the sign. The arbprec tiers of mandelbrot.glsl use the same operations at each
+// of their limb counts, ShaderGenTool generates them from this type and checks them against it (tools/arb_prec_gen.hpp)
+template <int PRECISION>
+class arb_prec_n_t {
+    static_assert(PRECISION >= 2, "rounding of a product reads the limb below the last one kept");
+
+    static constexpr float BASE = 4294967296.0f;
+    static constexpr unsigned int HALF_BASE = 2147483648u;
+
+    unsigned int val[PRECISION+1];
+public:
+    arb_prec_n_t(void) : val{0} {}
+    arb_prec_n_t(float val) {
+        *this = val;
+    }
+
+    static constexpr size_t size() {
+        return PRECISION+1;
+    }
+
+    static constexpr size_t precision() {
+        return PRECISION;
+    }
+
+    unsigned int* buffer() {
+        return &val[0];
+    }
+
+    const unsigned int* buffer() const {
+        return &val[0];
+    }
+
+    arb_prec_n_t& zero(void) {
+        // TODO: change to memset
+        for(int zero_i = 0; zero_i <= PRECISION; zero_i++)
+            this->val[zero_i] = 0u;
+        return *this;
+    }
+
+    arb_prec_n_t& operator=(float load_value) {
+        if (load_value == 0.0)
+            return zero();
+
+        this->val[0] = load_value < 0.0;
+        load_value *= load_value < 0.0 ? -1.0 : 1.0;
+
+        for(int load_i = 1; load_i <= PRECISION; load_i++) {
+            this->val[load_i] = (unsigned int)(load_value); 
+            load_value -= this->val[load_i];
+            load_value *= BASE;
+        }
+        return *this;
+    }
+
+    // exact decimal such as "-0.74364388703715870475219150611477", rounded to the nearest value of the last limb
+    // returns false when the text is no plain decimal or its integer part does not fit in a limb
+    static bool parse(const std::string& text, arb_prec_n_t& value) {
+        size_t parse_i = 0;
+        bool negative = false;
+        if (parse_i < text.size() && (text[parse_i] == '-' || text[parse_i] == '+'))
+            negative = text[parse_i++] == '-';
+
+        unsigned long long integer = 0;
+        bool digits = false;
+        for (; parse_i < text.size() && text[parse_i] >= '0' && text[parse_i] <= '9'; parse_i++, digits = true) {
+            integer = integer * 10 + (text[parse_i] - '0');
+            if (integer > 0xFFFFFFFFull)
+                return false;
+        }
+        std::vector<unsigned char> fraction; // decimal digits after the point
+        if (parse_i < text.size() && text[parse_i] == '.')
+            for (parse_i++; parse_i < text.size() && text[parse_i] >= '0' && text[parse_i] <= '9'; parse_i++, digits = true)
+                fraction.push_back(text[parse_i] - '0');
+        if (!digits || parse_i != text.size())
+            return false;
+
+        // every limb is the carry out of multiplying the remaining decimal fraction by the base
+        arb_prec_n_t result;
+        result.val[1] = (unsigned int)integer;
+        for (int parse_limb = 2; parse_limb <= PRECISION; parse_limb++) {
+            unsigned long long carry = 0;
+            for (size_t digit_i = fraction.size(); digit_i-- > 0;) {
+                unsigned long long digit = ((unsigned long long)fraction[digit_i] << 32) + carry;
+                fraction[digit_i] = (unsigned char)(digit % 10);
+                carry = digit / 10;
+            }
+            result.val[parse_limb] = (unsigned int)carry;
+        }
+        if (!fraction.empty() && fraction[0] >= 5) {
+            int round_i = PRECISION;
+            while (round_i > 0 && ++result.val[round_i] == 0u)
+                round_i--;
+            if (round_i == 0)
+                return false; // rounded past the integer limb
+        }
+
+        result.val[0] = negative && !(result == arb_prec_n_t());
+        value = result;
+        return true;
+    }
+
+    // exact decimal expansion, a binary fraction of n bits has n decimal places at most
+    std::string to_decimal(void) const {
+        std::string text = this->val[0] ? "-" : "";
+        text += std::to_string(this->val[1]);
+
+        unsigned int fraction[PRECISION+1];
+        bool remaining = false;
+        for (int copy_i = 2; copy_i <= PRECISION; copy_i++)
+            remaining |= (fraction[copy_i] = this->val[copy_i]) != 0u;
+        if (remaining)
+            text += '.';
+        while (remaining) {
+            unsigned long long carry = 0;
+            remaining = false;
+            for (int digit_i = PRECISION; digit_i >= 2; digit_i--) {
+                unsigned long long limb = (unsigned long long)fraction[digit_i] * 10 + carry;
+                fraction[digit_i] = (unsigned int)limb;
+                carry = limb >> 32;
+                remaining |= fraction[digit_i] != 0u;
+            }
+            text += (char)('0' + carry);
+        }
+        return text;
+    }
+
+    // exact long division by an integer, the remainder below the last limb is dropped
+    arb_prec_n_t& divide(unsigned int divisor) {
+        unsigned long long remainder = 0;
+        for (int divide_i = 1; divide_i <= PRECISION; divide_i++) {
+            unsigned long long part = (remainder << 32) | this->val[divide_i];
+            this->val[divide_i] = (unsigned int)(part / divisor);
+            remainder = part % divisor;
+        }
+        return *this;
+    }
+
+    // exact product with an integer, from the last limb up so every carry lands in a limb not read yet, a carry out
+    // of the integer limb is dropped
+    arb_prec_n_t& multiply(unsigned int factor) {
+        unsigned long long carry = 0;
+        for (int multiply_i = PRECISION; multiply_i >= 1; multiply_i--) {
+            unsigned long long part = (unsigned long long)this->val[multiply_i] * factor + carry;
+            this->val[multiply_i] = (unsigned int)part;
+            carry = part >> 32;
+        }
+        return *this;
+    }
+
+    // moves the limbs shift_n places towards the fractions, from the back so no limb is read after it was overwritten
+    arb_prec_n_t& shift(int shift_n) {
+        for(int shift_i = PRECISION; shift_i > shift_n; shift_i--)
+            this->val[shift_i] = this->val[shift_i-shift_n];
+        
+        for(int shift_i = 1; shift_i <= shift_n && shift_i <= PRECISION; shift_i++)
+            this->val[shift_i] = 0u;
+        
+        return *this;
+    }
+
+    arb_prec_n_t& negate(void) {
+        this->val[0] = this->val[0]==0u ? 1u : 0u;
+        return *this;
+    }
+
+    // nearest double, exact for the leading 53 bits which is plenty for ratios and pixel distances
+    double to_double(void) const {
+        double result = 0.0;
+        for (int conv_i = PRECISION; conv_i > 0; conv_i--)
+            result = result / BASE + this->val[conv_i];
+        return this->val[0] ? -result : result;
+    }
+
+    bool operator==(const arb_prec_n_t &b) const {
+        for (int cmp_i = 0; cmp_i <= PRECISION; cmp_i++)
+            if (this->val[cmp_i] != b.val[cmp_i])
+                return false;
+        return true;
+    }
+
+    const arb_prec_n_t operator+(const arb_prec_n_t &b) {
+        return arb_prec_n_t(*this) += b;
+    }
+
+    const arb_prec_n_t operator+(const float b) {
+        return arb_prec_n_t(*this) += arb_prec_n_t(b);
+    }
+
+    const arb_prec_n_t operator-(const arb_prec_n_t &b) {
+        return arb_prec_n_t(*this) -= b;
+    }
+
+    const arb_prec_n_t operator-(const float b) {
+        return arb_prec_n_t(*this) -= arb_prec_n_t(b);
+    }
+
+    const arb_prec_n_t operator*(const arb_prec_n_t &b) {
+        return arb_prec_n_t(*this) *= b;
+    }
+
+    const arb_prec_n_t operator*(const float b) {
+        return arb_prec_n_t(*this) * arb_prec_n_t(b);
+    }
+
+    const arb_prec_n_t operator/(const float b) {
+        return arb_prec_n_t(*this) /= b;
+    }
+
+    arb_prec_n_t& operator+=(const float b) {
+        return *this += arb_prec_n_t(b);
+    }
+
+    arb_prec_n_t& operator-=(const float b) {
+        return *this -= arb_prec_n_t(b);
+    }
+
+    arb_prec_n_t& operator*=(const float b) {
+        return *this *= arb_prec_n_t(b);
+    }
+
+    arb_prec_n_t& operator/=(const float b) {
+        return *this *= arb_prec_n_t(1/b);
+    }
+
+    arb_prec_n_t& operator-=(const arb_prec_n_t &b) {
+        return *this += arb_prec_n_t(b).negate();
+    }
+
+    arb_prec_n_t& operator+=(const arb_prec_n_t &b) {
+        unsigned int add_buffer[PRECISION+1]; 
+        bool add_pa = this->val[0] == 0u; 
+        bool add_pb = b.val[0] == 0u; 
+        
+        if(add_pa == add_pb) {
+            unsigned int add_carry = 0u;
+
+            for(int add_i=  PRECISION; add_i > 0; add_i--) {
+                unsigned int add_next = (unsigned int)(this->val[add_i] + b.val[add_i] < this->val[add_i]);
+                add_buffer[add_i] = this->val[add_i] + b.val[add_i] + add_carry;
+                add_carry = add_next;
+            }
+            add_buffer[0] = (unsigned int)(!add_pa);
+
+        } else {
+            bool add_flip=false;
+
+            for(int add_i = 1; add_i <= PRECISION; add_i++) {
+                if(b.val[add_i] > this->val[add_i]) {
+                    add_flip=true; 
+                    break;
+                } 
+                if(this->val[add_i] > b.val[add_i]) {
+                    break;
+                }
+            }
+
+            unsigned int add_borrow = 0u;
+            if(add_flip) {
+                for(int add_i = PRECISION; add_i > 0; add_i--) {
+                    add_buffer[add_i] = b.val[add_i] - this->val[add_i] - add_borrow; 
+                    add_borrow = (unsigned int)(b.val[add_i] < this->val[add_i] + add_borrow);
+                }
+            } else {
+                for(int add_i = PRECISION; add_i > 0; add_i--) {
+                    add_buffer[add_i] = this->val[add_i] - b.val[add_i] - add_borrow; 
+                    add_borrow = (unsigned int)(this->val[add_i] < b.val[add_i] || this->val[add_i] < b.val[add_i] + add_borrow);
+                }
+            }
+
+            add_buffer[0] = (unsigned int)(add_pa == add_flip);
+        }
+
+        for (int assign_i = 0; assign_i <= PRECISION; assign_i++)
+            this->val[assign_i] = add_buffer[assign_i];
+        
+        return *this;
+    }
+
+    arb_prec_n_t& operator*=(const arb_prec_n_t &b) {
+        unsigned int mul_buffer[PRECISION+1] = {0};
+        unsigned int mul_product[2*PRECISION-1] = {0};
+
+        for(int mul_i = 0; mul_i < PRECISION; mul_i++) {
+            unsigned int mul_carry = 0u; 
+            for(int mul_j = 0; mul_j < PRECISION; mul_j++) {
+                unsigned int mul_next = 0; 
+                unsigned int mul_value = this->val[PRECISION-mul_i] * b.val[PRECISION-mul_j]; 
+                if (mul_product[mul_i+mul_j] + mul_value < mul_product[mul_i+mul_j]) {
+                    mul_next++;
+                } 
+                mul_product[mul_i+mul_j] += mul_value; 
+                if(mul_product[mul_i+mul_j] + mul_carry < mul_product[mul_i+mul_j]) {
+                    mul_next++;
+                } 
+                mul_product[mul_i+mul_j] += mul_carry; 
+                unsigned int mul_lower_a = this->val[PRECISION-mul_i] & 0xFFFF; 
+                unsigned int mul_upper_a = this->val[PRECISION-mul_i] >> 16; 
+                unsigned int mul_lower_b = b.val[PRECISION-mul_j] & 0xFFFF; 
+                unsigned int mul_upper_b = b.val[PRECISION-mul_j] >> 16; 
+                unsigned int mul_lower = mul_lower_a * mul_lower_b; 
+                unsigned int mul_upper = mul_upper_a * mul_upper_b; 
+                unsigned int mul_mid = mul_lower_a * mul_upper_b; 
+                mul_upper += mul_mid >> 16;
+                mul_mid = mul_mid << 16;
+
+                if (mul_lower+mul_mid<mul_lower) {
+                    mul_upper++;
+                }
+
+                mul_lower += mul_mid; 
+                mul_mid = mul_lower_b * mul_upper_a;
+                mul_upper += mul_mid >> 16;
+                mul_mid = mul_mid << 16;
+                
+                if(mul_lower + mul_mid < mul_lower) {
+                    mul_upper++;
+                }
+                
+                mul_carry = mul_upper + mul_next;
+            }
+            
+            if(mul_i + PRECISION < 2*PRECISION-1) {
+                mul_product[mul_i+PRECISION] += mul_carry;
+            }
+        }
+        if(mul_product[PRECISION-2] >= HALF_BASE) {
+            for(int mul_i = PRECISION-1; mul_i < 2*PRECISION-1; mul_i++) {
+                if(mul_product[mul_i] + 1 > mul_product[mul_i]) {
+                    mul_product[mul_i]++;
+                    break;
+                }
+                mul_product[mul_i]++;
+            }
+        }
+        for(int mul_i = 0; mul_i < PRECISION; mul_i++) {
+            mul_buffer[mul_i+1] = mul_product[2*PRECISION-2-mul_i];
+        } if((this->val[0] == 0u) != (b.val[0] == 0u)) {
+            mul_buffer[0] = 1u;
+        }
+        
+        for (int assign_i = 0; assign_i <= PRECISION; assign_i++)
+            this->val[assign_i] = mul_buffer[assign_i];
+        
+        return *this;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const arb_prec_n_t& dt) {
+        if (dt.val[0])
+            os << "-";
+        for (unsigned int print_i = 1; print_i < arb_prec_n_t::size(); print_i++)
+            os << std::setfill('0') << std::setw(4) << dt.val[print_i] << " ";
+        return os;
+    }
+};
+
+// as many limbs as the deepest tier of mandelbrot.glsl reads
+using arb_prec_t = arb_prec_n_t<8>;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "gl_ext.hpp"
+#include "frame_cache.hpp"
+#include "view_state.hpp"
+#include "gen_uniforms.h"
+
+/**
+ * Fills queued tiles of the iteration buffer with compute_shader.comp instead of rasterising fragment_shader.frag.
+ * Each tile is one dispatch of 16x16 workgroups writing straight into the frame cache texture, workgroups whose border
+ * lies inside the set skip iterating their inside, and every workgroup adds its pixel and iteration counts to a
+ * statistics buffer with atomics.
+ * A tile too expensive for the frame budget is iterated in chunks over several frames instead, with z of its unfinished
+ * pixels kept in a tile sized state texture in between.
+ * The program is passed in with every render, one per precision tier (see tiered_program.hpp).
+ * Needs a GL 4.3 context, see load_gl_ext.
+ */
+class compute_renderer_t {
+public:
+    static constexpr int WORKGROUP_SIZE = 16;   // local_size of compute_shader.comp
+    static constexpr unsigned int STATISTICS_BINDING = 1; // shader storage binding of the render_statistics block
+    static constexpr int MIN_CHUNK = 16;        // fewest iterations a chunk advances, below that dispatch overhead dominates
+    static constexpr int STATE_LAYERS = 5;      // RGBA32UI layers of the state texture, holds z of the largest tier
+
+    // mirrors the render_statistics block of compute_shader.comp
+    struct statistics_t {
+        unsigned int pixels;        // pixels written
+        unsigned int escaped;       // pixels outside the set
+        unsigned int iterations;    // iterations spent, interior pixels filled from their border count none
+        unsigned int filled_groups; // workgroups which only iterated their border
+    };
+
+private:
+    unsigned int bound_program;         // uniforms below belong to this one
+    unsigned int statistics_buffer;
+    unsigned int state_texture[2];      // z and done flag of the chunked tile
+    std::unordered_map<unsigned int, GSV::compute_shader_uniforms_t> program_uniforms; // resolved once per tier
+    const GSV::compute_shader_uniforms_t* uniforms;
+
+    // tile being iterated in chunks
+    bool chunk_active;
+    rect_t chunk_tile;
+    unsigned int chunk_generation;
+    unsigned int chunk_program;         // its z is only understood by the tier that saved it
+    int chunk_start;                    // iterations its unfinished pixels went through
+    int dispatched;                     // iterations per pixel the last render advanced its tiles by
+
+    // makes program current, resolving its uniforms the first time it is used
+    void use(unsigned int program);
+
+public:
+    compute_renderer_t(void);
+    ~compute_renderer_t();
+
+    compute_renderer_t(const compute_renderer_t&) = delete;
+    compute_renderer_t& operator=(const compute_renderer_t&) = delete;
+
+    // computes the tiles into an RG32F iteration buffer with a compute_shader.comp program, visible to texture fetches
+    // and blits when this returns
+    // an iteration_chunk below view_state_t::MAX_ITERATIONS advances a single tile by that many iterations only and
+    // returns false while it has unfinished pixels, handing it the same tile of the same frame generation continues it
+    // in chunks whatever the budget is then, that tile has to come alone, see chunking
+    bool render(unsigned int program, unsigned int iterations, const std::vector<rect_t>& tiles, unsigned int generation,
+        int iteration_chunk);
+
+    // true while a tile of this frame generation is iterated in chunks, the next render has to be handed it alone
+    bool chunking(unsigned int generation) const { return chunk_active && chunk_generation == generation; }
+
+    // iterations per pixel the last render advanced its tiles by, what the frame budget is charged for
+    int dispatched_iterations(void) const { return dispatched; }
+
+    // totals since the last call, waits for outstanding dispatches
+    statistics_t take_statistics(void);
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+
+#include "arb_prec.hpp"
+
+/**
+ * Iterates a view on the CPU, in doubles with the escape test and smoothing of mandelbrot.glsl, so its iteration buffer
+ * reads the same as a rendered one (see fragment_shader.frag). Rows are spread over the hardware threads.
+ * Meant for previews at a fraction of the window resolution and for rendering without a GPU (render.cpp), views needing
+ * more than FRACTION_BITS are left to the GPU.
+ */
+namespace cpu_engine {
+    constexpr int   FRACTION_BITS  = 51;      // fraction bits of a double, the double tier of gen_shaders.sh
+    constexpr int   MAX_ITERATIONS = 256;     // MAX_ITTERATIONS of mandelbrot.glsl
+    constexpr float INTERIOR       = -1.0f;   // iteration value of points which never escaped
+    constexpr double BAILOUT_SQR   = 256.0;   // escape radius squared
+    constexpr int   VERSION        = 1;       // bumped whenever the values change, retires their iteration cache entries
+
+    // iteration count and final |z|^2 per pixel, rows bottom up like the frame cache texture
+    std::vector<float> render(const arb_prec_t& offset_x, const arb_prec_t& offset_y, const arb_prec_t& zoom,
+        int width, int height, int max_iterations = MAX_ITERATIONS);
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arb_prec.hpp"
+#include "perturbation.hpp"
+#include "tcp_socket.hpp"
+
+/**
+ * Rendering across processes, a coordinator queues blocks of pixels, worker processes connected over TCP render them
+ * and send their iteration values back, the caller reassembles them from futures.
+ * A job has one reference orbit (perturbation.hpp), the coordinator iterates it once and ships it to every worker as
+ * it connects, workers only build the BLA tables for the reach of the blocks they get. Workers may join and leave at
+ * any time: each holds as many blocks as it has threads and sends a heartbeat every HEARTBEAT_MS, one that closed its
+ * connection or stayed silent for TIMEOUT_MS is dropped and its blocks go back to the front of the queue.
+ * Messages are raw structs of the host, so coordinator and workers must share their byte order, which the handshake
+ * checks. mandelbrot-render --coordinator renders images, gigapixel files and videos this way, --worker runs a worker,
+ * any number of which may run on one host.
+ */
+
+// width x height pixels spacing apart around the point (centre_r, centre_i) away from the reference, none of them
+// further than reach from it
+struct distributed_block_t {
+    double centre_r, centre_i, spacing;
+    int32_t width, height;
+    double reach;
+};
+
+class coordinator_t {
+public:
+    static constexpr int HEARTBEAT_MS = 1000;
+    static constexpr int TIMEOUT_MS   = 5000;
+    static constexpr size_t QUEUED_BLOCKS = 128; // blocks callers keep queued ahead of the one they wait for
+
+private:
+    struct task_t {
+        distributed_block_t block;
+        std::promise<std::vector<float>> result;
+    };
+
+    struct worker_t {
+        int id;
+        tcp::socket_t socket;
+        int threads;                    // blocks it holds at once
+        std::set<uint64_t> in_flight;
+        bool dropped = false;
+        std::thread sender, receiver;
+    };
+
+    std::shared_ptr<const reference_orbit_t> reference;
+    std::vector<char> reference_message;
+    tcp::socket_t listener = -1;
+    std::thread acceptor;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<uint64_t, task_t> tasks;   // submitted and not returned yet
+    std::deque<uint64_t> queue;         // tasks on no worker
+    uint64_t next_task = 0;
+    std::list<std::unique_ptr<worker_t>> workers;
+    int next_worker = 0;
+    bool stopping = false;
+
+    void accept_workers(void);
+    void send_blocks(worker_t& worker);
+    void receive_results(worker_t& worker);
+    void drop(worker_t& worker, const char* reason);
+
+public:
+    coordinator_t(void) = default;
+    ~coordinator_t();
+
+    coordinator_t(const coordinator_t&) = delete;
+    coordinator_t& operator=(const coordinator_t&) = delete;
+
+    // accepts workers on address:port from now on, false with a message when it is taken
+    bool listen(const std::string& address, int port);
+    // the orbit of the job, workers which connected before get it now
+    void start(std::shared_ptr<const reference_orbit_t> reference);
+
+    // queues a block, its future holds the iteration values top down once a worker returned them, thread safe
+    std::future<std::vector<float>> submit(const distributed_block_t& block);
+    // tile (tile_x, tile_y) of a width x height view as tile_renderer_t::render_view_tile cuts it, after start
+    distributed_block_t view_tile(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        int width, int height, int tile, int tile_x, int tile_y, double reach) const;
+};
+
+// renders the blocks of the coordinator at address:port on threads, job after job, waiting for the next coordinator
+// while there is none, until the process is stopped
+void run_worker(const std::string& address, int port, int threads);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "iteration_file.hpp"
+
+/**
+ * Exponential map of a location, one tall log-polar strip from which every zoom frame around its centre is rebuilt,
+ * so a dive is rendered once whatever its length and frame rate.
+ * Column j lies at the angle 2 pi (j + 0.5) / columns, row i at the radius outer * exp(-2 pi (i + 0.5) / columns), top
+ * down from the outer edge. Pixels are square at every radius and every row covers the same zoom factor, the strip is
+ * as tall as the zoom range is deep.
+ * The strip is an iteration file (iteration_file.hpp) with the EXPONENTIAL projection and the outer radius as its
+ * pixel, rendered tile by tile on every core against one reference orbit (perturbation.hpp), resumable like a
+ * gigapixel render and colourable with --recolour to look at the strip itself.
+ */
+namespace exponential_map {
+    // columns a strip needs to give frames of width x height a sample per pixel at their corners
+    int columns(int width, int height, int tile_size);
+    // rows from the outer radius down to the inner one
+    int rows(int columns, double outer, double inner);
+
+    // renders the tiles of the strip which are not complete yet, false with a message when it is no strip
+    bool render(iteration_file_t& file);
+};
+
+// rebuilds frames from a complete strip, only reads the mapping so frames may be sampled in parallel
+class exponential_map_t {
+    iteration_file_t& file;
+    int columns, rows, tile_size;
+    double outer_log;           // ln of the outer radius
+    double rows_per_log;        // rows per factor e of the radius, columns / 2 pi
+
+    float value(int row, int column) const;
+
+public:
+    explicit exponential_map_t(iteration_file_t& file);
+
+    // every tile was rendered, a message when not
+    bool complete(void) const;
+    // narrowest view the strip still resolves at the centre, the innermost row is a pixel of it
+    double inner_width(int width) const;
+
+    // one row of a width x height view view_width wide around the centre, top down, iteration values with the interior
+    // at -1 like the renders
+    void sample_row(double view_width, int width, int height, int row, float* values) const;
+};
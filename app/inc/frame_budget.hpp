@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+
+/**
+ * Sizes the rendering work of a frame so it stays within a GPU time target, keeping the desktop responsive and clear of
+ * driver watchdogs however expensive the view is.
+ * Work is measured in abstract units (the renderers count pixel iterations), every frame's work is wrapped in a
+ * GL_TIME_ELAPSED query. Results are collected a few frames later without stalling, and update a smoothed cost per unit
+ * from which the budget for the next frames follows.
+ */
+class frame_budget_t {
+    static constexpr int    QUERIES    = 4;     // frames in flight whose timings have not been collected yet
+    static constexpr double SMOOTHING  = 0.25;  // weight of a new measurement in the cost estimate
+    static constexpr double MAX_GROWTH = 2.0;   // largest factor the budget grows by per measurement
+
+    unsigned int queries[QUERIES];
+    double work[QUERIES];       // units measured by each query
+    bool in_flight[QUERIES];    // query ended, result not collected yet
+    int next;                   // query the next frame uses
+    bool measuring;             // between begin and end
+
+    double target_ns;
+    double ns_per_unit;         // smoothed cost estimate, 0 until the first measurement
+    double budget_units;
+
+    void collect(void);
+
+public:
+    frame_budget_t(double target_ms, double initial_budget);
+    ~frame_budget_t();
+
+    frame_budget_t(const frame_budget_t&) = delete;
+    frame_budget_t& operator=(const frame_budget_t&) = delete;
+
+    // units of work that should fit in the target, updated from every measurement that finished in the meantime
+    double budget(void);
+
+    // forgets the cost estimate when the work changed its nature, such as another precision tier, frames still in flight
+    // are collected without being counted
+    void reset(double initial_budget);
+
+    // wrap the GPU work of one frame, end reports how many units were submitted
+    void begin(void);
+    void end(double units);
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <deque>
+#include <vector>
+
+#include "arb_prec.hpp"
+#include "gen_uniforms.h"
+
+/**
+ * Keeps the iteration buffer of the last rendered frame (iteration count and final |z|^2 per pixel, see
+ * fragment_shader.frag) offscreen, so a view change only recomputes what it has to and recolouring recomputes nothing.
+ * A pan copies the overlap over by the integer pixel shift between the two offsets and only queues the exposed strips,
+ * any other change resamples the previous frame as a preview and queues the whole frame.
+ * The queue is handed out in tiles, centre first, finished tiles replace the preview as they are rendered.
+ * A frame queued whole can be read back once finished and loaded again later, which is how the viewer keeps frames in
+ * the iteration cache (iteration_cache.hpp).
+ */
+
+struct rect_t {
+    int x, y;
+    int width, height;
+};
+
+class frame_cache_t {
+public:
+    static constexpr int    TILE_SIZE          = 128;        // edge length of the tiles the queue is split into
+
+private:
+    static constexpr double MAX_SUBPIXEL_ERROR = 1.0 / 64.0; // largest fractional shift still treated as a whole pixel
+
+    unsigned int fbo[2];
+    unsigned int texture[2];
+    int front;              // buffer holding the current, possibly partial, frame
+
+    int width, height;
+    bool valid;             // false until a frame has been started
+    unsigned int generation_nr; // bumped whenever the buffer changes other than through rendered tiles
+    unsigned int view_nr;       // bumped whenever a whole frame is queued
+    bool whole;                 // no pixel of the frame was shifted in from a previous view
+
+    arb_prec_t offset_x, offset_y, zoom; // view the front buffer is rendered with
+
+    std::deque<rect_t> queue;           // regions of the front buffer which still need rendering
+
+    unsigned int resample_program;      // draws the previous frame with a different scale and offset
+    unsigned int quad_vao;              // full screen quad
+    GSV::resample_shader_uniforms_t resample_uniforms;
+
+    void allocate(void);
+    void shift(int dx, int dy);
+    void resample(const arb_prec_t& new_offset_x, const arb_prec_t& new_offset_y, const arb_prec_t& new_zoom);
+    void enqueue(const rect_t& region);
+    void sort_queue(void);
+
+public:
+    frame_cache_t(int width, int height, unsigned int resample_program, unsigned int quad_vao);
+    ~frame_cache_t();
+
+    frame_cache_t(const frame_cache_t&) = delete;
+    frame_cache_t& operator=(const frame_cache_t&) = delete;
+
+    // reallocates the frame at a new size, the next update queues a full frame
+    void resize(int width, int height);
+
+    // moves the frame to the given view, queueing every region which needs to be recomputed
+    void update(const arb_prec_t& offset_x, const arb_prec_t& offset_y, const arb_prec_t& zoom);
+
+    // true while the frame still contains queued regions
+    bool pending(void) const { return !queue.empty(); }
+
+    // removes tiles from the queue until they cover pixel_budget pixels, draw calls should be scissored to them
+    // at least one tile is returned, with split_rows a first tile larger than the budget is cut down to whole rows and
+    // the rest stays queued in front
+    std::vector<rect_t> next_tiles(size_t pixel_budget, bool split_rows);
+
+    // puts an unfinished tile back in front of the queue
+    void requeue(const rect_t& tile) { queue.push_front(tile); }
+
+    // binds the frame as render target
+    void bind(void);
+
+    // RG32F texture holding the current, possibly partial, iteration buffer
+    unsigned int frame(void) const { return texture[front]; }
+
+    // changes whenever the iteration buffer was reallocated, shifted or replaced by a preview, anything derived from its
+    // pixels has to be rebuilt then, rendered tiles on the other hand only change the pixels they cover
+    unsigned int generation(void) const { return generation_nr; }
+
+    // scales an iteration buffer of another resolution over the whole frame as a preview, such as one of the CPU engine
+    // for the current view, the queue stays as it is and rendered tiles replace the preview as usual
+    void show_preview(const std::vector<float>& iterations, int preview_width, int preview_height);
+
+    // forces the next update to queue a full frame
+    void invalidate(void) { valid = false; }
+
+    // changes whenever update queued the whole frame for a view, which is exact until a pan shifts pixels in that were
+    // rendered up to MAX_SUBPIXEL_ERROR away from where they are shown
+    unsigned int view(void) const { return view_nr; }
+    bool exact(void) const { return whole; }
+
+    // view the frame is rendered with, updates within MAX_SUBPIXEL_ERROR of it keep it
+    const arb_prec_t& view_offset_x(void) const { return offset_x; }
+    const arb_prec_t& view_offset_y(void) const { return offset_y; }
+    const arb_prec_t& view_zoom(void) const { return zoom; }
+
+    // the iteration buffer as show_preview takes it, two values per pixel in rows bottom up
+    std::vector<float> read(void);
+
+    // replaces the whole frame by an iteration buffer of its size read earlier, nothing stays queued
+    void load(const std::vector<float>& iterations);
+};
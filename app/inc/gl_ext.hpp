@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <string>
+
+/**
+ * The few entry points and enums beyond the GL 3.3 core profile glad was generated for: GL 4.3 compute for the compute
+ * renderer, GL 4.1 program binaries for the program cache and KHR_parallel_shader_compile for building programs in the
+ * background. Named and declared the way glad does it, so calling code reads like plain GL.
+ * The load functions only report success when every entry point of their group is present, nothing of a group may be
+ * used otherwise.
+ */
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER                   0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER            0x90D2
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT        0x00000008
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT  0x00000020
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT        0x00000200
+#endif
+#ifndef GL_FRAMEBUFFER_BARRIER_BIT
+#define GL_FRAMEBUFFER_BARRIER_BIT          0x00000400
+#endif
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR            0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+
+extern PFNGLDISPATCHCOMPUTEPROC gl_ext_glDispatchCompute;
+#define glDispatchCompute gl_ext_glDispatchCompute
+extern PFNGLBINDIMAGETEXTUREPROC gl_ext_glBindImageTexture;
+#define glBindImageTexture gl_ext_glBindImageTexture
+extern PFNGLMEMORYBARRIERPROC gl_ext_glMemoryBarrier;
+#define glMemoryBarrier gl_ext_glMemoryBarrier
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+extern PFNGLGETPROGRAMBINARYPROC gl_ext_glGetProgramBinary;
+#define glGetProgramBinary gl_ext_glGetProgramBinary
+extern PFNGLPROGRAMBINARYPROC gl_ext_glProgramBinary;
+#define glProgramBinary gl_ext_glProgramBinary
+extern PFNGLPROGRAMPARAMETERIPROC gl_ext_glProgramParameteri;
+#define glProgramParameteri gl_ext_glProgramParameteri
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC gl_ext_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR gl_ext_glMaxShaderCompilerThreadsKHR
+
+// resolves the compute entry points, returns false when the context is older than 4.3 or any of them is missing
+bool load_gl_ext(GLADloadproc load);
+
+// resolves the program binary entry points, returns false when the context is older than 4.1, any of them is missing
+// or the driver offers no binary format to store programs in
+bool load_gl_program_binary(GLADloadproc load);
+
+// resolves glMaxShaderCompilerThreadsKHR when the context has KHR_parallel_shader_compile (or its ARB twin) and lets
+// the driver use as many threads as it likes, GL_COMPLETION_STATUS_KHR may be queried after that
+bool load_gl_parallel_compile(GLADloadproc load);
+
+// vendor, renderer and version strings of the current context, a line each, binaries and the values programs render
+// depend on them besides the sources
+std::string gl_driver(void);
@@ -0,0 +1,27 @@
+#pragma once
+
+/**
+ * OpenGL 4.5 core context without a window or a display, for rendering on servers and render farms.
+ * Takes the surfaceless platform of EGL_MESA_platform_surfaceless when there is one (Mesa, llvmpipe included) and the
+ * default display otherwise, and makes the context current without a surface (EGL_KHR_surfaceless_context), so there
+ * is no default framebuffer and everything draws into framebuffer objects.
+ * Only built where EGL is found, see MANDELBROT_EGL in app/CMakeLists.txt.
+ */
+class headless_context_t {
+    void* display;
+    void* context;
+
+public:
+    // creates the context, makes it current and loads glad, prints why when it can not
+    headless_context_t(void);
+    ~headless_context_t();
+
+    headless_context_t(const headless_context_t&) = delete;
+    headless_context_t& operator=(const headless_context_t&) = delete;
+
+    // true when the context is current and GL calls can be made
+    bool valid(void) const { return context != nullptr; }
+
+    // GL entry point lookup, a GLADloadproc for load_gl_ext and friends
+    static void* proc_address(const char* name);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "frame_cache.hpp"
+#include "view_state.hpp"
+#include "gen_uniforms.h"
+
+/**
+ * Iteration histogram of the frame and its cumulative distribution, used by the colour pass to spread the palette
+ * evenly over the pixels instead of evenly over the iterations.
+ * The histogram is kept up to date incrementally: every tile is scattered out (-1) before it is rendered and back in (+1)
+ * after, so the distribution follows the progressive frame at the cost of its new pixels only. The prefix sum is only
+ * rerun before a present that follows a change.
+ * Scattering draws one point per pixel onto its bin with additive blending, the prefix sum is a Hillis-Steele scan
+ * over ping-pong textures, neither needs more than GL 3.3.
+ */
+class histogram_t {
+public:
+    static constexpr int   BINS      = 1024;
+    static constexpr float BIN_SCALE = (float)BINS / view_state_t::MAX_ITERATIONS; // bins per iteration, larger values share the last bin
+
+private:
+    unsigned int counts_fbo, counts_texture;   // pixels per bin
+    unsigned int scan_fbo[2], scan_texture[2]; // ping-pong buffers of the prefix sum
+    int cdf_index;                             // scan texture holding the result
+    bool dirty;                                // counts changed since the last scan
+
+    unsigned int scatter_program, scan_program;
+    unsigned int empty_vao;                    // scatter points are generated from gl_VertexID
+    unsigned int quad_vao;
+    GSV::histogram_scatter_uniforms_t scatter_uniforms; // both stages of the scatter program
+    GSV::histogram_count_uniforms_t count_uniforms;
+    GSV::prefix_sum_uniforms_t scan_uniforms;
+
+    static void allocate(unsigned int fbo, unsigned int texture);
+
+public:
+    histogram_t(unsigned int scatter_program, unsigned int scan_program, unsigned int quad_vao);
+    ~histogram_t();
+
+    histogram_t(const histogram_t&) = delete;
+    histogram_t& operator=(const histogram_t&) = delete;
+
+    // empties every bin
+    void clear(void);
+
+    // adds weight to the bin of every computed pixel in a region of an iteration buffer
+    void scatter(unsigned int iterations, const rect_t& region, float weight);
+
+    // R32F bins x 1 texture with the cumulative pixel count up to and including each bin, scanning first if needed
+    unsigned int cdf(void);
+};
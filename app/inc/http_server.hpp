@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Minimal HTTP/1.1 server for localhost, GET only, for mandelbrot-serve (serve.cpp).
+ * One thread accepts connections and watches the idle ones, a fixed pool of threads serves one request at a time. A
+ * keep-alive connection goes back to the idle ones after each response rather than holding its thread, so more
+ * viewers than threads take turns. At most queue_limit connections wait, idle or for a thread, further ones are
+ * answered with 503 right away, so a burst never grows memory or threads. Idle connections are dropped after
+ * IDLE_TIMEOUT_MS.
+ * http_client_t is the other end, one keep-alive connection for the load generator (load.cpp).
+ */
+
+struct http_request_t {
+    std::string method;
+    std::string path;                           // without the query
+    std::map<std::string, std::string> query;   // percent decoded
+};
+
+struct http_response_t {
+    int status = 200;
+    std::string content_type = "text/plain";
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers; // beyond the content type and length
+};
+
+class http_server_t {
+public:
+    using handler_t = std::function<http_response_t(const http_request_t&)>;
+
+    static constexpr int IDLE_TIMEOUT_MS = 5000;
+    static constexpr size_t MAX_REQUEST_SIZE = 16384; // request line and headers
+
+private:
+    struct connection_t {
+        intptr_t socket;                                // tcp::socket_t (tcp_socket.hpp)
+        std::string buffer;                             // received beyond the last request
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    handler_t handler;
+    intptr_t listener = -1;
+    intptr_t wake_sender = -1, wake_receiver = -1;  // wakes run when a connection turns idle or the server stops
+    std::vector<connection_t> idle;                 // waiting for their next request, only run touches them
+    std::deque<connection_t> ready;                 // a request arrived, waiting for a thread of the pool
+    std::vector<connection_t> returned;             // idle again after a response, for run to watch
+    size_t queue_limit;
+    std::mutex connections_mutex;
+    std::condition_variable connections_changed;
+    bool stopping = false;
+    std::vector<std::thread> pool;
+
+    void serve_connections(void);
+    // answers one request, false when the connection is done
+    bool serve(connection_t& connection);
+    void wake(void);
+
+public:
+    http_server_t(handler_t handler, int threads, size_t queue_limit);
+    ~http_server_t();
+
+    http_server_t(const http_server_t&) = delete;
+    http_server_t& operator=(const http_server_t&) = delete;
+
+    // binds 127.0.0.1:port, false with a message when it is taken
+    bool listen(int port);
+    // accepts and watches connections until the listener fails or the server stops
+    void run(void);
+
+    static const char* status_text(int status);
+};
+
+// one keep-alive connection to a server on 127.0.0.1
+class http_client_t {
+    intptr_t connection = -1;
+    std::string buffer;     // received beyond the last response
+
+public:
+    http_client_t(void) = default;
+    ~http_client_t();
+
+    http_client_t(const http_client_t&) = delete;
+    http_client_t& operator=(const http_client_t&) = delete;
+
+    bool connect(int port);
+    // sends GET target and reads the response, header names in lower case, false once the connection broke,
+    // connect again to go on
+    bool get(const std::string& target, http_response_t& response);
+    void close(void);
+};
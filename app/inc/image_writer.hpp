@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Streams an image to disk band by band in scanline order, top down, so poster sized renders never hold the whole
+ * image. Memory is bounded by the bands in flight, at most QUEUED_BANDS waiting plus the one being encoded.
+ * Encoding and writing run on a thread of their own, the renderer only blocks when it gets QUEUED_BANDS ahead of the
+ * disk. The format follows the extension of the path:
+ *  .ppm    binary P6, rgb8
+ *  .png    rgb8 through incremental deflate, only when built with zlib (MANDELBROT_ZLIB)
+ *  .pfm    greyscale floats of the iteration values, the interior is -1, for colouring or tone mapping elsewhere
+ */
+
+enum class pixel_format_t {
+    RGB8,       // 3 bytes per pixel in rgb
+    ITERATION,  // 1 float per pixel, the iteration value
+};
+
+// rows of an image, top down, filled in the pixel format of the writer they go to
+struct image_band_t {
+    int rows = 0;
+    std::vector<uint8_t> rgb;
+    std::vector<float> iterations;
+};
+
+// one file format, only ever called from the writer thread
+class image_encoder_t {
+public:
+    virtual ~image_encoder_t() = default;
+
+    virtual pixel_format_t format(void) const = 0;
+    // encodes and writes the next band
+    virtual bool encode(const image_band_t& band) = 0;
+    // writes what follows the last row
+    virtual bool finish(void) = 0;
+};
+
+class image_writer_t {
+public:
+    static constexpr size_t QUEUED_BANDS = 2;
+
+private:
+    std::unique_ptr<image_encoder_t> encoder;
+    std::deque<image_band_t> queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_changed;
+    bool closing = false;
+    bool failed = false;    // set by the writer thread once a band did not make it to the disk
+    std::thread thread;
+
+    explicit image_writer_t(std::unique_ptr<image_encoder_t> encoder);
+
+    void run(void);
+    void fail(void);
+
+public:
+    // picks the format from the extension, nullptr with a message when it is unknown or the file can not be created
+    static std::unique_ptr<image_writer_t> open(const std::string& path, int width, int height);
+    ~image_writer_t();
+
+    image_writer_t(const image_writer_t&) = delete;
+    image_writer_t& operator=(const image_writer_t&) = delete;
+
+    pixel_format_t format(void) const { return encoder->format(); }
+
+    // queues the next band, blocks while QUEUED_BANDS are waiting, false once writing failed
+    bool write(image_band_t band);
+
+    // waits for every queued band and ends the file, true when the whole image reached the disk
+    bool close(void);
+};
+
+// encodes a whole image into bytes in the format of an extension such as ".png", for answers rather than files, false
+// with a message when the format is unknown
+bool encode_image(const std::string& extension, int width, int height, const image_band_t& image, std::string& bytes);
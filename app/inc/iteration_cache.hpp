@@ -0,0 +1,62 @@
+#pragma once
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "arb_prec.hpp"
+
+/**
+ * Keeps the iteration buffers of rendered views on disk, so revisiting a view loads it instead of iterating it again.
+ * An entry is keyed by a hash of the identity of its view: the limbs of the three exact values placing it (offsets and
+ * zoom in the viewer, centre and pixel size in mandelbrot-render), its size, the iteration cap and the engine that
+ * rendered it with its version. The entry repeats that identity in its header so a hash collision reads as a miss, and
+ * carries an FNV-1a checksum of its values, an entry failing it is removed.
+ * Loads touch their entry, stores evict the entries used longest ago until the directory fits max_bytes again.
+ */
+class iteration_cache_t {
+public:
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 1ull << 30;
+
+    // a view as rendered by one engine, anything that changes its values has to change one of these
+    struct view_t {
+        std::string engine;     // engine with its version and the layout of its values, see tile_renderer.hpp
+        arb_prec_t x, y, scale;
+        int width, height;
+        int max_iterations;
+    };
+
+private:
+    static constexpr uint32_t MAGIC   = 0x4349424du; // "MBIC"
+    static constexpr uint32_t VERSION = 1;           // bumped whenever the entry layout changes
+
+    std::string directory;  // empty when caching is off
+    uint64_t max_bytes;
+
+    static std::string identity(const view_t& view);
+    std::string path(uint64_t hash) const;
+    void evict(void) const;
+
+public:
+    // caches in directory, created on first store, an empty directory or max_bytes == 0 turns caching off
+    iteration_cache_t(const std::string& directory, uint64_t max_bytes);
+
+    iteration_cache_t(const iteration_cache_t&) = delete;
+    iteration_cache_t& operator=(const iteration_cache_t&) = delete;
+
+    // per user cache directory of the platform, empty when there is none
+    static std::string default_directory(void);
+
+    // version of an engine that runs shader sources, a hash of their text, so editing them retires what they rendered
+    static std::string source_version(std::initializer_list<const char*> sources);
+
+    // true when caching is on and an entry of that many values is kept, larger ones would evict themselves right away
+    bool fits(size_t values) const { return !directory.empty() && values * sizeof(float) <= max_bytes; }
+
+    // the stored values of a view, false on a miss
+    bool load(const view_t& view, std::vector<float>& values) const;
+
+    // writes the values of a view, replacing whatever entry it had, then evicts down to max_bytes
+    void store(const view_t& view, const std::vector<float>& values) const;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "arb_prec.hpp"
+
+/**
+ * Iteration values of a gigapixel render, kept in a memory-mapped file so it can be coloured again later without
+ * recomputing, and so renders far larger than memory only hold the tiles being worked on. The same file holds the
+ * log-polar strips of exponential_map.hpp, which only map pixels to the plane differently.
+ * Layout, every part page aligned:
+ *  header_t
+ *  one status byte per tile, 1 once the tile reached the disk, a render that was cut short resumes from these
+ *  the tiles, tile-major in rows of tiles top down, each tile_size^2 floats in rows top down
+ * A row of tiles is one contiguous range, which is what the colour pass reads as a band.
+ * Finished tiles are handed to a flush thread, which writes them back, marks them done and drops their pages, the
+ * renderer only waits on it when MAX_PENDING_TILES are queued. The mapping asks for transparent huge pages where the
+ * kernel offers them for files, Windows has no large pages for file mappings.
+ */
+class iteration_file_t {
+public:
+    static constexpr char MAGIC[8] = {'M', 'B', 'I', 'T', 'E', 'R', '0', '1'};
+    static constexpr int MAX_LIMBS = 16;            // room for arb_prec_t::size() of deeper builds
+    static constexpr size_t MAX_PENDING_TILES = 64; // finished tiles waiting for the flush thread
+
+    // how pixels map to the plane, files without the field read as PLANE
+    enum class projection_t : uint32_t {
+        PLANE = 0,          // a view around the centre, pixel wide pixels
+        EXPONENTIAL = 1,    // log-polar strip around the centre, pixel is the radius of its outer edge
+    };
+
+    struct header_t {
+        char magic[8];
+        uint32_t width, height;         // image size in pixels
+        uint32_t tile_size;
+        uint32_t max_iterations;
+        uint32_t limbs;                 // arb_prec_t::size() of the build that wrote the file
+        uint32_t centre_x[MAX_LIMBS];   // arb_prec_t buffers of the view
+        uint32_t centre_y[MAX_LIMBS];
+        uint32_t pixel[MAX_LIMBS];      // size of one pixel in the complex plane
+        projection_t projection;
+    };
+    static_assert(arb_prec_t::size() <= MAX_LIMBS, "view does not fit the iteration file header");
+
+private:
+    uint8_t* mapping = nullptr;
+    size_t mapping_size = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int file_descriptor = -1;
+#endif
+    size_t status_offset = 0, tiles_offset = 0;
+
+    std::deque<size_t> pending;     // tiles waiting for the flush thread
+    std::mutex pending_mutex;
+    std::condition_variable pending_changed;
+    bool closing = false;
+    std::thread flusher;
+
+    iteration_file_t(void) = default;
+    bool map(const std::string& path, size_t size, bool create);
+    void layout(void);
+    void flush_tiles(void);
+
+    // writes a range back to the disk, waiting for it to get there
+    void sync(size_t offset, size_t size);
+    // drops the pages of a range from memory, they stay in the file
+    void release(size_t offset, size_t size);
+
+public:
+    static constexpr size_t PAGE_SIZE = 4096;
+
+    // creates the file at its full size, sparse where the file system allows it
+    static std::unique_ptr<iteration_file_t> create(const std::string& path, int width, int height, int tile_size,
+        int max_iterations, const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        projection_t projection = projection_t::PLANE);
+    // maps an existing file, nullptr with a message when it is no iteration file of this build
+    static std::unique_ptr<iteration_file_t> open(const std::string& path);
+    ~iteration_file_t();
+
+    iteration_file_t(const iteration_file_t&) = delete;
+    iteration_file_t& operator=(const iteration_file_t&) = delete;
+
+    const header_t& header(void) const { return *(const header_t*)mapping; }
+    int tiles_x(void) const;
+    int tiles_y(void) const;
+    arb_prec_t centre_x(void) const;
+    arb_prec_t centre_y(void) const;
+    arb_prec_t pixel(void) const;
+
+    // tile_size^2 iteration values, rows top down
+    float* tile(int tile_x, int tile_y);
+    bool complete(int tile_x, int tile_y) const;
+
+    // queues a tile whose values are all written for the flush thread, blocks while MAX_PENDING_TILES are queued
+    void finish(int tile_x, int tile_y);
+
+    // drops the pages of a row of tiles which was read, they stay in the file
+    void release_row(int tile_y);
+
+    // waits for the queued tiles, writes them back and unmaps the file
+    void close(void);
+};
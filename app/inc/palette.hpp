@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * A palette is a cyclic list of evenly spaced colours. It is baked on the CPU into a 1D texture, which the colour pass
+ * samples once per pixel at iteration / period with repeat wrapping, so long palettes and high iteration caps cost the
+ * same as short ones. Baked textures are cached by a hash of the definition, switching back to or reloading a palette
+ * never bakes it twice.
+ */
+
+struct colour_t {
+    uint8_t r, g, b;
+};
+
+struct palette_t {
+    std::string name;
+    std::vector<colour_t> colours;
+
+    // identifies the definition, the name does not take part
+    uint64_t hash(void) const;
+};
+
+// palettes compiled into the application
+const std::vector<palette_t>& builtin_palettes(void);
+
+// reads a palette file with one colour per line, either "#rrggbb" or "r g b" in 0-255, "//" starts a comment
+bool load_palette(const std::string& path, palette_t& palette);
+
+// colour at position cycles along the palette, wraps like the baked texture, for colouring on the CPU
+colour_t palette_colour(const palette_t& palette, double position);
+
+// colours count iteration values stride floats apart into rgb8 like the periodic mode of colour_shader.frag, points
+// which never escaped are black
+void colour_iterations(const palette_t& palette, float period, const float* iterations, size_t stride, size_t count,
+    uint8_t* rgb);
+
+// interpolates the colour cycle into entries rgba8 texels, the last texel blends back towards the first colour
+std::vector<uint8_t> bake_palette(const palette_t& palette, size_t entries);
+
+class palette_cache_t {
+    static constexpr size_t TEXELS_PER_COLOUR = 16;  // interpolation steps between two palette colours
+    static constexpr size_t MIN_TEXELS        = 256;
+
+    std::unordered_map<uint64_t, unsigned int> textures;
+
+public:
+    palette_cache_t(void) = default;
+    ~palette_cache_t();
+
+    palette_cache_t(const palette_cache_t&) = delete;
+    palette_cache_t& operator=(const palette_cache_t&) = delete;
+
+    // returns the 1D texture of a palette, baking and uploading it on first use
+    unsigned int texture(const palette_t& palette);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "arb_prec.hpp"
+
+/**
+ * Perturbation for the CPU, so views far deeper than a double resolves still iterate in doubles. One reference orbit Z
+ * is iterated in arb_prec_t, every pixel only iterates its difference to it, dz' = 2 Z dz + dz^2 + dc.
+ * Whenever a pixel gets closer to 0 than to the reference, or the reference ran out, it rebases onto the start of the
+ * orbit (dz = Z + dz, m = 0), so one orbit serves every pixel around it whether the reference escaped or not.
+ * Bilinear approximation (BLA) merges runs of 2^k steps into dz' = A dz + B dc while the dropped dz^2 stays negligible
+ * next to the linear part, which skips most of the iterations of a deep view.
+ * An orbit is immutable once built, every tile of a view or a pyramid (pyramid.hpp) shares one across threads.
+ * BLA steps only hold for points as close as max_delta, a table for a wide view skips little of a far deeper one, so
+ * with_reach() pairs the same orbit with a table for a narrower range, e.g. for the frames of a zoom video (video.hpp).
+ * The orbit itself can be handed to other processes (distributed.hpp), which rebuild the tables they need from it.
+ */
+class reference_orbit_t {
+    // 2^k steps starting at orbit index m taken at once, valid while |dz|^2 < radius_sqr
+    struct bla_t {
+        double a_r, a_i, b_r, b_i;
+        double radius_sqr;
+    };
+
+    static constexpr double BLA_EPSILON = 1.0 / 16777216.0; // 2^-24, relative error dz^2 may add, far below a pixel
+
+    arb_prec_t centre_x, centre_y;
+    int max_iterations;
+    std::shared_ptr<const std::vector<double>> orbit; // Z_m as re, im pairs from Z_0 = 0 until it escaped or the cap
+    std::vector<std::vector<bla_t>> levels; // levels[k][j] starts at m = 1 + j * 2^k and takes 2^k steps
+
+    reference_orbit_t(const reference_orbit_t& other, double max_delta);
+    void build_bla(double max_delta);
+
+public:
+    // max_delta bounds |dc| of every point the orbit will iterate, BLA steps stay valid over that whole range
+    reference_orbit_t(const arb_prec_t& centre_x, const arb_prec_t& centre_y, int max_iterations, double max_delta);
+
+    // an orbit iterated elsewhere, values as orbit() returns them
+    reference_orbit_t(const arb_prec_t& centre_x, const arb_prec_t& centre_y, int max_iterations,
+        std::vector<double> orbit, double max_delta);
+
+    // the same orbit, not iterated again, with BLA steps for points at most max_delta away
+    std::shared_ptr<const reference_orbit_t> with_reach(double max_delta) const;
+
+    const arb_prec_t& x(void) const { return centre_x; }
+    const arb_prec_t& y(void) const { return centre_y; }
+    int iterations(void) const { return max_iterations; }
+    // Z_m as re, im pairs from Z_0 = 0
+    const std::vector<double>& values(void) const { return *orbit; }
+
+    // iterations of the reference until it escaped, or the cap
+    size_t length(void) const { return orbit->size() / 2 - 1; }
+
+    // iteration value and final |z|^2 of the point dc away from the reference into pixel, like cpu_engine::render
+    void iterate(double dc_r, double dc_i, float* pixel) const;
+
+    // fraction bits of arb_prec_t, the reference resolves every pixel that fits
+    static constexpr int FRACTION_BITS = 32 * ((int)arb_prec_t::precision() - 1);
+    // bumped whenever the values iterate() returns change, retires what the iteration cache kept of the old ones
+    static constexpr int VERSION = 1;
+};
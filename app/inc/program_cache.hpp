@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Keeps linked programs on disk as driver binaries (glGetProgramBinary), so a warm start loads them instead of compiling
+ * the shader sources again.
+ * An entry is keyed by a hash of every stage source and the vendor, renderer and version strings of the context, and
+ * repeats that identity in its header so a hash collision or driver update reads as a miss. Misses and binaries the
+ * driver rejects fall back to compiling, the fresh program then replaces the entry.
+ * Needs load_gl_program_binary (gl_ext.hpp), without it every lookup misses and nothing is stored.
+ */
+class program_cache_t {
+public:
+    // one shader of a program, type is the GL shader type and source the text it is compiled from
+    struct stage_t {
+        unsigned int type;
+        const char* source;
+    };
+
+private:
+    static constexpr uint32_t MAGIC   = 0x4350424du; // "MBPC"
+    static constexpr uint32_t VERSION = 1;           // bumped whenever the entry layout changes
+
+    std::string directory;  // empty when caching is off
+    std::string driver;     // vendor, renderer and version of the context
+
+    static uint64_t source_hash(const std::vector<stage_t>& stages);
+    std::string path(uint64_t source_hash) const;
+
+public:
+    // caches in directory, created on first store, an empty directory or available == false turns caching off
+    program_cache_t(const std::string& directory, bool available);
+
+    program_cache_t(const program_cache_t&) = delete;
+    program_cache_t& operator=(const program_cache_t&) = delete;
+
+    // per user cache directory of the platform, empty when there is none
+    static std::string default_directory(void);
+
+    // a linked program with the stored binary of these stages, 0 on a miss
+    unsigned int load(const std::vector<stage_t>& stages) const;
+
+    // must be set before linking a program that is going to be stored
+    void prepare(unsigned int program) const;
+
+    // writes the binary of a linked program, replacing whatever entry the stages had
+    void store(unsigned int program, const std::vector<stage_t>& stages) const;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include "arb_prec.hpp"
+#include "palette.hpp"
+
+/**
+ * Zoomable map of a location as a tile pyramid, for deep zoom viewers such as OpenSeadragon or Leaflet.
+ *  DZI: <name>.dzi next to <name>_files/<level>/<column>_<row>.png, from a single pixel up to the full image
+ *  XYZ: <directory>/<z>/<x>/<y>.png, level z splits the square extent into 2^z by 2^z tiles
+ * Every level is rendered at its own resolution, not downsampled. One reference orbit at the location serves every tile
+ * of every level (perturbation.hpp), a worker per core renders, colours and encodes tiles of the current level.
+ * Levels are written coarse to fine and tiles already on disk are skipped, so an interrupted run resumes where it
+ * stopped and a partial pyramid can be browsed down to the last level it finished. Tiles are written under a temporary
+ * name and renamed once complete, a tile that exists is never half written.
+ */
+struct pyramid_options_t {
+    enum class layout_t { DZI, XYZ };
+
+    layout_t layout = layout_t::DZI;
+    std::string path;           // descriptor ending in .dzi, or the directory of an XYZ pyramid
+    arb_prec_t centre_x, centre_y;
+    arb_prec_t extent;          // width of the full image (DZI) or of the single tile of level 0 (XYZ)
+    int width = 0, height = 0;  // DZI, pixels of the full image
+    int levels = 0;             // XYZ, deepest level
+    int tile_size = 256;
+    int max_iterations = 256;
+    palette_t palette;
+    float palette_period = 64.0f;
+};
+
+// renders the pyramid, false with a message when a tile could not be written
+bool write_pyramid(const pyramid_options_t& options);
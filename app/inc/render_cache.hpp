@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Encoded renders in memory, least recently used first out once max_bytes are taken, for mandelbrot-serve.
+ * Keys are canonical view parameters, so every spelling of the same view finds the same entry. A key asked for while
+ * it renders waits for that render rather than starting another, however many ask at once.
+ */
+class render_cache_t {
+public:
+    using value_t = std::shared_ptr<const std::string>;
+
+    // how a get was answered
+    enum class source_t { HIT, MISS, COALESCED };
+
+    struct stats_t {
+        size_t hits = 0, misses = 0, coalesced = 0, evictions = 0;
+        size_t entries = 0, bytes = 0;
+    };
+
+private:
+    struct entry_t {
+        value_t value;
+        std::list<std::string>::iterator order;
+    };
+
+    size_t max_bytes;
+    std::mutex mutex;
+    std::list<std::string> order;   // most recently used first
+    std::unordered_map<std::string, entry_t> entries;
+    std::unordered_map<std::string, std::shared_future<value_t>> rendering;
+    stats_t counters;
+
+    void insert(const std::string& key, const value_t& value);
+
+public:
+    explicit render_cache_t(size_t max_bytes);
+
+    // the cached value of key, or the one render produces, render runs once for every key not cached or rendering;
+    // failed renders return nullptr and are not cached
+    value_t get(const std::string& key, const std::function<value_t(void)>& render, source_t* source = nullptr);
+
+    stats_t stats(void);
+};
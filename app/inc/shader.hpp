@@ -0,0 +1,69 @@
+#pragma once
+
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "program_cache.hpp"
+
+/**
+ * Helpers to turn the generated shader sources (see gen_shaders.h) into GL programs
+ */
+
+/**
+ * A program the driver is still compiling and linking. Starting one only hands the sources over, with
+ * KHR_parallel_shader_compile (load_gl_parallel_compile in gl_ext.hpp) the driver works on them on its own threads and
+ * ready() can be polled every frame without stalling. Without it ready() stays false and finish() waits for the driver.
+ */
+class program_build_t {
+    unsigned int program;
+    std::vector<unsigned int> shaders;                 // deleted once the status has been checked
+    std::vector<std::pair<unsigned int, std::string>> stages; // type and spliced source, the key of the cache entry
+    const program_cache_t* cache;
+    bool cached;                                        // loaded from the cache, already linked
+
+    std::vector<program_cache_t::stage_t> cache_stages(void) const;
+
+public:
+    program_build_t(std::vector<std::pair<unsigned int, std::string>> stages, const program_cache_t* cache);
+    ~program_build_t();
+
+    program_build_t(const program_build_t&) = delete;
+    program_build_t& operator=(const program_build_t&) = delete;
+
+    // true when finish() would not stall
+    bool ready(void) const;
+
+    // checks compile and link status, prints the info log and returns 0 on failure, the program belongs to the caller
+    // with a cache the linked program is stored into it
+    unsigned int finish(void);
+};
+
+// compile time features of the shaders, bit i is GSV::shader_features[i] (SHADER_FEATURES in gen_shaders.sh)
+typedef unsigned int feature_set_t;
+
+// the features that are on by default
+feature_set_t default_features(void);
+
+// a #define line for every feature of the set, spliced in as the first library so hot paths compile with exactly the
+// enabled features, every set gets a program and cache entry of its own
+std::string feature_defines(feature_set_t features);
+
+// starts compiling and linking a vertex and fragment shader
+// libraries such as GSV::mandelbrot are spliced into the fragment source after its #version line
+// with a cache the program is loaded from it when present and stored into it after linking otherwise
+std::unique_ptr<program_build_t> start_program(const char* vertex_source, const char* fragment_source,
+    std::initializer_list<const char*> fragment_libraries = {}, const program_cache_t* cache = nullptr);
+
+// same for a compute shader, only valid when load_gl_ext (gl_ext.hpp) succeeded
+std::unique_ptr<program_build_t> start_compute_program(const char* compute_source,
+    std::initializer_list<const char*> libraries = {}, const program_cache_t* cache = nullptr);
+
+// start_program followed by finish, for programs nothing can be drawn without
+unsigned int build_program(const char* vertex_source, const char* fragment_source,
+    std::initializer_list<const char*> fragment_libraries = {}, const program_cache_t* cache = nullptr);
+
+// same for a compute shader
+unsigned int build_compute_program(const char* compute_source, std::initializer_list<const char*> libraries = {},
+    const program_cache_t* cache = nullptr);
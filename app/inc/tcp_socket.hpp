@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Blocking IPv4 TCP sockets for the HTTP server (http_server.hpp) and distributed rendering (distributed.hpp), the
+ * little of BSD sockets and Winsock they need behind one interface. Sockets are intptr_t, -1 when there is none, a
+ * SOCKET of Winsock fits it as well. Winsock is started on first use.
+ */
+namespace tcp {
+    using socket_t = intptr_t;
+
+    // bound to address:port and listening, -1 when the address is no dotted IPv4 address or the port is taken
+    socket_t listen(const std::string& address, int port);
+    // next connection on a listener, -1 once the listener was closed
+    socket_t accept(socket_t listener);
+    // connected to address:port, -1 when nobody listens there
+    socket_t connect(const std::string& address, int port);
+    // two sockets connected to each other over loopback, sending on one wakes a thread waiting on the other
+    bool pair(socket_t& first, socket_t& second);
+
+    // sends all of data, false once the peer is gone
+    bool send_all(socket_t socket, const void* data, size_t size);
+    // receives what arrived up to size bytes, waits for at least one, 0 when the peer closed, -1 on errors and timeouts
+    long receive(socket_t socket, void* data, size_t size);
+    // receives exactly size bytes, false when the connection broke or timed out first
+    bool receive_all(socket_t socket, void* data, size_t size);
+    // waits up to milliseconds, -1 for ever, until one of sockets has something to receive or accept, a closed peer
+    // counts as well, readable holds a flag per socket, false on errors
+    bool wait_readable(const std::vector<socket_t>& sockets, int milliseconds, std::vector<bool>& readable);
+
+    // receives fail once nothing arrived for milliseconds
+    void set_timeout(socket_t socket, int milliseconds);
+    // sends small messages right away rather than waiting to fill a packet
+    void set_no_delay(socket_t socket);
+    // wakes every thread blocked on the socket, which stays valid until close
+    void shutdown(socket_t socket);
+    void close(socket_t socket);
+
+    // splits "address:port" or "port", the address defaults to 127.0.0.1, false when there is no valid port
+    bool parse_endpoint(const std::string& text, std::string& address, int& port);
+};
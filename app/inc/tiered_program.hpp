@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "arb_prec.hpp"
+#include "shader.hpp"
+
+/**
+ * One program per precision tier of mandelbrot.glsl (GSV::precision_tiers, generated from PRECISION_TIERS in
+ * gen_shaders.sh), so shallow views iterate in plain doubles and only deep ones pay for more limbs.
+ * The tiers are ordered by cost, a view gets the first one whose fraction bits resolve its pixels. A tier is started the
+ * first time a view needs it or up front through prefetch(), and handed out once the driver finished it, until then a
+ * more precise tier that is already linked stands in. One that fails to build, such as a double tier on hardware without
+ * fp64, is skipped from then on.
+ */
+class tiered_program_t {
+public:
+    // starts compiling and linking the program of one tier from the defines selecting it
+    using builder_t = std::function<std::unique_ptr<program_build_t>(const char* tier_defines)>;
+    // runs once on every program that linked, before it is handed out
+    using linked_t = std::function<void(unsigned int program)>;
+
+    // precision kept beyond the pixel spacing, rounding errors grow while iterating and with less than this slowly
+    // escaping pixels along the boundary start to differ from the deepest tier
+    static constexpr int GUARD_BITS = 16;
+
+private:
+    builder_t builder;
+    linked_t linked;
+    std::vector<std::unique_ptr<program_build_t>> builds; // started and not finished yet
+    std::vector<unsigned int> programs; // 0 until built
+    std::vector<bool> failed;           // tiers that did not build, never tried again
+    size_t current;                     // tier of the last program handed out
+
+    unsigned int poll(size_t tier, bool wait);
+    size_t wanted(double bits) const;
+
+public:
+    tiered_program_t(builder_t builder, linked_t linked);
+    ~tiered_program_t();
+
+    tiered_program_t(const tiered_program_t&) = delete;
+    tiered_program_t& operator=(const tiered_program_t&) = delete;
+
+    // fraction bits c needs to resolve the pixel spacing of a zoom at this resolution
+    static double required_bits(const arb_prec_t& zoom, int width, int height);
+
+    // program of the cheapest tier that resolves the view and builds, the most precise one that builds when none
+    // resolves it, 0 while that one is still being built and nothing stands in, or when none builds at all
+    // with wait the build is finished right away instead, stalling until the driver is done
+    unsigned int program(const arb_prec_t& zoom, int width, int height, bool wait);
+
+    // starts every tier not started yet, only worth it when the driver compiles in parallel
+    void prefetch(void);
+
+    // finishes the started tiers the driver is done with, so they are linked and cached before a view needs them
+    void collect(void);
+
+    // true while any started tier has not been finished
+    bool building(void) const;
+
+    // true when every tier failed to build
+    bool broken(void) const;
+
+    // tier the last program belongs to
+    size_t tier(void) const { return current; }
+    // tier program() hands out for a view unless another stands in while it is built, none when every tier failed
+    size_t wanted_tier(const arb_prec_t& zoom, int width, int height) const;
+    static const char* name(size_t tier);
+};
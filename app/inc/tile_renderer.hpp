@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "arb_prec.hpp"
+#include "perturbation.hpp"
+#include "program_cache.hpp"
+#include "tiered_program.hpp"
+#include "view_state.hpp"
+
+/**
+ * Renders square tiles of a view without a window, the building block of the batch renderer (render.cpp).
+ * A tile is given by the point at its centre and the size of one pixel, so the tiles of an image of any shape line up
+ * exactly and keep their pixels square, however deep the view.
+ * The GPU path draws fragment_shader.frag into a framebuffer object with the precision tier the pixel size needs, the
+ * CPU path runs cpu_engine. Both return the layout of the frame cache iteration buffer: iteration value and final |z|^2
+ * per pixel, rows bottom up.
+ * engine() names what rendered the values and its version for the iteration cache (iteration_cache.hpp), the CPU
+ * engines tell it without being built, so a cached view needs no reference orbit.
+ */
+class tile_renderer_t {
+public:
+    virtual ~tile_renderer_t() = default;
+
+    // size x size pixels centred on (centre_x, centre_y), empty when the tile could not be rendered
+    virtual std::vector<float> render(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        int size) = 0;
+
+    // fraction bits of c the engine resolves, pixels smaller than that come out blocky
+    virtual int fraction_bits(void) const = 0;
+
+    // tile (tile_x, tile_y) of a width x height view cut into tile^2 tiles from the top left, as iteration values in
+    // rows top down, false with a message when the engine failed
+    bool render_view_tile(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel, int width,
+        int height, int tile, int tile_x, int tile_y, float* values);
+
+    // centre of tile (tile_x, tile_y) of a width x height view, the one render_view_tile renders
+    static void view_tile_centre(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        int width, int height, int tile, int tile_x, int tile_y, arb_prec_t& x, arb_prec_t& y);
+
+    // width of a tile in the complex plane, the zoom of view_state_t
+    static arb_prec_t tile_zoom(const arb_prec_t& pixel, int size);
+};
+
+class cpu_tile_renderer_t : public tile_renderer_t {
+    int max_iterations;
+
+public:
+    explicit cpu_tile_renderer_t(int max_iterations);
+
+    std::vector<float> render(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        int size) override;
+    int fraction_bits(void) const override;
+    static std::string engine(void);
+};
+
+// deep views on the CPU, every pixel iterates against one reference orbit shared with the other tiles of the view
+class perturbation_tile_renderer_t : public tile_renderer_t {
+    std::shared_ptr<const reference_orbit_t> reference;
+    int threads;    // rows of a tile are spread over these
+
+public:
+    perturbation_tile_renderer_t(std::shared_ptr<const reference_orbit_t> reference, int threads);
+
+    std::vector<float> render(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        int size) override;
+    int fraction_bits(void) const override;
+    static std::string engine(void);
+};
+
+// needs a current context of at least GL 4.5, such as headless_context_t
+class gpu_tile_renderer_t : public tile_renderer_t {
+    static constexpr int ROWS_PER_DRAW = 64; // keeps every draw short enough for drivers that watch for hangs
+
+    program_cache_t program_cache;
+    view_state_t view_state;
+    std::string defines;                        // feature set and iteration cap, spliced into every tier
+    std::unique_ptr<tiered_program_t> programs;
+    unsigned int fbo, texture;
+    int texture_size;                           // 0 until the first tile
+    unsigned int quad_vao, quad_vbo, quad_ebo;
+
+public:
+    // load resolves the program binary entry points, programs are cached on disk when the driver has them
+    gpu_tile_renderer_t(int max_iterations, GLADloadproc load);
+    ~gpu_tile_renderer_t();
+
+    gpu_tile_renderer_t(const gpu_tile_renderer_t&) = delete;
+    gpu_tile_renderer_t& operator=(const gpu_tile_renderer_t&) = delete;
+
+    std::vector<float> render(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+        int size) override;
+    int fraction_bits(void) const override;
+    // the shader sources and the driver of the context besides the version
+    std::string engine(void) const;
+};
@@ -1,7 +1,25 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
 /**
  * This file is meant as a collection of commonly used function calls that don't have a specific relation to any other class
  */
 
-#define PARAM_UNUSED(param) (void)(param)
\ No newline at end of file
+#define PARAM_UNUSED(param) (void)(param)
+
+// FNV-1a, starts from FNV_OFFSET, a hash passed back in goes on over the next data
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size);
+
+// directory name below the per user cache directory of the platform, such as ~/.cache/mandelbrot/programs, empty when
+// there is none
+std::string user_cache_directory(const std::string& name);
+
+// creates path with what write puts into the stream, written next to it and renamed over it so concurrent readers
+// never see half a file, false with a message tagged tag when the directory, the file or the rename failed
+bool write_atomically(const std::string& path, const std::function<void(std::ostream&)>& write, const char* tag);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "arb_prec.hpp"
+#include "exponential_map.hpp"
+#include "palette.hpp"
+
+/**
+ * Zoom video into a location as an uncompressed Y4M stream (4:2:0, BT.601 video range), which ffmpeg and most players
+ * read from a file or a pipe. The width of the view is interpolated exponentially between keyframes, so the zoom runs
+ * at a constant speed between them.
+ * Frames are rendered in parallel, a worker per core, and written in order. One reference orbit at the centre serves
+ * the whole video (perturbation.hpp), the frames of every few halvings of the width share a BLA table built for the
+ * widest of them, so a frame costs only its own pixels.
+ * With an exponential map (exponential_map.hpp) the frames are resampled from its strip instead, and cost next to
+ * nothing to render. With a coordinator (distributed.hpp) the frames are cut into bands of rows for its workers, which
+ * get the reference orbit from it.
+ */
+
+class coordinator_t;
+
+// the view is width wide at time seconds into the video
+struct video_keyframe_t {
+    double time;
+    arb_prec_t width;
+};
+
+struct video_options_t {
+    arb_prec_t centre_x, centre_y;
+    std::vector<video_keyframe_t> keyframes;   // ascending times, the video runs from the first to the last
+    int width = 0, height = 0;                 // even, 4:2:0 halves both for the chroma planes
+    int fps = 60;
+    int max_iterations = 256;
+    palette_t palette;
+    float palette_period = 64.0f;
+    const exponential_map_t* exponential_map = nullptr; // complete strip around the centre the frames come from
+    coordinator_t* coordinator = nullptr;               // renders the frames on its workers, without a strip
+};
+
+// renders every frame into stream, false with a message when the options are invalid or the stream failed
+bool write_video(const video_options_t& options, std::ostream& stream);
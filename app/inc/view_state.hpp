@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "arb_prec.hpp"
+
+/**
+ * All state the fragment shader needs to render the view, uploaded through one std140 uniform buffer.
+ * The setters only mark the buffer dirty, upload() writes it once before the next draw that needs it.
+ * New parameters are added here and to the view_state block in fragment_shader.frag, in the same order.
+ */
+class view_state_t {
+public:
+    static constexpr unsigned int BINDING = 0; // uniform buffer binding point of the view_state block
+    static constexpr int MAX_ITERATIONS = 256;  // MAX_ITTERATIONS of mandelbrot.glsl
+
+    // how colour_shader.frag maps iterations onto the palette
+    enum colour_mode_t : unsigned int {
+        PERIODIC_COLOURING  = 0, // one palette revolution every palette_period iterations
+        HISTOGRAM_COLOURING = 1, // one revolution over the cumulative distribution of the frame, see histogram.hpp
+    };
+
+private:
+    // std140 pads every array element to 16 bytes
+    struct std140_uint_t {
+        unsigned int value;
+        unsigned int pad[3];
+    };
+
+    struct layout_t {
+        float           resolution[2];
+        float           time;
+        float           palette_period;
+        float           colour_offset;
+        float           exposure;
+        unsigned int    colour_mode;
+        float           pad[1];
+        std140_uint_t   zoom[arb_prec_t::size()];
+        std140_uint_t   offset_r[arb_prec_t::size()];
+        std140_uint_t   offset_i[arb_prec_t::size()];
+    } data;
+
+    unsigned int ubo;
+    bool dirty;
+
+    static bool set_limbs(std140_uint_t* dst, const arb_prec_t& src);
+
+public:
+    view_state_t(void);
+    ~view_state_t();
+
+    view_state_t(const view_state_t&) = delete;
+    view_state_t& operator=(const view_state_t&) = delete;
+
+    // connects the view_state block of a program to the buffer
+    void attach(unsigned int program);
+
+    void set_resolution(int width, int height);
+    void set_time(float time);
+    void set_colour(float palette_period, float offset, float exposure, colour_mode_t mode);
+    void set_view(const arb_prec_t& offset_x, const arb_prec_t& offset_y, const arb_prec_t& zoom);
+
+    // writes the buffer if anything changed since the last upload
+    void upload(void);
+};
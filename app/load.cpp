@@ -0,0 +1,147 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <cstdlib>
+
+#include "http_server.hpp"
+
+// mandelbrot-load, fetches random tiles from mandelbrot-serve over keep-alive connections and reports throughput and
+// latency percentiles, with how the cache answered
+namespace load_defaults {
+    constexpr int port        = 8080;
+    constexpr int connections = 8;
+    constexpr int requests    = 1000;
+    constexpr int level       = 4;      // tiles are drawn from the 4^level of this level
+    constexpr unsigned seed   = 1;
+};
+
+static void usage(const char* program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+        << "  --port <n>          port of mandelbrot-serve on 127.0.0.1, default " << load_defaults::port << "\n"
+        << "  --connections <n>   concurrent keep-alive connections, default " << load_defaults::connections << "\n"
+        << "  --requests <n>      requests over all connections, default " << load_defaults::requests << "\n"
+        << "  --level <n>         xyz level the tiles are drawn from, default " << load_defaults::level << "\n"
+        << "  --query <q>         query appended to every tile, such as re=-0.75&im=0.1&width=0.01\n"
+        << "  --seed <n>          seed of the tile sequence, default " << load_defaults::seed << std::endl;
+}
+
+// latency of one request and how it was answered
+struct sample_t {
+    double milliseconds;
+    int status;
+    std::string cache;
+    size_t bytes;
+};
+
+int main(int argc, char* argv[])
+{
+    int port = load_defaults::port, connections = load_defaults::connections;
+    int requests = load_defaults::requests, level = load_defaults::level;
+    unsigned seed = load_defaults::seed;
+    std::string query;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--port" && has_value) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--connections" && has_value) {
+            connections = std::atoi(argv[++i]);
+        } else if (arg == "--requests" && has_value) {
+            requests = std::atoi(argv[++i]);
+        } else if (arg == "--level" && has_value) {
+            level = std::atoi(argv[++i]);
+        } else if (arg == "--query" && has_value) {
+            query = argv[++i];
+        } else if (arg == "--seed" && has_value) {
+            seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (port <= 0 || port > 65535 || connections <= 0 || requests <= 0 || level < 0 || level > 22) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    // every connection takes the next request number, the tile of a number is fixed by the seed alone
+    std::vector<sample_t> samples(requests);
+    std::atomic<int> next{0}, failures{0};
+    auto work = [&]() {
+        http_client_t client;
+        bool connected = client.connect(port);
+        for (int i = next++; i < requests; i = next++) {
+            std::mt19937 random(seed * 2654435761u + (unsigned)i);
+            int x = (int)(random() % (1u << level)), y = (int)(random() % (1u << level));
+            std::string target = "/tile/" + std::to_string(level) + "/" + std::to_string(x) + "/" + std::to_string(y) +
+                ".png" + (query.empty() ? "" : "?" + query);
+
+            http_response_t response;
+            auto start = std::chrono::steady_clock::now();
+            bool answered = connected && client.get(target, response);
+            if (!answered) {
+                // the server closed the connection, one retry on a fresh one
+                connected = client.connect(port);
+                answered = connected && client.get(target, response);
+            }
+            double milliseconds = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            if (!answered) {
+                failures++;
+                samples[i] = {milliseconds, 0, "", 0};
+                continue;
+            }
+            std::string cache;
+            for (const auto& [name, value] : response.headers)
+                if (name == "x-cache")
+                    cache = value;
+            samples[i] = {milliseconds, response.status, cache, response.body.size()};
+        }
+    };
+
+    std::cout << "[LOAD] " << requests << " tiles of level " << level << " over " << connections
+        << " connections to 127.0.0.1:" << port << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < connections; i++)
+        threads.emplace_back(work);
+    for (std::thread& thread : threads)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int ok = 0, hits = 0, misses = 0, coalesced = 0, rejected = 0;
+    size_t bytes = 0;
+    std::vector<double> latencies;
+    for (const sample_t& sample : samples) {
+        if (sample.status == 200) {
+            ok++;
+            latencies.push_back(sample.milliseconds);
+        }
+        rejected += sample.status == 503;
+        hits += sample.cache == "hit";
+        misses += sample.cache == "miss";
+        coalesced += sample.cache == "coalesced";
+        bytes += sample.bytes;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double fraction) {
+        size_t index = std::min(latencies.size() - 1, (size_t)(fraction * latencies.size()));
+        return latencies.empty() ? 0.0 : latencies[index];
+    };
+
+    std::cout << "[LOAD] " << ok << " ok, " << rejected << " busy (503), " << requests - ok - rejected - failures
+        << " other errors, " << failures << " without answer in " << seconds << " s\n"
+        << "[LOAD] " << ok / seconds << " requests/s, " << bytes / seconds / (1 << 20) << " MB/s\n"
+        << "[LOAD] latency ms p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+            << ", max " << (latencies.empty() ? 0.0 : latencies.back()) << "\n"
+        << "[LOAD] cache " << hits << " hits, " << misses << " misses, " << coalesced << " coalesced" << std::endl;
+    return failures == 0 && ok == requests ? 0 : 1;
+}
@@ -7,11 +7,27 @@
 #include <map>
 #include <string>
 #include <deque>
+#include <vector>
+#include <memory>
 
 #include <cmath>
 
 #include "gen_shaders.h"
+#include "gen_uniforms.h"
 #include "util.hpp"
+#include "arb_prec.hpp"
+#include "frame_cache.hpp"
+#include "shader.hpp"
+#include "view_state.hpp"
+#include "palette.hpp"
+#include "histogram.hpp"
+#include "gl_ext.hpp"
+#include "compute_renderer.hpp"
+#include "frame_budget.hpp"
+#include "tiered_program.hpp"
+#include "program_cache.hpp"
+#include "cpu_engine.hpp"
+#include "iteration_cache.hpp"
 
 namespace my_window {
     constexpr size_t        height = 800;           // window height
@@ -22,245 +38,11 @@ namespace my_window {
     constexpr float         start_zoom     =  1.0;  // starting zoom of mandelbrot
     constexpr float         zoom_step      =  0.2;  // how much a scroll movement scrolls in
     constexpr size_t        max_deque_size = 25;    // maximum amount of "back" clicks to remember
-};
-
-// Arbitrary precision
-// based on: https://github.com/RohanFredriksson/glsl-arbitrary-precision
-class arb_prec_t {
-    static constexpr int PRECISION = 3;
-
-    static constexpr float BASE = 4294967296.0f;
-    static constexpr unsigned int HALF_BASE = 2147483648u;
-
-    unsigned int val[PRECISION+1];
-public:
-    arb_prec_t(void) : val{0} {}
-    arb_prec_t(float val) {
-        *this = val;
-    }
-
-    static constexpr size_t size() {
-        return PRECISION+1;
-    }
-
-    static constexpr size_t precision() {
-        return PRECISION;
-    }
-
-    unsigned int* buffer() {
-        return &val[0];
-    }
-
-    arb_prec_t& zero(void) {
-        // TODO: change to memset
-        for(int zero_i = 0; zero_i <= PRECISION; zero_i++)
-            this->val[zero_i] = 0u;
-        return *this;
-    }
-
-    arb_prec_t& operator=(float load_value) {
-        if (load_value == 0.0)
-            return zero();
-
-        this->val[0] = load_value < 0.0;
-        load_value *= load_value < 0.0 ? -1.0 : 1.0;
-
-        for(int load_i = 1; load_i <= PRECISION; load_i++) {
-            this->val[load_i] = (unsigned int)(load_value); 
-            load_value -= this->val[load_i];
-            load_value *= BASE;
-        }
-        return *this;
-    }
-
-    arb_prec_t& shift(int shift_n) {
-        for(int shift_i = shift_n+1; shift_i <= PRECISION; shift_i++)
-            this->val[shift_i] = this->val[shift_i-shift_n];
-        
-        for(int shift_i = 1; shift_i<=shift_n; shift_i++)
-            this->val[shift_i] = 0u;
-        
-        return *this;
-    }
-
-    arb_prec_t& negate(void) {
-        this->val[0] = this->val[0]==0u ? 1u : 0u;
-        return *this;
-    }
-
-    const arb_prec_t operator+(const arb_prec_t &b) {
-        return arb_prec_t(*this) += b;
-    }
-
-    const arb_prec_t operator+(const float b) {
-        return arb_prec_t(*this) += arb_prec_t(b);
-    }
-
-    const arb_prec_t operator-(const arb_prec_t &b) {
-        return arb_prec_t(*this) -= b;
-    }
-
-    const arb_prec_t operator-(const float b) {
-        return arb_prec_t(*this) -= arb_prec_t(b);
-    }
-
-    const arb_prec_t operator*(const arb_prec_t &b) {
-        return arb_prec_t(*this) *= b;
-    }
-
-    const arb_prec_t operator*(const float b) {
-        return arb_prec_t(*this) * arb_prec_t(b);
-    }
-
-    const arb_prec_t operator/(const float b) {
-        return arb_prec_t(*this) /= b;
-    }
-
-    arb_prec_t& operator+=(const float b) {
-        return *this += arb_prec_t(b);
-    }
-
-    arb_prec_t& operator-=(const float b) {
-        return *this -= arb_prec_t(b);
-    }
-
-    arb_prec_t& operator*=(const float b) {
-        return *this *= arb_prec_t(b);
-    }
-
-    arb_prec_t& operator/=(const float b) {
-        return *this *= arb_prec_t(1/b);
-    }
-
-    arb_prec_t& operator-=(const arb_prec_t &b) {
-        return *this += arb_prec_t(b).negate();
-    }
-
-    arb_prec_t& operator+=(const arb_prec_t &b) {
-        unsigned int add_buffer[PRECISION+1]; 
-        bool add_pa = this->val[0] == 0u; 
-        bool add_pb = b.val[0] == 0u; 
-        
-        if(add_pa == add_pb) {
-            unsigned int add_carry = 0u;
-
-            for(int add_i=  PRECISION; add_i > 0; add_i--) {
-                unsigned int add_next = (unsigned int)(this->val[add_i] + b.val[add_i] < this->val[add_i]);
-                add_buffer[add_i] = this->val[add_i] + b.val[add_i] + add_carry;
-                add_carry = add_next;
-            }
-            add_buffer[0] = (unsigned int)(!add_pa);
-
-        } else {
-            bool add_flip=false;
-
-            for(int add_i = 1; add_i <= PRECISION; add_i++) {
-                if(b.val[add_i] > this->val[add_i]) {
-                    add_flip=true; 
-                    break;
-                } 
-                if(this->val[add_i] > b.val[add_i]) {
-                    break;
-                }
-            }
-
-            unsigned int add_borrow = 0u;
-            if(add_flip) {
-                for(int add_i = PRECISION; add_i > 0; add_i--) {
-                    add_buffer[add_i] = b.val[add_i] - this->val[add_i] - add_borrow; 
-                    add_borrow = (unsigned int)(b.val[add_i] < this->val[add_i] + add_borrow);
-                }
-            } else {
-                for(int add_i = PRECISION; add_i > 0; add_i--) {
-                    add_buffer[add_i] = this->val[add_i] - b.val[add_i] - add_borrow; 
-                    add_borrow = (unsigned int)(this->val[add_i] < b.val[add_i] || this->val[add_i] < b.val[add_i] + add_borrow);
-                }
-            }
-
-            add_buffer[0] = (unsigned int)(add_pa == add_flip);
-        }
-
-        for (int assign_i = 0; assign_i <= PRECISION; assign_i++)
-            this->val[assign_i] = add_buffer[assign_i];
-        
-        return *this;
-    }
-
-    arb_prec_t& operator*=(const arb_prec_t &b) {
-        unsigned int mul_buffer[PRECISION+1] = {0};
-        unsigned int mul_product[2*PRECISION-1] = {0};
-
-        for(int mul_i = 0; mul_i < PRECISION; mul_i++) {
-            unsigned int mul_carry = 0u; 
-            for(int mul_j = 0; mul_j < PRECISION; mul_j++) {
-                unsigned int mul_next = 0; 
-                unsigned int mul_value = this->val[PRECISION-mul_i] * b.val[PRECISION-mul_j]; 
-                if (mul_product[mul_i+mul_j] + mul_value < mul_product[mul_i+mul_j]) {
-                    mul_next++;
-                } 
-                mul_product[mul_i+mul_j] += mul_value; 
-                if(mul_product[mul_i+mul_j] + mul_carry < mul_product[mul_i+mul_j]) {
-                    mul_next++;
-                } 
-                mul_product[mul_i+mul_j] += mul_carry; 
-                unsigned int mul_lower_a = this->val[PRECISION-mul_i] & 0xFFFF; 
-                unsigned int mul_upper_a = this->val[PRECISION-mul_i] >> 16; 
-                unsigned int mul_lower_b = b.val[PRECISION-mul_j] & 0xFFFF; 
-                unsigned int mul_upper_b = b.val[PRECISION-mul_j] >> 16; 
-                unsigned int mul_lower = mul_lower_a * mul_lower_b; 
-                unsigned int mul_upper = mul_upper_a * mul_upper_b; 
-                unsigned int mul_mid = mul_lower_a * mul_upper_b; 
-                mul_upper += mul_mid >> 16;
-                mul_mid = mul_mid << 16;
-
-                if (mul_lower+mul_mid<mul_lower) {
-                    mul_upper++;
-                }
-
-                mul_lower += mul_mid; 
-                mul_mid = mul_lower_b * mul_upper_a;
-                mul_upper += mul_mid >> 16;
-                mul_mid = mul_mid << 16;
-                
-                if(mul_lower + mul_mid < mul_lower) {
-                    mul_upper++;
-                }
-                
-                mul_carry = mul_upper + mul_next;
-            }
-            
-            if(mul_i + PRECISION < 2*PRECISION-1) {
-                mul_product[mul_i+PRECISION] += mul_carry;
-            }
-        }
-        if(mul_product[PRECISION-2] >= HALF_BASE) {
-            for(int mul_i = PRECISION-1; mul_i < 2*PRECISION-1; mul_i++) {
-                if(mul_product[mul_i] + 1 > mul_product[mul_i]) {
-                    mul_product[mul_i]++;
-                    break;
-                }
-                mul_product[mul_i]++;
-            }
-        }
-        for(int mul_i = 0; mul_i < PRECISION; mul_i++) {
-            mul_buffer[mul_i+1] = mul_product[2*PRECISION-2-mul_i];
-        } if((this->val[0] == 0u) != (b.val[0] == 0u)) {
-            mul_buffer[0] = 1u;
-        }
-        
-        for (int assign_i = 0; assign_i <= PRECISION; assign_i++)
-            this->val[assign_i] = mul_buffer[assign_i];
-        
-        return *this;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const arb_prec_t& dt) {
-        if (dt.val[0])
-            os << "-";
-        for (unsigned int print_i = 1; print_i < arb_prec_t::size(); print_i++)
-            os << std::setfill('0') << std::setw(4) << dt.val[print_i] << " ";
-        return os;
-    }
+    constexpr double        frame_budget_ms = 12.0; // GPU time the fractal may take per frame, leaves room for the rest
+    constexpr float         palette_period = 64.0;  // iterations per palette revolution
+    constexpr float         colour_cycle_speed = 0.1; // palette revolutions per second while cycling
+    constexpr int           preview_divisor = 8;    // the CPU preview computes one pixel per divisor^2 window pixels
+    constexpr double        build_poll_interval = 0.005; // seconds between polls while programs are being built
 };
 
 #define TRANSLATE_ZOOM(level) (powf(2, -level))
@@ -273,6 +55,7 @@ void event_key_callback(GLFWwindow* window, int key, int scancode, int action, i
 void event_mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 void event_framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void event_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void event_window_refresh_callback(GLFWwindow* window);
 
 arb_prec_t offset_x(my_window::start_offset_x);
 arb_prec_t offset_y(my_window::start_offset_y);
@@ -280,17 +63,37 @@ arb_prec_t zoom(my_window::start_zoom);
 float zoom_lvl = my_window::start_zoom;
 std::deque<arb_prec_t> prev_diff_x, prev_diff_y;
 
+// colouring, changing these only reruns the colour pass
+float palette_period = my_window::palette_period;
+float colour_offset = 0.0f;
+float exposure      = 1.0f;
+bool  colour_cycling = false;
+std::vector<palette_t> palettes;   // built in palettes followed by the ones given on the command line
+size_t palette_index = 0;
+bool  histogram_colouring = false;  // spread the palette over the pixel distribution instead of the iterations
+bool  histogram_stale     = true;   // histogram has not been built from the current frame yet
+
+// rendering path, compute needs a GL 4.3 context
+bool compute_available = false;
+bool use_compute       = false;
+bool renderer_changed  = false;     // the frame has to be redrawn by the other path
+
+// compile time shader features, F1 and up toggle GSV::shader_features, every set is a program variant of its own
+feature_set_t shader_features = default_features();
+bool features_changed = false;
+
+// render on demand state, the loop only redraws when one of these asks for it
+int  framebuffer_width, framebuffer_height;
+bool framebuffer_resized = false;   // frame cache has to be reallocated at the new size
+bool needs_present       = true;    // window contents were lost or the frame changed since the last swap
+
 // profiling
 void countFPS();
 
-int main(void)
+int main(int argc, char* argv[])
 {
     GLFWwindow* window;
 
-    // shader build output buffer
-    int success;
-    char infoLog[512];
-
     std::cout << "Compiled against GLFW " 
         << GLFW_VERSION_MAJOR << "." << GLFW_VERSION_MINOR << "." << GLFW_VERSION_REVISION << std::endl;
     #ifdef DEBUG
@@ -302,6 +105,20 @@ int main(void)
     if ((zoom_lvl-floorf(zoom_lvl)) > 0.01)
         zoom *= powf(2.0f, -1*(zoom_lvl-floorf(zoom_lvl)));
 
+    // --compute selects the compute renderer, every other argument is a palette file, see load_palette
+    palettes = builtin_palettes();
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--compute") {
+            use_compute = true;
+            continue;
+        }
+        palette_t palette;
+        if (load_palette(argv[i], palette)) {
+            palettes.push_back(palette);
+            palette_index = palettes.size() - 1; // start with the last palette given
+        }
+    }
+
     // Initialize the library
     if (!glfwInit()) {
         const char* description;
@@ -343,8 +160,12 @@ int main(void)
         std::cout << "[GLAD] [ERR]: Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    compute_available = load_gl_ext((GLADloadproc)glfwGetProcAddress);
+    bool binaries_available = load_gl_program_binary((GLADloadproc)glfwGetProcAddress);
+    bool parallel_compile = load_gl_parallel_compile((GLADloadproc)glfwGetProcAddress);
     glfwSwapInterval(1);                                    //
-    glViewport(0.5, 0.5, my_window::width, my_window::height);  // setup initial view port here
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height); // may differ from the window size on high dpi screens
+    glViewport(0, 0, framebuffer_width, framebuffer_height);   // setup initial view port here
 
     //*==================================
     //* Setup event callbacks
@@ -354,61 +175,26 @@ int main(void)
     glfwSetMouseButtonCallback(window, &event_mouse_button_callback);
     glfwSetScrollCallback(window, &event_scroll_callback);
     glfwSetFramebufferSizeCallback(window, &event_framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, &event_window_refresh_callback);
     glfwSetErrorCallback(&event_error_callback);
 
     //*==================================
     //* Setup shaders
     //*==================================
     
-    // create vertex shader & compile
-    unsigned int vertexShader;
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &GSV::vertex_shader, NULL);
-    glCompileShader(vertexShader);
-    
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success); // check compile output
-    if(!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "[GL] [ERR]: \"Failed to compile vertex shader\", " << infoLog << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // create fragment shader & compile
-    unsigned int fragmentShader;
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &GSV::fragment_shader, NULL);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success); // check compile output
-    if(!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "[GL] [ERR]: \"Failed to compile fragment shader\", " << infoLog << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // create shader program
-    unsigned int shaderProgram;
-    shaderProgram = glCreateProgram();
-
-    // link fragment and vertex shader to shader program
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetShaderiv(shaderProgram, GL_COMPILE_STATUS, &success); // check link output
-    if(!success) {
-        glGetShaderInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "[GL] [ERR]: \"Failed to link shaders\", " << infoLog << std::endl;
+    // linked programs of earlier runs, a warm start compiles nothing
+    program_cache_t program_cache(program_cache_t::default_directory(), binaries_available);
+
+    // preview program, scales the previous frame into a changed view
+    unsigned int resampleProgram = build_program(GSV::vertex_shader, GSV::resample_shader, {}, &program_cache);
+    // histogram programs, count the iteration distribution and take its prefix sum
+    unsigned int scatterProgram = build_program(GSV::histogram_scatter, GSV::histogram_count, {}, &program_cache);
+    unsigned int scanProgram = build_program(GSV::vertex_shader, GSV::prefix_sum, {}, &program_cache);
+    if (!resampleProgram || !scatterProgram || !scanProgram) {
         glfwTerminate();
         return -1;
     }
 
-    // clean up vertex and fragment shader, as program has been compiled, so individual units are no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
     //*==================================
     //* Create a triangle :D
     //*==================================
@@ -452,45 +238,320 @@ int main(void)
     //* Actual render loop happens here
     //*==================================
     
-    float timeValue = glfwGetTime();
-    int u_time_loc = glGetUniformLocation(shaderProgram, GSV::u_time);
-    int u_resolution_loc = glGetUniformLocation(shaderProgram, GSV::u_resolution);
-    int u_offset_r_loc = glGetUniformLocation(shaderProgram, GSV::u_offset_r);
-    int u_offset_i_loc = glGetUniformLocation(shaderProgram, GSV::u_offset_i);
-    int u_zoom_loc = glGetUniformLocation(shaderProgram, GSV::u_zoom);
-
-    glUseProgram(shaderProgram);        // use our shader for the triangle
-    glBindVertexArray(VAO);             // use our rectangle VAO
-    glUniform1f(u_time_loc, timeValue);
-    glUniform2f(u_resolution_loc, (float)my_window::width, (float)my_window::height);
-    glUniform1uiv(u_offset_r_loc, offset_x.size(), offset_x.buffer());
-    glUniform1uiv(u_offset_i_loc, offset_y.size(), offset_y.buffer());
-    glUniform1uiv(u_zoom_loc, zoom.size(), zoom.buffer());
+    // every parameter of the view goes through this buffer, only written when it changed
+    view_state_t view_state;
+    view_state.set_resolution(framebuffer_width, framebuffer_height);
+    if (!compute_available && use_compute)
+        std::cout << "[GL] [ERR]: \"Compute renderer needs OpenGL 4.3, using the fragment renderer\"" << std::endl;
+    use_compute = use_compute && compute_available;
+
+    // every program that draws with the shader features, built the first time a feature set is used and kept, so
+    // switching back to a set costs nothing
+    struct program_variant_t {
+        feature_set_t features;
+        std::string defines;                // spliced into every program of the variant
+        unsigned int colour_program;        // turns the iteration buffer into the image on screen
+        GSV::colour_shader_uniforms_t colour_uniforms;
+        std::unique_ptr<tiered_program_t> fractal_programs; // render the frame tile by tile, one program per tier
+        std::unique_ptr<tiered_program_t> compute_programs; // render the same frame through tiled dispatches, optional
+    };
+    auto attach = [&view_state](unsigned int program) { view_state.attach(program); };
+    auto build_variant = [&](feature_set_t features) -> std::unique_ptr<program_variant_t> {
+        auto variant = std::make_unique<program_variant_t>();
+        variant->features = features;
+        variant->defines = feature_defines(features);
+        const char* defines = variant->defines.c_str(); // the variant is never moved, the builders keep using it
+
+        variant->colour_program = build_program(GSV::vertex_shader, GSV::colour_shader, {defines}, &program_cache);
+        if (!variant->colour_program)
+            return nullptr;
+        view_state.attach(variant->colour_program);
+        variant->colour_uniforms.resolve(variant->colour_program);
+        glUseProgram(variant->colour_program);
+        glUniform1i(variant->colour_uniforms.u_iterations, 0); // iteration buffer is read from texture unit 0
+        glUniform1i(variant->colour_uniforms.u_palette, 1);    // palette from texture unit 1
+        glUniform1i(variant->colour_uniforms.u_cdf, 2);        // histogram cdf from texture unit 2
+        glUniform1f(variant->colour_uniforms.u_bin_scale, histogram_t::BIN_SCALE);
+
+        variant->fractal_programs = std::make_unique<tiered_program_t>(
+            [&program_cache, defines](const char* tier_defines) {
+                return start_program(GSV::vertex_shader, GSV::fragment_shader,
+                    {defines, tier_defines, GSV::mandelbrot, GSV::arb_prec_ops}, &program_cache);
+            }, attach);
+        variant->compute_programs = std::make_unique<tiered_program_t>(
+            [&program_cache, defines](const char* tier_defines) {
+                return start_compute_program(GSV::compute_shader,
+                    {defines, tier_defines, GSV::mandelbrot, GSV::arb_prec_ops}, &program_cache);
+            }, attach);
+
+        // with parallel compilation every tier is handed to the driver now, the one the view needs ahead of the rest,
+        // and the CPU engine shows a preview until it is linked, without it a tier is built when a view first needs it
+        if (parallel_compile) {
+            (use_compute ? variant->compute_programs : variant->fractal_programs)->program(
+                zoom, framebuffer_width, framebuffer_height, false);
+            variant->fractal_programs->prefetch();
+            if (compute_available)
+                variant->compute_programs->prefetch();
+        }
+        return variant;
+    };
+    std::map<feature_set_t, std::unique_ptr<program_variant_t>> variants;
+    variants[shader_features] = build_variant(shader_features);
+    program_variant_t* variant = variants[shader_features].get();
+    if (!variant) {
+        glfwTerminate();
+        return -1;
+    }
+    size_t precision_tier = GSV::precision_tier_count; // none yet, printed once the first program is handed out
+
+    // palettes are baked once on first use, switching between them only binds another texture
+    palette_cache_t palette_cache;
+
+    // previous frame, pans only compute the strips they expose and other view changes show it resampled until replaced
+    frame_cache_t frame_cache(framebuffer_width, framebuffer_height, resampleProgram, VAO);
+
+    // only maintained while histogram colouring is on, follows the frame tile by tile
+    histogram_t histogram(scatterProgram, scanProgram, VAO);
+    unsigned int histogram_generation = 0;
+
+    std::unique_ptr<compute_renderer_t> compute_renderer;
+    if (compute_available)
+        compute_renderer = std::make_unique<compute_renderer_t>();
+
+    // budget in pixel iterations, starts at one full tile and adapts to the measured GPU time
+    const double tile_work = (double)frame_cache_t::TILE_SIZE * frame_cache_t::TILE_SIZE * view_state_t::MAX_ITERATIONS;
+    frame_budget_t frame_budget(my_window::frame_budget_ms, tile_work);
+
+    // the CPU preview is only drawn until the GPU rendered anything, later view changes resample the previous frame
+    bool gpu_started = false;
+    unsigned int preview_generation = 0;
+    bool preview_shown = false;
+
+    // frames of earlier sessions, shared with mandelbrot-render, the key names the tier program and the driver since
+    // another of either renders slightly different values
+    iteration_cache_t iteration_cache(iteration_cache_t::default_directory(), iteration_cache_t::DEFAULT_MAX_BYTES);
+    const std::string driver = gl_driver();
+    iteration_cache_t::view_t cached_view;
+    unsigned int cached_view_nr = frame_cache.view(); // no view was looked up yet
+    size_t cached_tier = 0;         // tier the key names
+    bool frame_storable = false;    // every tile of the frame came from that tier
 
     // Loop until the user closes the window
     while (!glfwWindowShouldClose(window)) {
-        // Render here
-        glClearColor(0.2f, 0.0f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        if (framebuffer_resized) {
+            framebuffer_resized = false;
+            frame_cache.resize(framebuffer_width, framebuffer_height);
+            view_state.set_resolution(framebuffer_width, framebuffer_height);
+        }
 
-        countFPS();
+        if (colour_cycling) {
+            colour_offset = fmodf(glfwGetTime() * my_window::colour_cycle_speed, 1.0f);
+            needs_present = true;
+        }
 
-        // imagine having multiple of these for now    
-        glUseProgram(shaderProgram);        // use our shader for the triangle
-        glBindVertexArray(VAO);             // use our rectangle VAO
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0); // draw the actual rectangle ( interpret the VAO as a triangle )
+        if (renderer_changed) {
+            renderer_changed = false;
+            frame_cache.invalidate();
+        }
+
+        if (features_changed) {
+            features_changed = false;
+            std::unique_ptr<program_variant_t>& entry = variants[shader_features];
+            if (!entry)
+                entry = build_variant(shader_features);
+            if (entry) {
+                variant = entry.get();
+                frame_cache.invalidate();
+                histogram_stale = true;
+                std::cout << "features:";
+                for (unsigned int i = 0; i < GSV::shader_feature_count; i++)
+                    if (shader_features & (1u << i))
+                        std::cout << " " << GSV::shader_features[i].name;
+                std::cout << std::endl;
+            } else {
+                variants.erase(shader_features);
+                shader_features = variant->features; // keep drawing with the last set that built
+            }
+        }
+
+        // programs the driver finished in the background get linked and cached before a view asks for them
+        tiered_program_t& fractal_programs = *variant->fractal_programs;
+        tiered_program_t& compute_programs = *variant->compute_programs;
+        fractal_programs.collect();
+        compute_programs.collect();
+        if (use_compute && compute_programs.broken()) {
+            std::cout << "[GL] [ERR]: \"No compute program builds, using the fragment renderer\"" << std::endl;
+            compute_available = use_compute = false;
+            renderer_changed = true;
+        }
+        if (fractal_programs.broken()) {
+            std::cout << "[GL] [ERR]: \"No fractal program builds\"" << std::endl;
+            break;
+        }
+
+        // cheap when nothing changed, only queues work for view parameters that differ from the cached frame
+        frame_cache.update(offset_x, offset_y, zoom);
+
+        // a view queued whole is looked up on disk first, a hit leaves nothing to render
+        tiered_program_t& programs = use_compute ? compute_programs : fractal_programs;
+        if (frame_cache.pending() && frame_cache.exact() && frame_cache.view() != cached_view_nr) {
+            cached_view_nr = frame_cache.view();
+            cached_tier = programs.wanted_tier(frame_cache.view_zoom(), framebuffer_width, framebuffer_height);
+            cached_view.engine = std::string(use_compute ? "viewer compute " : "viewer fragment ") +
+                iteration_cache_t::source_version({variant->defines.c_str(), GSV::precision_tiers[cached_tier].defines,
+                    GSV::mandelbrot, GSV::arb_prec_ops, GSV::vertex_shader,
+                    use_compute ? GSV::compute_shader : GSV::fragment_shader}) + "\n" + driver;
+            cached_view.x = frame_cache.view_offset_x();
+            cached_view.y = frame_cache.view_offset_y();
+            cached_view.scale = frame_cache.view_zoom();
+            cached_view.width = framebuffer_width;
+            cached_view.height = framebuffer_height;
+            cached_view.max_iterations = view_state_t::MAX_ITERATIONS;
+            std::vector<float> iterations;
+            frame_storable = !iteration_cache.load(cached_view, iterations) ||
+                iterations.size() != 2 * (size_t)framebuffer_width * framebuffer_height;
+            if (!frame_storable) {
+                frame_cache.load(iterations);
+                needs_present = true;
+            }
+        }
 
-        timeValue = glfwGetTime();
-        glUniform1f(u_time_loc, timeValue);
-        glUniform1uiv(u_offset_r_loc, offset_x.size(), offset_x.buffer());
-        glUniform1uiv(u_offset_i_loc, offset_y.size(), offset_y.buffer());
-        glUniform1uiv(u_zoom_loc, zoom.size(), zoom.buffer());
+        if (histogram_colouring && (histogram_stale || histogram_generation != frame_cache.generation())) {
+            // the frame changed as a whole, count it again including any preview pixels
+            histogram.clear();
+            histogram.scatter(frame_cache.frame(), {0, 0, framebuffer_width, framebuffer_height}, 1.0f);
+            histogram_generation = frame_cache.generation();
+            histogram_stale = false;
+            needs_present = true;
+        }
+
+        // cheapest tier that still resolves the pixels of this zoom, their costs per iteration are far apart
+        // without parallel compilation a build stalls the loop, the CPU preview goes on screen first when there is one
+        bool preview_wanted = !gpu_started &&
+            tiered_program_t::required_bits(zoom, framebuffer_width, framebuffer_height) <= cpu_engine::FRACTION_BITS;
+        bool preview_current = preview_shown && preview_generation == frame_cache.generation();
+        unsigned int program = 0;
+        if (frame_cache.pending())
+            program = programs.program(zoom, framebuffer_width, framebuffer_height,
+                !parallel_compile && (!preview_wanted || preview_current));
+
+        if (frame_cache.pending() && !program && preview_wanted && !preview_current) {
+            // low resolution frame from the CPU engine while the first program is still being built
+            int preview_width  = std::max(framebuffer_width  / my_window::preview_divisor, 1);
+            int preview_height = std::max(framebuffer_height / my_window::preview_divisor, 1);
+            frame_cache.show_preview(cpu_engine::render(offset_x, offset_y, zoom, preview_width, preview_height),
+                preview_width, preview_height);
+            preview_generation = frame_cache.generation();
+            preview_shown = true;
+            needs_present = true;
+        }
 
-        // Swap front and back buffers
-        glfwSwapBuffers(window);
+        if (frame_cache.pending() && program) {
+            gpu_started = true;
+
+            // upload the view before drawing, queued tiles are rendered with the view the frame cache was updated to
+            view_state.set_view(offset_x, offset_y, zoom);
+            view_state.set_time(glfwGetTime());
+            view_state.upload();
+
+            if (programs.tier() != precision_tier) {
+                precision_tier = programs.tier();
+                frame_budget.reset(tile_work);
+                std::cout << "precision: " << tiered_program_t::name(precision_tier) << std::endl;
+            }
+            // a stand-in tier renders other values than the one the key names
+            if (programs.tier() != cached_tier)
+                frame_storable = false;
+
+            // the fragment renderer slices by rows, the compute renderer iterates a tile in chunks instead, a tile it
+            // started in chunks sits in front of the queue and is handed back alone until it is finished
+            double budget = frame_budget.budget();
+            size_t pixel_budget = (size_t)(budget / view_state_t::MAX_ITERATIONS);
+            if (use_compute && compute_renderer->chunking(frame_cache.generation()))
+                pixel_budget = 0;
+            std::vector<rect_t> tiles = frame_cache.next_tiles(pixel_budget, !use_compute);
+            double pixels = 0.0;
+            for (const rect_t& tile : tiles)
+                pixels += (double)tile.width * tile.height;
+            int iteration_chunk = view_state_t::MAX_ITERATIONS;
+            if (pixels * view_state_t::MAX_ITERATIONS > budget)
+                iteration_chunk = std::max(compute_renderer_t::MIN_CHUNK, (int)(budget / pixels));
+
+            if (histogram_colouring) {
+                for (const rect_t& tile : tiles)
+                    histogram.scatter(frame_cache.frame(), tile, -1.0f); // whatever preview the tile held is replaced
+            }
 
-        // Poll for and process events
-        glfwPollEvents();
+            frame_budget.begin();
+            if (use_compute) {
+                if (!compute_renderer->render(program, frame_cache.frame(), tiles, frame_cache.generation(), iteration_chunk))
+                    frame_cache.requeue(tiles.front());
+                frame_budget.end(pixels * compute_renderer->dispatched_iterations());
+            } else {
+                frame_cache.bind();
+                glUseProgram(program);              // use our shader for the triangle
+                glBindVertexArray(VAO);             // use our rectangle VAO
+                glEnable(GL_SCISSOR_TEST);
+                for (const rect_t& tile : tiles) {
+                    glScissor(tile.x, tile.y, tile.width, tile.height);
+                    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0); // draw the actual rectangle ( interpret the VAO as a triangle )
+                }
+                glDisable(GL_SCISSOR_TEST);
+                frame_budget.end(pixels * view_state_t::MAX_ITERATIONS);
+            }
+
+            if (histogram_colouring) {
+                for (const rect_t& tile : tiles)
+                    histogram.scatter(frame_cache.frame(), tile, 1.0f);
+            }
+
+            if (use_compute && !frame_cache.pending()) {
+                compute_renderer_t::statistics_t statistics = compute_renderer->take_statistics();
+                std::cout << "compute: " << statistics.pixels << " pixels, " << statistics.escaped << " escaped, "
+                    << statistics.iterations << " iterations, " << statistics.filled_groups << " filled workgroups"
+                    << std::endl;
+            }
+
+            // pans keep the key of the view they started from but not its exact pixels
+            if (!frame_cache.pending() && frame_cache.exact() && frame_storable)
+                iteration_cache.store(cached_view, frame_cache.read());
+            needs_present = true;
+        }
+
+        if (needs_present) {
+            countFPS();
+
+            // colour pass, one texel fetch per pixel, covers the whole framebuffer so no clear is needed
+            view_state.set_colour(palette_period, colour_offset, exposure,
+                histogram_colouring ? view_state_t::HISTOGRAM_COLOURING : view_state_t::PERIODIC_COLOURING);
+            view_state.upload();
+            unsigned int cdf = histogram_colouring ? histogram.cdf() : 0; // scans before the colour pass binds its target
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, framebuffer_width, framebuffer_height);
+            glUseProgram(variant->colour_program);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, frame_cache.frame());
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_1D, palette_cache.texture(palettes[palette_index]));
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, cdf);
+            glActiveTexture(GL_TEXTURE0);
+            glBindVertexArray(VAO);
+            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+            // Swap front and back buffers
+            glfwSwapBuffers(window);
+            needs_present = false;
+        }
+
+        // keep going while a progressive pass or palette cycling is in flight, otherwise sleep until an event arrives
+        // or, while the driver is building programs, until the next time they are polled
+        if ((frame_cache.pending() && program) || colour_cycling)
+            glfwPollEvents();
+        else if (fractal_programs.building() || compute_programs.building())
+            glfwWaitEventsTimeout(my_window::build_poll_interval);
+        else
+            glfwWaitEvents();
     }
 
     //*==================================
@@ -513,12 +574,14 @@ void handle_mouse(GLFWwindow* window)
 
 
     double xpos, ypos;
+    int width, height;
     glfwGetCursorPos(window, &xpos, &ypos);
+    glfwGetWindowSize(window, &width, &height);
 
-    // translate coordinates to center
+    // translate coordinates to center, snapped to whole pixels so the previous frame can be reused by shifting it
     arb_prec_t diff_x, diff_y;
-    diff_x = (xpos - my_window::width /2) / (my_window::width /2);
-    diff_y = (ypos - my_window::height/2) / (my_window::height/2);
+    diff_x = round(xpos - width /2.0) / (width /2.0);
+    diff_y = round(ypos - height/2.0) / (height/2.0);
 
     // divide zoom constant by 2 as number range is -1.0 - 1.0
     diff_x *= zoom / 2;
@@ -569,6 +632,38 @@ void event_key_callback(GLFWwindow* window, int key, int scancode, int action, i
     PARAM_UNUSED(mods);
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GLFW_TRUE);
+
+    if (action == GLFW_RELEASE)
+        return;
+
+    // colouring keys, none of these recompute the fractal
+    switch (key) {
+        case GLFW_KEY_P:             colour_cycling = !colour_cycling;                          break;
+        case GLFW_KEY_LEFT_BRACKET:  colour_offset  = fmodf(colour_offset + 0.95f, 1.0f);       break;
+        case GLFW_KEY_RIGHT_BRACKET: colour_offset  = fmodf(colour_offset + 0.05f, 1.0f);       break;
+        case GLFW_KEY_MINUS:         exposure      /= 1.25f;                                    break;
+        case GLFW_KEY_EQUAL:         exposure      *= 1.25f;                                    break;
+        case GLFW_KEY_COMMA:         palette_period = fmaxf(palette_period / 1.25f, 1.0f);      break;
+        case GLFW_KEY_PERIOD:        palette_period *= 1.25f;                                   break;
+        case GLFW_KEY_C:             palette_index  = (palette_index + 1) % palettes.size();
+                                     std::cout << "palette: " << palettes[palette_index].name << std::endl; break;
+        case GLFW_KEY_H:             histogram_colouring = !histogram_colouring;
+                                     histogram_stale = true;                                    break;
+        case GLFW_KEY_R:
+            if (!compute_available)
+                return;
+            use_compute = !use_compute;
+            renderer_changed = true;
+            std::cout << "renderer: " << (use_compute ? "compute" : "fragment") << std::endl;
+            break;
+        default:
+            if (key < GLFW_KEY_F1 || key >= GLFW_KEY_F1 + (int)GSV::shader_feature_count)
+                return;
+            shader_features ^= 1u << (key - GLFW_KEY_F1);
+            features_changed = true;
+            break;
+    }
+    needs_present = true;
 }
 
 void event_mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
@@ -607,7 +702,19 @@ void event_scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 void event_framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     PARAM_UNUSED(window);
-    glViewport(0.5, 0.5, width, height);
+    if (width == 0 || height == 0)
+        return; // minimized, keep the frame we have
+    glViewport(0, 0, width, height);
+    framebuffer_width = width;
+    framebuffer_height = height;
+    framebuffer_resized = true;
+    needs_present = true;
+}
+
+void event_window_refresh_callback(GLFWwindow* window)
+{
+    PARAM_UNUSED(window);
+    needs_present = true; // contents were damaged, show the cached frame again
 }
 
 void countFPS()
@@ -621,7 +728,7 @@ void countFPS()
     {
         std::cout << num_frames << " fps" << std::endl;
         num_frames = 0;
-        last_time += 1.0;
+        last_time = current_time; // frames are only drawn on demand, so there can be long gaps
     }
 }
  
\ No newline at end of file
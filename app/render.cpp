@@ -0,0 +1,587 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "arb_prec.hpp"
+#include "palette.hpp"
+#include "tiered_program.hpp"
+#include "tile_renderer.hpp"
+#include "cpu_engine.hpp"
+#include "image_writer.hpp"
+#include "iteration_file.hpp"
+#include "pyramid.hpp"
+#include "video.hpp"
+#include "exponential_map.hpp"
+#include "distributed.hpp"
+#include "tcp_socket.hpp"
+#include "iteration_cache.hpp"
+#ifdef MANDELBROT_EGL
+    #include "headless_context.hpp"
+#endif
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
+// mandelbrot-render, renders one image without a window or a display, for scripts, servers and render farms
+namespace render_defaults {
+    constexpr char const*   centre_x   = "-0.5";   // centre of the image, exact decimals
+    constexpr char const*   centre_y   = "0";
+    constexpr char const*   width_zoom = "3";      // width of the image in the complex plane
+    constexpr int           width      = 1920;
+    constexpr int           height     = 1080;
+    constexpr int           iterations = cpu_engine::MAX_ITERATIONS;
+    constexpr float         palette_period = 64.0f; // iterations per palette revolution, same as the viewer
+    constexpr int           tile_size  = 256;      // edge of the square tiles the image is rendered in
+    constexpr int           fps        = 60;       // frames per second of a zoom video
+};
+
+static void usage(const char* program)
+{
+    std::cout << "usage: " << program << " [options] <output.png|.ppm|.pfm>\n"
+        << "       " << program << " [options] --gigapixel <file.mbi> [output]\n"
+        << "       " << program << " [--palette <name>] [--period <n>] --recolour <file.mbi> <output>\n"
+        << "       " << program << " [options] --pyramid dzi <name.dzi>\n"
+        << "       " << program << " [options] --levels <n> --pyramid xyz <directory>\n"
+        << "       " << program << " [options] --keyframe <s> <w> --keyframe <s> <w> ... <output.y4m|->\n"
+        << "       " << program << " [options] --depth <w> --expmap <file.mbi>\n"
+        << "       " << program << " [options] --from-expmap <file.mbi> [--keyframe <s> <w> ...] <output>\n"
+        << "       " << program << " [--threads <n>] --worker <[address:]port>\n"
+        << "  --centre <re> <im>   centre of the image as exact decimals, default "
+            << render_defaults::centre_x << " " << render_defaults::centre_y << "\n"
+        << "  --zoom <width>       width of the image in the complex plane as an exact decimal, default "
+            << render_defaults::width_zoom << "\n"
+        << "  --size <W>x<H>       image size in pixels, default "
+            << render_defaults::width << "x" << render_defaults::height << "\n"
+        << "  --iterations <n>     iteration cap, default " << render_defaults::iterations << "\n"
+        << "  --engine <name>      gpu: GLSL through a headless EGL context, cpu: doubles on every core,\n"
+        << "                       perturbation: every core against one reference orbit, for deep views, default gpu\n"
+        << "  --palette <name>     built in palette or palette file, see load_palette\n"
+        << "  --period <n>         iterations per palette revolution, default "
+            << render_defaults::palette_period << "\n"
+        << "  --gigapixel <file>   keeps the iteration values in a memory-mapped file, resumes it when it exists\n"
+        << "  --recolour <file>    colours the iteration values of a gigapixel render again without recomputing\n"
+        << "  --pyramid <layout>   tile pyramid for deep zoom viewers, always on every core with perturbation,\n"
+        << "                       dzi renders --size at the finest level,\n"
+        << "                       xyz renders --levels below a single tile spanning --zoom\n"
+        << "  --levels <n>         deepest level of an xyz pyramid\n"
+        << "  --keyframe <s> <w>   the view is w wide s seconds into a zoom video, two or more make a Y4M video,\n"
+        << "                       - as output streams it to stdout, always on every core with perturbation\n"
+        << "  --fps <n>            frames per second of a zoom video, default " << render_defaults::fps << "\n"
+        << "  --expmap <file>      log-polar strip from --zoom down to --depth, for frames of --size, resumes it\n"
+        << "  --depth <w>          width of the deepest view an exponential map serves\n"
+        << "  --from-expmap <file> resamples the --keyframe video, or one image --zoom wide, from the strip\n"
+        << "  --coordinator <a:p>  renders the image, gigapixel file or video with perturbation on the workers which\n"
+        << "                       connect to address:port, 127.0.0.1 unless given\n"
+        << "  --worker <a:p>       renders for the coordinator at address:port, job after job, until stopped\n"
+        << "  --threads <n>        threads of a worker or the perturbation engine, default one per core\n"
+        << "  --cache-mb <n>       disk space kept for the iteration values of images rendered before, which load\n"
+        << "                       instead of rendering again, 0 turns it off, default "
+            << (iteration_cache_t::DEFAULT_MAX_BYTES >> 20)
+        << std::endl;
+}
+
+// copies the rows of a tile which lie inside the image into a band, coloured when the writer takes rgb
+static void fill_band(image_band_t& band, int width, int tile, int tile_x, const float* values,
+    const palette_t& palette, float palette_period)
+{
+    const int columns = std::min(tile, width - tile_x * tile);
+    for (int row = 0; row < band.rows; row++) {
+        const float* source = values + (size_t)row * tile;
+        const size_t target = (size_t)row * width + (size_t)tile_x * tile;
+        if (band.rgb.empty())
+            std::copy(source, source + columns, &band.iterations[target]);
+        else
+            colour_iterations(palette, palette_period, source, 1, columns, &band.rgb[3 * target]);
+    }
+}
+
+static image_band_t make_band(pixel_format_t format, int width, int rows)
+{
+    image_band_t band;
+    band.rows = rows;
+    if (format == pixel_format_t::RGB8)
+        band.rgb.resize(3 * (size_t)width * rows);
+    else
+        band.iterations.resize((size_t)width * rows);
+    return band;
+}
+
+// colours a gigapixel render a row of tiles at a time, the pages of every row are dropped once it was read
+static bool colour_file(iteration_file_t& file, const std::string& output, const palette_t& palette,
+    float palette_period)
+{
+    const int width = (int)file.header().width, height = (int)file.header().height;
+    const int tile = (int)file.header().tile_size;
+    std::unique_ptr<image_writer_t> writer = image_writer_t::open(output, width, height);
+    if (!writer)
+        return false;
+    for (int tile_y = 0; tile_y < file.tiles_y(); tile_y++) {
+        image_band_t band = make_band(writer->format(), width, std::min(tile, height - tile_y * tile));
+        for (int tile_x = 0; tile_x < file.tiles_x(); tile_x++) {
+            if (!file.complete(tile_x, tile_y)) {
+                std::cout << "[RENDER] [ERR]: \"Tile " << tile_x << ", " << tile_y << " was never rendered, run the "
+                    "render with --gigapixel again to finish it\"" << std::endl;
+                writer->close();
+                return false;
+            }
+            fill_band(band, width, tile, tile_x, file.tile(tile_x, tile_y), palette, palette_period);
+        }
+        file.release_row(tile_y);
+        if (!writer->write(std::move(band)))
+            break;
+    }
+    return writer->close();
+}
+
+// renders tiles of a view in the order given and hands each to done as iteration values in rows top down, on the
+// workers of a coordinator when there is one, which always have QUEUED_BLOCKS tiles queued ahead
+static bool render_tiles(tile_renderer_t& renderer, coordinator_t* coordinator, const arb_prec_t& centre_x,
+    const arb_prec_t& centre_y, const arb_prec_t& pixel, int width, int height, int tile,
+    const std::vector<std::pair<int, int>>& tiles, const std::function<bool(int, int, const float*)>& done)
+{
+    if (!coordinator) {
+        std::vector<float> values((size_t)tile * tile);
+        for (const auto& [tile_x, tile_y] : tiles)
+            if (!renderer.render_view_tile(centre_x, centre_y, pixel, width, height, tile, tile_x, tile_y,
+                values.data()) || !done(tile_x, tile_y, values.data()))
+                return false;
+        return true;
+    }
+
+    const double reach = 0.5 * pixel.to_double() * std::hypot((double)width, (double)height);
+    std::deque<std::future<std::vector<float>>> pending;
+    size_t queued = 0;
+    for (const auto& [tile_x, tile_y] : tiles) {
+        for (; queued < tiles.size() && pending.size() < coordinator_t::QUEUED_BLOCKS; queued++)
+            pending.push_back(coordinator->submit(coordinator->view_tile(centre_x, centre_y, pixel, width, height,
+                tile, tiles[queued].first, tiles[queued].second, reach)));
+        std::vector<float> values = pending.front().get();
+        pending.pop_front();
+        if (values.empty() || !done(tile_x, tile_y, values.data()))
+            return false;
+    }
+    return true;
+}
+
+// opens the iteration file of an earlier run of the same view, or creates it
+static std::unique_ptr<iteration_file_t> open_gigapixel(const std::string& path, int width, int height, int tile,
+    int iterations, const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+    iteration_file_t::projection_t projection = iteration_file_t::projection_t::PLANE)
+{
+    if (!std::filesystem::exists(path))
+        return iteration_file_t::create(path, width, height, tile, iterations, centre_x, centre_y, pixel, projection);
+
+    std::unique_ptr<iteration_file_t> file = iteration_file_t::open(path);
+    if (!file)
+        return nullptr;
+    const iteration_file_t::header_t& header = file->header();
+    if ((int)header.width != width || (int)header.height != height || (int)header.tile_size != tile ||
+        (int)header.max_iterations != iterations || !(file->centre_x() == centre_x) ||
+        !(file->centre_y() == centre_y) || !(file->pixel() == pixel) || header.projection != projection) {
+        std::cout << "[RENDER] [ERR]: \"" << path << " holds another view, remove it or pick another name\""
+            << std::endl;
+        return nullptr;
+    }
+    int done = 0;
+    for (int tile_y = 0; tile_y < file->tiles_y(); tile_y++)
+        for (int tile_x = 0; tile_x < file->tiles_x(); tile_x++)
+            done += file->complete(tile_x, tile_y);
+    std::cout << "[RENDER] resuming " << path << ", " << done << " of " << file->tiles_x() * file->tiles_y()
+        << " tiles done" << std::endl;
+    return file;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string centre_x_text = render_defaults::centre_x, centre_y_text = render_defaults::centre_y;
+    std::string zoom_text = render_defaults::width_zoom;
+    int width = render_defaults::width, height = render_defaults::height;
+    int iterations = render_defaults::iterations;
+    float palette_period = render_defaults::palette_period;
+    std::string engine = "gpu", palette_name, output, gigapixel, recolour, pyramid_layout;
+    int pyramid_levels = -1;
+    int fps = render_defaults::fps;
+    std::vector<std::pair<double, std::string>> keyframe_texts;
+    std::string expmap, from_expmap, depth_text;
+    std::string coordinator_endpoint, worker_endpoint;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    long long cache_mb = (long long)(iteration_cache_t::DEFAULT_MAX_BYTES >> 20);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--centre" && i + 2 < argc) {
+            centre_x_text = argv[++i];
+            centre_y_text = argv[++i];
+        } else if (arg == "--zoom" && has_value) {
+            zoom_text = argv[++i];
+        } else if (arg == "--size" && has_value) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cout << "[RENDER] [ERR]: \"Size must look like 1920x1080\"" << std::endl;
+                return -1;
+            }
+        } else if (arg == "--iterations" && has_value) {
+            iterations = std::atoi(argv[++i]);
+        } else if (arg == "--engine" && has_value) {
+            engine = argv[++i];
+        } else if (arg == "--palette" && has_value) {
+            palette_name = argv[++i];
+        } else if (arg == "--period" && has_value) {
+            palette_period = (float)std::atof(argv[++i]);
+        } else if (arg == "--gigapixel" && has_value) {
+            gigapixel = argv[++i];
+        } else if (arg == "--recolour" && has_value) {
+            recolour = argv[++i];
+        } else if (arg == "--pyramid" && has_value) {
+            pyramid_layout = argv[++i];
+        } else if (arg == "--levels" && has_value) {
+            pyramid_levels = std::atoi(argv[++i]);
+        } else if (arg == "--keyframe" && i + 2 < argc) {
+            keyframe_texts.emplace_back(std::atof(argv[i + 1]), argv[i + 2]);
+            i += 2;
+        } else if (arg == "--fps" && has_value) {
+            fps = std::atoi(argv[++i]);
+        } else if (arg == "--expmap" && has_value) {
+            expmap = argv[++i];
+        } else if (arg == "--from-expmap" && has_value) {
+            from_expmap = argv[++i];
+        } else if (arg == "--depth" && has_value) {
+            depth_text = argv[++i];
+        } else if (arg == "--coordinator" && has_value) {
+            coordinator_endpoint = argv[++i];
+        } else if (arg == "--worker" && has_value) {
+            worker_endpoint = argv[++i];
+        } else if (arg == "--threads" && has_value) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--cache-mb" && has_value) {
+            cache_mb = std::atoll(argv[++i]);
+        } else if ((arg[0] != '-' || arg == "-") && output.empty()) {
+            output = arg;
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    std::string address;
+    int port = 0;
+    if (!worker_endpoint.empty()) {
+        if (!tcp::parse_endpoint(worker_endpoint, address, port) || threads <= 0) {
+            usage(argv[0]);
+            return -1;
+        }
+        run_worker(address, port, threads);
+        return 0;
+    }
+
+    bool has_target = !output.empty() || (!gigapixel.empty() && recolour.empty()) || !expmap.empty();
+    bool known_engine = engine == "gpu" || engine == "cpu" || engine == "perturbation";
+    bool known_pyramid = pyramid_layout.empty() || pyramid_layout == "dzi" ||
+        (pyramid_layout == "xyz" && pyramid_levels >= 0 && pyramid_levels <= 22);
+    if (!has_target || !known_engine || !known_pyramid || iterations <= 0 || palette_period <= 0.0f || fps <= 0 ||
+        cache_mb < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    palette_t palette = builtin_palettes().front();
+    if (!palette_name.empty()) {
+        bool found = false;
+        for (const palette_t& builtin : builtin_palettes())
+            if (builtin.name == palette_name) {
+                palette = builtin;
+                found = true;
+            }
+        if (!found && !load_palette(palette_name, palette))
+            return -1;
+    }
+
+    if (!recolour.empty()) {
+        std::unique_ptr<iteration_file_t> file = iteration_file_t::open(recolour);
+        return file && colour_file(*file, output, palette, palette_period) ? 0 : -1;
+    }
+
+    // workers may connect while the reference orbit is iterated, they get it once it is done
+    std::unique_ptr<coordinator_t> coordinator;
+    if (!coordinator_endpoint.empty()) {
+        if (!pyramid_layout.empty() || !expmap.empty() || !from_expmap.empty()) {
+            std::cout << "[RENDER] [ERR]: \"--coordinator renders images, gigapixel files and videos\"" << std::endl;
+            return -1;
+        }
+        if (!tcp::parse_endpoint(coordinator_endpoint, address, port)) {
+            usage(argv[0]);
+            return -1;
+        }
+        coordinator = std::make_unique<coordinator_t>();
+        if (!coordinator->listen(address, port))
+            return -1;
+        engine = "perturbation";
+    }
+
+    arb_prec_t centre_x, centre_y, zoom;
+    if (!arb_prec_t::parse(centre_x_text, centre_x) || !arb_prec_t::parse(centre_y_text, centre_y) ||
+        !arb_prec_t::parse(zoom_text, zoom)) {
+        std::cout << "[RENDER] [ERR]: \"Centre and zoom must be plain decimals such as -0.743643887\"" << std::endl;
+        return -1;
+    }
+
+    if (!pyramid_layout.empty()) {
+        pyramid_options_t options;
+        options.layout = pyramid_layout == "dzi" ? pyramid_options_t::layout_t::DZI : pyramid_options_t::layout_t::XYZ;
+        options.path = output;
+        options.centre_x = centre_x;
+        options.centre_y = centre_y;
+        options.extent = zoom;
+        options.width = width;
+        options.height = height;
+        options.levels = pyramid_levels;
+        options.tile_size = render_defaults::tile_size;
+        options.max_iterations = iterations;
+        options.palette = palette;
+        options.palette_period = palette_period;
+        return write_pyramid(options) ? 0 : -1;
+    }
+
+    // the strip reaches the corners of the widest frame and half a pixel of the deepest
+    const int tile = render_defaults::tile_size;
+    if (!expmap.empty()) {
+        arb_prec_t depth;
+        if (!arb_prec_t::parse(depth_text, depth) || depth.to_double() <= 0.0) {
+            std::cout << "[RENDER] [ERR]: \"An exponential map needs the --depth it dives to as a plain decimal\""
+                << std::endl;
+            return -1;
+        }
+        arb_prec_t outer = arb_prec_t(zoom) * (float)(0.5 * std::hypot((double)width, (double)height) / width);
+        int columns = exponential_map::columns(width, height, tile);
+        int rows = exponential_map::rows(columns, outer.to_double(), 0.5 * depth.to_double() / width);
+        if (rows < 2) {
+            std::cout << "[RENDER] [ERR]: \"--depth must be narrower than --zoom\"" << std::endl;
+            return -1;
+        }
+        double bits = tiered_program_t::required_bits(depth, width, width);
+        if (bits > reference_orbit_t::FRACTION_BITS)
+            std::cout << "[RENDER] [WARN]: \"The deepest view needs " << (int)bits << " fraction bits, the reference "
+                << "resolves " << reference_orbit_t::FRACTION_BITS << ", expect blocks\"" << std::endl;
+        std::unique_ptr<iteration_file_t> file = open_gigapixel(expmap, columns, rows, tile, iterations, centre_x,
+            centre_y, outer, iteration_file_t::projection_t::EXPONENTIAL);
+        if (!file || !exponential_map::render(*file))
+            return -1;
+        file->close();
+        return 0;
+    }
+
+    // frames and images from a strip are centred on its centre, whatever --centre said
+    std::unique_ptr<iteration_file_t> strip_file;
+    std::unique_ptr<exponential_map_t> strip;
+    if (!from_expmap.empty()) {
+        strip_file = iteration_file_t::open(from_expmap);
+        if (!strip_file)
+            return -1;
+        if (strip_file->header().projection != iteration_file_t::projection_t::EXPONENTIAL) {
+            std::cout << "[RENDER] [ERR]: \"" << from_expmap << " holds no exponential map\"" << std::endl;
+            return -1;
+        }
+        strip = std::make_unique<exponential_map_t>(*strip_file);
+        if (!strip->complete())
+            return -1;
+        centre_x = strip_file->centre_x();
+        centre_y = strip_file->centre_y();
+    }
+
+    if (strip && keyframe_texts.empty()) {
+        std::unique_ptr<image_writer_t> writer = image_writer_t::open(output, width, height);
+        if (!writer)
+            return -1;
+        std::vector<float> values((size_t)width * tile);
+        for (int first = 0; first < height; first += tile) {
+            // a band is one tile as wide as the image
+            image_band_t band = make_band(writer->format(), width, std::min(tile, height - first));
+            for (int row = 0; row < band.rows; row++)
+                strip->sample_row(zoom.to_double(), width, height, first + row, &values[(size_t)row * width]);
+            fill_band(band, width, width, 0, values.data(), palette, palette_period);
+            if (!writer->write(std::move(band)))
+                break;
+        }
+        return writer->close() ? 0 : -1;
+    }
+
+    if (!keyframe_texts.empty()) {
+        video_options_t options;
+        options.centre_x = centre_x;
+        options.centre_y = centre_y;
+        for (const auto& [time, width_text] : keyframe_texts) {
+            video_keyframe_t keyframe = {time, arb_prec_t()};
+            if (!arb_prec_t::parse(width_text, keyframe.width)) {
+                std::cout << "[RENDER] [ERR]: \"Keyframe widths must be plain decimals such as 0.000001\"" << std::endl;
+                return -1;
+            }
+            options.keyframes.push_back(keyframe);
+        }
+        options.width = width;
+        options.height = height;
+        options.fps = fps;
+        options.max_iterations = iterations;
+        options.palette = palette;
+        options.palette_period = palette_period;
+        options.exponential_map = strip.get();
+        options.coordinator = coordinator.get();
+        if (output != "-") {
+            std::ofstream file(output, std::ios::binary);
+            if (!file) {
+                std::cout << "[RENDER] [ERR]: \"Could not create " << output << "\"" << std::endl;
+                return -1;
+            }
+            return write_video(options, file) ? 0 : -1;
+        }
+        // the frames own stdout, every message goes to stderr instead
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        std::ostream frames(std::cout.rdbuf());
+        std::cout.rdbuf(std::cerr.rdbuf());
+        return write_video(options, frames) ? 0 : -1;
+    }
+
+    // the zoom spans the width, pixels are square so the height follows from it
+    arb_prec_t pixel = arb_prec_t(zoom).divide((unsigned int)width);
+    std::unique_ptr<iteration_file_t> file;
+    if (!gigapixel.empty()) {
+        file = open_gigapixel(gigapixel, width, height, tile, iterations, centre_x, centre_y, pixel);
+        if (!file)
+            return -1;
+    }
+
+    // the headless context has to outlive the renderer, whose destructor deletes its GL objects
+#ifdef MANDELBROT_EGL
+    std::unique_ptr<headless_context_t> context;
+#endif
+    std::unique_ptr<tile_renderer_t> renderer;
+    std::string engine_version = engine == "perturbation" ? perturbation_tile_renderer_t::engine() :
+        cpu_tile_renderer_t::engine();
+    if (engine == "gpu") {
+#ifdef MANDELBROT_EGL
+        context = std::make_unique<headless_context_t>();
+        if (context->valid()) {
+            GLADloadproc load = (GLADloadproc)headless_context_t::proc_address;
+            auto gpu = std::make_unique<gpu_tile_renderer_t>(iterations, load);
+            engine_version = gpu->engine();
+            renderer = std::move(gpu);
+        }
+#endif
+        if (!renderer) {
+            std::cout << "[RENDER] [WARN]: \"No headless GL context, rendering on the CPU\"" << std::endl;
+            engine = "cpu";
+        }
+    }
+
+    // an image of a view rendered before is written from the iteration cache, before any reference orbit is iterated,
+    // gigapixel files resume from themselves instead, values are kept one per pixel in rows top down
+    auto start = std::chrono::steady_clock::now();
+    iteration_cache_t iteration_cache(iteration_cache_t::default_directory(), (uint64_t)cache_mb << 20);
+    iteration_cache_t::view_t cached_view = {engine_version, centre_x, centre_y, pixel, width, height, iterations};
+    std::vector<float> image_values;
+    if (!file && iteration_cache.fits((size_t)width * height)) {
+        if (iteration_cache.load(cached_view, image_values)) {
+            std::unique_ptr<image_writer_t> writer = image_writer_t::open(output, width, height);
+            if (!writer)
+                return -1;
+            for (int first = 0; first < height; first += tile) {
+                image_band_t band = make_band(writer->format(), width, std::min(tile, height - first));
+                fill_band(band, width, width, 0, &image_values[(size_t)first * width], palette, palette_period);
+                if (!writer->write(std::move(band)))
+                    break;
+            }
+            if (!writer->close())
+                return -1;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "[RENDER] " << width << "x" << height << " loaded from the iteration cache in " << seconds
+                << " s" << std::endl;
+            return 0;
+        }
+        image_values.resize((size_t)width * height);
+    }
+
+    if (engine == "perturbation") {
+        // one orbit at the centre of the image serves every tile, dc reaches half the diagonal at most
+        double reach = 0.5 * pixel.to_double() * std::hypot((double)width, (double)height);
+        auto reference = std::make_shared<const reference_orbit_t>(centre_x, centre_y, iterations, reach);
+        renderer = std::make_unique<perturbation_tile_renderer_t>(reference, threads);
+        if (coordinator)
+            coordinator->start(reference);
+    }
+    if (!renderer)
+        renderer = std::make_unique<cpu_tile_renderer_t>(iterations);
+
+    double bits = tiered_program_t::required_bits(zoom, width, width);
+    if (bits > renderer->fraction_bits())
+        std::cout << "[RENDER] [WARN]: \"The view needs " << (int)bits << " fraction bits, the " << engine
+            << " engine resolves " << renderer->fraction_bits() << ", expect blocks\"" << std::endl;
+
+    std::cout << "[RENDER] " << width << "x" << height << " at " << centre_x_text << " " << centre_y_text << " width "
+        << zoom_text << ", " << iterations << " iterations on the " << (coordinator ? "workers" : engine) << std::endl;
+    start = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<int, int>> tiles;
+    for (int tile_y = 0; tile_y * tile < height; tile_y++)
+        for (int tile_x = 0; tile_x * tile < width; tile_x++)
+            if (!file || !file->complete(tile_x, tile_y))
+                tiles.emplace_back(tile_x, tile_y);
+    if (file) {
+        // tiles go into the mapping, the flush thread of the file writes them back while the next renders
+        bool rendered = render_tiles(*renderer, coordinator.get(), centre_x, centre_y, pixel, width, height, tile,
+            tiles, [&](int tile_x, int tile_y, const float* values) {
+                std::copy(values, values + (size_t)tile * tile, file->tile(tile_x, tile_y));
+                file->finish(tile_x, tile_y);
+                return true;
+            });
+        file->close();
+        if (!rendered)
+            return -1;
+    } else {
+        // tiles are rendered top down, left to right, one row of tiles is a band of the image writer, which encodes
+        // and writes it while the next one renders, edge tiles are cropped
+        std::unique_ptr<image_writer_t> writer = image_writer_t::open(output, width, height);
+        if (!writer)
+            return -1;
+        image_band_t band;
+        bool rendered = render_tiles(*renderer, coordinator.get(), centre_x, centre_y, pixel, width, height, tile,
+            tiles, [&](int tile_x, int tile_y, const float* values) {
+                if (tile_x == 0)
+                    band = make_band(writer->format(), width, std::min(tile, height - tile_y * tile));
+                fill_band(band, width, tile, tile_x, values, palette, palette_period);
+                if (!image_values.empty()) {
+                    const int columns = std::min(tile, width - tile_x * tile);
+                    for (int row = 0; row < band.rows; row++)
+                        std::copy(values + (size_t)row * tile, values + (size_t)row * tile + columns,
+                            &image_values[((size_t)tile_y * tile + row) * width + (size_t)tile_x * tile]);
+                }
+                return (tile_x + 1) * tile < width || writer->write(std::move(band));
+            });
+        if (!writer->close() || !rendered)
+            return -1;
+        if (!image_values.empty())
+            iteration_cache.store(cached_view, image_values);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[RENDER] rendered in " << seconds << " s" << std::endl;
+
+    // the finished file is reopened the way --recolour does
+    if (file && !output.empty()) {
+        file = iteration_file_t::open(gigapixel);
+        return file && colour_file(*file, output, palette, palette_period) ? 0 : -1;
+    }
+    return 0;
+}
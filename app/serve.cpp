@@ -0,0 +1,296 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "arb_prec.hpp"
+#include "palette.hpp"
+#include "tiered_program.hpp"
+#include "tile_renderer.hpp"
+#include "cpu_engine.hpp"
+#include "perturbation.hpp"
+#include "image_writer.hpp"
+#include "http_server.hpp"
+#include "render_cache.hpp"
+
+// mandelbrot-serve, renders tiles and images on request for viewers on the same machine, without a window
+namespace serve_defaults {
+    constexpr int           port       = 8080;
+    constexpr int           queue      = 64;        // connections waiting for a request or a thread, more get 503
+    constexpr int           cache_mb   = 256;       // encoded renders kept in memory
+    constexpr char const*   centre_x   = "-0.5";    // view the tiles are cut from, exact decimals
+    constexpr char const*   centre_y   = "0";
+    constexpr char const*   width_zoom = "3";
+    constexpr int           iterations = cpu_engine::MAX_ITERATIONS;
+    constexpr float         palette_period = 64.0f;
+    constexpr int           tile_size  = 256;       // edge of an xyz tile, and of the tiles an image is rendered in
+    constexpr int           max_level  = 22;        // deepest xyz level, like --levels of mandelbrot-render
+    constexpr int           max_size   = 4096;      // edge of the largest image
+    constexpr int           max_iterations = 1 << 20;
+};
+
+// everything a render depends on, parsed from the query
+struct view_request_t {
+    arb_prec_t centre_x, centre_y, zoom;
+    int iterations = serve_defaults::iterations;
+    const palette_t* palette = nullptr;
+    float palette_period = serve_defaults::palette_period;
+    std::string extension;      // ".png" or ".ppm"
+};
+
+static void usage(const char* program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+        << "  --port <n>       port on 127.0.0.1, default " << serve_defaults::port << "\n"
+        << "  --threads <n>    requests rendered at once, default one per core\n"
+        << "  --queue <n>      connections waiting for a request or a thread before new ones get 503, default "
+            << serve_defaults::queue << "\n"
+        << "  --cache-mb <n>   memory for rendered tiles and images, default " << serve_defaults::cache_mb << "\n"
+        << "GET /tile/<z>/<x>/<y>.png|.ppm     xyz tile, level 0 is one tile spanning the view\n"
+        << "GET /image.png|.ppm?size=<W>x<H>   image of the view\n"
+        << "GET /stats                         cache counters\n"
+        << "  query of both: re, im, width (exact decimals of the view centre and width, default "
+            << serve_defaults::centre_x << " " << serve_defaults::centre_y << " " << serve_defaults::width_zoom
+            << "),\n"
+        << "  iterations, palette (built in name), period" << std::endl;
+}
+
+static http_response_t error_response(int status, const std::string& message)
+{
+    http_response_t response;
+    response.status = status;
+    response.body = message + "\n";
+    return response;
+}
+
+static std::string query_value(const http_request_t& request, const char* name, const char* fallback)
+{
+    auto found = request.query.find(name);
+    return found == request.query.end() ? fallback : found->second;
+}
+
+// the view of a request, an error message when the query is malformed
+static bool parse_view(const http_request_t& request, view_request_t& view, std::string& error)
+{
+    if (!arb_prec_t::parse(query_value(request, "re", serve_defaults::centre_x), view.centre_x) ||
+        !arb_prec_t::parse(query_value(request, "im", serve_defaults::centre_y), view.centre_y) ||
+        !arb_prec_t::parse(query_value(request, "width", serve_defaults::width_zoom), view.zoom) ||
+        view.zoom.to_double() <= 0.0) {
+        error = "re, im and width must be plain decimals, width above 0";
+        return false;
+    }
+    view.iterations = std::atoi(query_value(request, "iterations", "0").c_str());
+    if (view.iterations == 0)
+        view.iterations = serve_defaults::iterations;
+    view.palette_period = (float)std::atof(query_value(request, "period", "0").c_str());
+    if (view.palette_period == 0.0f)
+        view.palette_period = serve_defaults::palette_period;
+    if (view.iterations < 0 || view.iterations > serve_defaults::max_iterations || view.palette_period < 0.0f) {
+        error = "iterations must lie in 1-" + std::to_string(serve_defaults::max_iterations) + ", period above 0";
+        return false;
+    }
+
+    // palette files are not read on behalf of a request
+    std::string name = query_value(request, "palette", builtin_palettes().front().name.c_str());
+    for (const palette_t& builtin : builtin_palettes())
+        if (builtin.name == name)
+            view.palette = &builtin;
+    if (!view.palette) {
+        error = "unknown palette " + name;
+        return false;
+    }
+    return true;
+}
+
+// identifies a render, exact decimals so every spelling of a coordinate gives the same key
+static std::string cache_key(const std::string& kind, const view_request_t& view)
+{
+    return kind + " " + view.centre_x.to_decimal() + " " + view.centre_y.to_decimal() + " " + view.zoom.to_decimal() +
+        " " + std::to_string(view.iterations) + " " + view.palette->name + " " + std::to_string(view.palette_period) +
+        " " + view.extension;
+}
+
+// doubles while they resolve the pixels, one reference orbit at the centre of the render below that
+static std::unique_ptr<tile_renderer_t> make_renderer(const view_request_t& view, const arb_prec_t& centre_x,
+    const arb_prec_t& centre_y, const arb_prec_t& pixel, int width, int height)
+{
+    arb_prec_t zoom = tile_renderer_t::tile_zoom(pixel, std::max(width, height));
+    if (tiered_program_t::required_bits(zoom, width, height) <= cpu_engine::FRACTION_BITS)
+        return std::make_unique<cpu_tile_renderer_t>(view.iterations);
+    double reach = 0.5 * pixel.to_double() * std::hypot((double)width, (double)height);
+    auto reference = std::make_shared<const reference_orbit_t>(centre_x, centre_y, view.iterations, reach);
+    return std::make_unique<perturbation_tile_renderer_t>(reference, 1);
+}
+
+// renders and encodes a width x height view, nullptr when the engine failed
+static render_cache_t::value_t render_view(const view_request_t& view, const arb_prec_t& centre_x,
+    const arb_prec_t& centre_y, const arb_prec_t& pixel, int width, int height)
+{
+    std::unique_ptr<tile_renderer_t> renderer = make_renderer(view, centre_x, centre_y, pixel, width, height);
+    const int tile = serve_defaults::tile_size;
+    image_band_t image;
+    image.rows = height;
+    image.rgb.resize(3 * (size_t)width * height);
+    std::vector<float> values((size_t)tile * tile);
+    for (int tile_y = 0; tile_y * tile < height; tile_y++)
+        for (int tile_x = 0; tile_x * tile < width; tile_x++) {
+            if (!renderer->render_view_tile(centre_x, centre_y, pixel, width, height, tile, tile_x, tile_y,
+                values.data()))
+                return nullptr;
+            const int rows = std::min(tile, height - tile_y * tile), columns = std::min(tile, width - tile_x * tile);
+            for (int row = 0; row < rows; row++)
+                colour_iterations(*view.palette, view.palette_period, &values[(size_t)row * tile], 1, columns,
+                    &image.rgb[3 * ((size_t)(tile_y * tile + row) * width + (size_t)tile_x * tile)]);
+        }
+    auto bytes = std::make_shared<std::string>();
+    if (!encode_image(view.extension, width, height, image, *bytes))
+        return nullptr;
+    return bytes;
+}
+
+// answers from the cache, rendering on a miss, the header tells viewers and load tests how it was answered
+static http_response_t cached_render(render_cache_t& cache, const std::string& key, const std::string& extension,
+    const std::function<render_cache_t::value_t(void)>& render)
+{
+    render_cache_t::source_t source;
+    render_cache_t::value_t bytes = cache.get(key, render, &source);
+    if (!bytes)
+        return error_response(500, "render failed");
+    http_response_t response;
+    response.content_type = extension == ".png" ? "image/png" : "image/x-portable-pixmap";
+    response.body = *bytes;
+    response.headers.emplace_back("X-Cache", source == render_cache_t::source_t::HIT ? "hit" :
+        source == render_cache_t::source_t::MISS ? "miss" : "coalesced");
+    response.headers.emplace_back("Cache-Control", "max-age=86400");
+    return response;
+}
+
+// splits "name.png" into the name and the extension, false for other formats
+static bool split_extension(const std::string& file, std::string& name, std::string& extension)
+{
+    if (file.size() < 4)
+        return false;
+    name = file.substr(0, file.size() - 4);
+    extension = file.substr(file.size() - 4);
+    return extension == ".png" || extension == ".ppm";
+}
+
+// /tile/z/x/y.png, the tiles of an xyz pyramid below one tile spanning the view, as write_pyramid cuts them
+static http_response_t serve_tile(render_cache_t& cache, const http_request_t& request)
+{
+    int level, column, row, consumed = 0;
+    char file[32] = {};
+    if (std::sscanf(request.path.c_str(), "/tile/%d/%d/%31s%n", &level, &column, file, &consumed) != 3 ||
+        consumed != (int)request.path.size())
+        return error_response(404, "tiles are /tile/<z>/<x>/<y>.png");
+    std::string row_text, extension;
+    if (!split_extension(file, row_text, extension))
+        return error_response(404, "tiles are .png or .ppm");
+    row = std::atoi(row_text.c_str());
+    if (level < 0 || level > serve_defaults::max_level || column < 0 || row < 0 || column >= (1 << level) ||
+        row >= (1 << level) || row_text.find_first_not_of("0123456789") != std::string::npos)
+        return error_response(404, "no such tile, levels go down to " + std::to_string(serve_defaults::max_level));
+
+    view_request_t view;
+    std::string error;
+    if (!parse_view(request, view, error))
+        return error_response(400, error);
+    view.extension = extension;
+
+    const int tile = serve_defaults::tile_size;
+    arb_prec_t pixel = arb_prec_t(view.zoom).divide((unsigned int)tile).divide(1u << level);
+    arb_prec_t half_zoom = arb_prec_t(view.zoom).divide(2);
+    arb_prec_t half_pixel = arb_prec_t(pixel).divide(2);
+    arb_prec_t corner_x = arb_prec_t(view.centre_x) - half_zoom, corner_y = arb_prec_t(view.centre_y) + half_zoom;
+    arb_prec_t x = corner_x + arb_prec_t(half_pixel).multiply((unsigned int)(2 * column * tile + tile));
+    arb_prec_t y = corner_y - arb_prec_t(half_pixel).multiply((unsigned int)(2 * row * tile + tile));
+
+    std::string key = cache_key("tile " + std::to_string(level) + " " + std::to_string(column) + " " +
+        std::to_string(row), view);
+    return cached_render(cache, key, extension, [&] { return render_view(view, x, y, pixel, tile, tile); });
+}
+
+// /image.png?size=WxH, the whole view in one image
+static http_response_t serve_image(render_cache_t& cache, const http_request_t& request, const std::string& extension)
+{
+    view_request_t view;
+    std::string error;
+    if (!parse_view(request, view, error))
+        return error_response(400, error);
+    view.extension = extension;
+    int width = 0, height = 0;
+    if (std::sscanf(query_value(request, "size", "1024x768").c_str(), "%dx%d", &width, &height) != 2 ||
+        width <= 0 || height <= 0 || width > serve_defaults::max_size || height > serve_defaults::max_size)
+        return error_response(400, "size must look like 1024x768, " + std::to_string(serve_defaults::max_size) +
+            " at most");
+
+    arb_prec_t pixel = arb_prec_t(view.zoom).divide((unsigned int)width);
+    std::string key = cache_key("image " + std::to_string(width) + "x" + std::to_string(height), view);
+    return cached_render(cache, key, extension,
+        [&] { return render_view(view, view.centre_x, view.centre_y, pixel, width, height); });
+}
+
+static http_response_t serve_stats(render_cache_t& cache)
+{
+    render_cache_t::stats_t stats = cache.stats();
+    http_response_t response;
+    response.body = "hits " + std::to_string(stats.hits) + "\nmisses " + std::to_string(stats.misses) +
+        "\ncoalesced " + std::to_string(stats.coalesced) + "\nevictions " + std::to_string(stats.evictions) +
+        "\nentries " + std::to_string(stats.entries) + "\nbytes " + std::to_string(stats.bytes) + "\n";
+    return response;
+}
+
+int main(int argc, char* argv[])
+{
+    int port = serve_defaults::port;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    int queue = serve_defaults::queue;
+    int cache_mb = serve_defaults::cache_mb;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--port" && has_value) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--queue" && has_value) {
+            queue = std::atoi(argv[++i]);
+        } else if (arg == "--cache-mb" && has_value) {
+            cache_mb = std::atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (port <= 0 || port > 65535 || threads <= 0 || queue <= 0 || cache_mb < 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    render_cache_t cache((size_t)cache_mb << 20);
+    auto handler = [&cache](const http_request_t& request) {
+        std::string name, extension;
+        if (request.path.compare(0, 6, "/tile/") == 0)
+            return serve_tile(cache, request);
+        if (split_extension(request.path, name, extension) && name == "/image")
+            return serve_image(cache, request, extension);
+        if (request.path == "/stats")
+            return serve_stats(cache);
+        return error_response(404, "try /tile/0/0/0.png, /image.png or /stats");
+    };
+
+    http_server_t server(handler, threads, (size_t)queue);
+    if (!server.listen(port))
+        return -1;
+    std::cout << "[HTTP] serving on http://127.0.0.1:" << port << " with " << threads << " threads, "
+        << cache_mb << " MB of cache" << std::endl;
+    server.run();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "compute_renderer.hpp"
+
+#include <algorithm>
+
+compute_renderer_t::compute_renderer_t(void) :
+    bound_program(0), uniforms(nullptr), chunk_active(false), chunk_tile{}, chunk_generation(0), chunk_program(0), chunk_start(0),
+    dispatched(0)
+{
+    statistics_t zero = {};
+    glGenBuffers(1, &statistics_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, statistics_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zero), &zero, GL_DYNAMIC_READ);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // one pixel per pixel of a tile, chunks never span more than one
+    const int size = frame_cache_t::TILE_SIZE;
+    glGenTextures(2, state_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, state_texture[0]);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA32UI, size, size, STATE_LAYERS, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glBindTexture(GL_TEXTURE_2D, state_texture[1]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, size, size, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+compute_renderer_t::~compute_renderer_t()
+{
+    glDeleteBuffers(1, &statistics_buffer);
+    glDeleteTextures(2, state_texture);
+}
+
+void compute_renderer_t::use(unsigned int program)
+{
+    glUseProgram(program);
+    if (bound_program == program)
+        return;
+
+    bound_program = program;
+    auto found = program_uniforms.find(program);
+    if (found == program_uniforms.end()) {
+        found = program_uniforms.emplace(program, GSV::compute_shader_uniforms_t()).first;
+        found->second.resolve(program);
+    }
+    uniforms = &found->second;
+}
+
+bool compute_renderer_t::render(unsigned int program, unsigned int iterations, const std::vector<rect_t>& tiles,
+    unsigned int generation, int iteration_chunk)
+{
+    dispatched = 0;
+    if (tiles.empty())
+        return true;
+
+    use(program);
+    glBindImageTexture(0, iterations, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+    glBindImageTexture(1, state_texture[0], 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA32UI); // every layer
+    glBindImageTexture(2, state_texture[1], 0, GL_FALSE, 0, GL_READ_WRITE, GL_R8UI);
+    glUniform1i(uniforms->u_iteration_image, 0);
+    glUniform1i(uniforms->u_state_image, 1);
+    glUniform1i(uniforms->u_done_image, 2);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STATISTICS_BINDING, statistics_buffer);
+
+    // a tile already started in chunks is finished in chunks, whatever the budget is now
+    const rect_t& first = tiles.front();
+    bool resume = chunk_active && chunk_generation == generation && chunk_program == program &&
+        first.x == chunk_tile.x && first.y == chunk_tile.y &&
+        first.width == chunk_tile.width && first.height == chunk_tile.height;
+    bool chunked = resume || (tiles.size() == 1 && iteration_chunk < view_state_t::MAX_ITERATIONS);
+
+    if (!chunked) {
+        chunk_active = false;
+        glUniform1i(uniforms->u_iteration_start, 0);
+        glUniform1i(uniforms->u_iteration_chunk, view_state_t::MAX_ITERATIONS);
+        dispatched = view_state_t::MAX_ITERATIONS;
+        for (const rect_t& tile : tiles) {
+            glUniform4i(uniforms->u_tile, tile.x, tile.y, tile.width, tile.height);
+            glDispatchCompute(
+                (tile.width  + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                (tile.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+        }
+    } else {
+        if (!resume) {
+            chunk_active = true;
+            chunk_tile = first;
+            chunk_generation = generation;
+            chunk_program = program;
+            chunk_start = 0;
+        }
+        int chunk = std::max(MIN_CHUNK, std::min(iteration_chunk, view_state_t::MAX_ITERATIONS - chunk_start));
+
+        glUniform1i(uniforms->u_iteration_start, chunk_start);
+        glUniform1i(uniforms->u_iteration_chunk, chunk);
+        glUniform4i(uniforms->u_tile, first.x, first.y, first.width, first.height);
+        glDispatchCompute(
+            (first.width  + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+            (first.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+
+        chunk_start += chunk;
+        dispatched = chunk;
+        chunk_active = chunk_start < view_state_t::MAX_ITERATIONS;
+    }
+
+    // the colour pass and histogram fetch the buffer, pans blit it, the next chunk loads the state images
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    return !chunk_active;
+}
+
+compute_renderer_t::statistics_t compute_renderer_t::take_statistics(void)
+{
+    statistics_t statistics, zero = {};
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, statistics_buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(statistics), &statistics);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return statistics;
+}
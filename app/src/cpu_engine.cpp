@@ -0,0 +1,65 @@
+#include "cpu_engine.hpp"
+
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+// inside the main cardioid or the period 2 bulb, which never escape, orbit_interior of mandelbrot.glsl
+static bool inside_main_bulbs(double c_r, double c_i)
+{
+    double x = c_r - 0.25;
+    double y_sqr = c_i * c_i;
+    double q = x * x + y_sqr;
+    double bulb_x = c_r + 1.0;
+    return q * (q + x) < 0.25 * y_sqr || bulb_x * bulb_x + y_sqr < 0.0625;
+}
+
+static void render_rows(double offset_x, double offset_y, double zoom, int width, int height, int max_iterations,
+    int first_row, int step, float* iterations)
+{
+    for (int y = first_row; y < height; y += step) {
+        for (int x = 0; x < width; x++) {
+            // c = (p / size - 0.5) * zoom - offset at the pixel centre, as gl_FragCoord gives it
+            double c_r = ((x + 0.5) / width  - 0.5) * zoom - offset_x;
+            double c_i = ((y + 0.5) / height - 0.5) * zoom - offset_y;
+            double z_r = 0.0, z_i = 0.0;
+
+            float* pixel = iterations + 2 * ((size_t)y * width + x);
+            pixel[0] = cpu_engine::INTERIOR;
+            pixel[1] = 0.0f;
+            if (inside_main_bulbs(c_r, c_i))
+                continue;
+            for (int n = 0; n < max_iterations; n++) {
+                double r_sqr = z_r * z_r + z_i * z_i;
+                if (r_sqr >= cpu_engine::BAILOUT_SQR) {
+                    // log-log smoothing, smooth_iteration of mandelbrot.glsl
+                    pixel[0] = (float)(n + 1.0 - std::log2(std::log(r_sqr) / std::log(cpu_engine::BAILOUT_SQR)));
+                    pixel[1] = (float)r_sqr;
+                    break;
+                }
+                double z_r_next = z_r * z_r - z_i * z_i + c_r;
+                z_i = 2.0 * z_r * z_i + c_i;
+                z_r = z_r_next;
+            }
+        }
+    }
+}
+
+std::vector<float> cpu_engine::render(const arb_prec_t& offset_x, const arb_prec_t& offset_y, const arb_prec_t& zoom,
+    int width, int height, int max_iterations)
+{
+    std::vector<float> iterations(2 * (size_t)width * height);
+
+    // interleaved rows, the interior is expensive and tends to sit in one band of the frame
+    int threads = (int)std::clamp(std::thread::hardware_concurrency(), 1u, (unsigned int)std::max(height, 1));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(render_rows, offset_x.to_double(), offset_y.to_double(), zoom.to_double(), width, height,
+            max_iterations, i, threads, iterations.data());
+    render_rows(offset_x.to_double(), offset_y.to_double(), zoom.to_double(), width, height, max_iterations, 0, threads,
+        iterations.data());
+    for (std::thread& worker : workers)
+        worker.join();
+
+    return iterations;
+}
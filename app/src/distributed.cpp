@@ -0,0 +1,434 @@
+#include "distributed.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "tile_renderer.hpp"
+
+// messages are a header and size bytes of payload
+enum class message_t : uint32_t {
+    HELLO = 1,      // worker: hello_t
+    REFERENCE = 2,  // coordinator: limbs of the centre, max iterations, orbit values
+    BLOCK = 3,      // coordinator: id, distributed_block_t
+    RESULT = 4,     // worker: id, width * height iteration values
+    HEARTBEAT = 5,  // worker: nothing, it is alive
+};
+
+static constexpr uint32_t MAGIC = 0x4D424457;   // reads differently on a host of the other byte order
+static constexpr uint32_t VERSION = 1;
+static constexpr int MAX_BLOCK_PIXELS = 1 << 24;
+static constexpr int REFERENCE_LIMBS = 2 * (int)arb_prec_t::size();
+static constexpr int TABLES_KEPT = 4;           // BLA tables a worker keeps for the reaches of recent blocks
+
+struct message_header_t {
+    message_t type;
+    uint32_t size;
+};
+
+struct hello_t {
+    uint32_t magic, version;
+    int32_t threads;
+};
+
+struct block_message_t {
+    message_header_t header;
+    uint64_t id;
+    distributed_block_t block;
+};
+
+static bool send_header(tcp::socket_t socket, message_t type, size_t size)
+{
+    message_header_t header = {type, (uint32_t)size};
+    return tcp::send_all(socket, &header, sizeof(header));
+}
+
+coordinator_t::~coordinator_t()
+{
+    std::list<std::unique_ptr<worker_t>> remaining;
+    std::map<uint64_t, task_t> unfinished;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+        remaining.swap(workers);
+        unfinished.swap(tasks);
+    }
+    changed.notify_all();
+    if (listener >= 0) {
+        tcp::shutdown(listener);
+        tcp::close(listener);
+    }
+    if (acceptor.joinable())
+        acceptor.join();
+    for (std::unique_ptr<worker_t>& worker : remaining) {
+        tcp::shutdown(worker->socket);
+        worker->sender.join();
+        worker->receiver.join();
+        tcp::close(worker->socket);
+    }
+    for (auto& [id, task] : unfinished)
+        task.result.set_value({});
+}
+
+bool coordinator_t::listen(const std::string& address, int port)
+{
+    listener = tcp::listen(address, port);
+    if (listener < 0) {
+        std::cout << "[DIST] [ERR]: \"Could not listen on " << address << ":" << port << "\"" << std::endl;
+        return false;
+    }
+    std::cout << "[DIST] waiting for workers on " << address << ":" << port << std::endl;
+    acceptor = std::thread(&coordinator_t::accept_workers, this);
+    return true;
+}
+
+void coordinator_t::start(std::shared_ptr<const reference_orbit_t> reference)
+{
+    // limbs of the centre, the iteration cap and the orbit, which every worker gets before its first block
+    const std::vector<double>& values = reference->values();
+    const size_t size = REFERENCE_LIMBS * sizeof(uint32_t) + sizeof(int32_t) + values.size() * sizeof(double);
+    std::vector<char> message(sizeof(message_header_t) + size);
+    message_header_t header = {message_t::REFERENCE, (uint32_t)size};
+    int32_t iterations = reference->iterations();
+    char* out = message.data();
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    std::memcpy(out, reference->x().buffer(), arb_prec_t::size() * sizeof(uint32_t));
+    out += arb_prec_t::size() * sizeof(uint32_t);
+    std::memcpy(out, reference->y().buffer(), arb_prec_t::size() * sizeof(uint32_t));
+    out += arb_prec_t::size() * sizeof(uint32_t);
+    std::memcpy(out, &iterations, sizeof(iterations));
+    out += sizeof(iterations);
+    std::memcpy(out, values.data(), values.size() * sizeof(double));
+
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        this->reference = std::move(reference);
+        reference_message = std::move(message);
+    }
+    changed.notify_all();
+}
+
+std::future<std::vector<float>> coordinator_t::submit(const distributed_block_t& block)
+{
+    std::future<std::vector<float>> result;
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        uint64_t id = next_task++;
+        task_t& task = tasks[id];
+        task.block = block;
+        result = task.result.get_future();
+        queue.push_back(id);
+    }
+    changed.notify_all();
+    return result;
+}
+
+distributed_block_t coordinator_t::view_tile(const arb_prec_t& centre_x, const arb_prec_t& centre_y,
+    const arb_prec_t& pixel, int width, int height, int tile, int tile_x, int tile_y, double reach) const
+{
+    // the tile centre is taken off the reference exactly, like perturbation_tile_renderer_t does
+    arb_prec_t x, y;
+    tile_renderer_t::view_tile_centre(centre_x, centre_y, pixel, width, height, tile, tile_x, tile_y, x, y);
+    return {(x - reference->x()).to_double(), (y - reference->y()).to_double(), pixel.to_double(), tile, tile, reach};
+}
+
+void coordinator_t::accept_workers(void)
+{
+    for (;;) {
+        tcp::socket_t socket = tcp::accept(listener);
+        if (socket < 0)
+            return;
+        tcp::set_no_delay(socket);
+        tcp::set_timeout(socket, TIMEOUT_MS);
+        message_header_t header;
+        hello_t hello;
+        if (!tcp::receive_all(socket, &header, sizeof(header)) || header.type != message_t::HELLO ||
+            header.size != sizeof(hello) || !tcp::receive_all(socket, &hello, sizeof(hello)) ||
+            hello.magic != MAGIC || hello.version != VERSION || hello.threads <= 0) {
+            std::cout << "[DIST] [WARN]: \"Turned away a worker of another version or byte order\"" << std::endl;
+            tcp::close(socket);
+            continue;
+        }
+
+        // dropped workers are reaped as new ones join, their threads have ended or are about to
+        std::list<std::unique_ptr<worker_t>> reaped;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopping) {
+            tcp::close(socket);
+            return;
+        }
+        for (auto it = workers.begin(); it != workers.end();) {
+            auto next = std::next(it);
+            if ((*it)->dropped)
+                reaped.splice(reaped.end(), workers, it);
+            it = next;
+        }
+        auto worker = std::make_unique<worker_t>();
+        worker->id = next_worker++;
+        worker->socket = socket;
+        worker->threads = hello.threads;
+        worker->sender = std::thread(&coordinator_t::send_blocks, this, std::ref(*worker));
+        worker->receiver = std::thread(&coordinator_t::receive_results, this, std::ref(*worker));
+        std::cout << "[DIST] worker " << worker->id << " joined with " << worker->threads << " threads" << std::endl;
+        workers.push_back(std::move(worker));
+        lock.unlock();
+
+        for (std::unique_ptr<worker_t>& dropped : reaped) {
+            dropped->sender.join();
+            dropped->receiver.join();
+            tcp::close(dropped->socket);
+        }
+    }
+}
+
+void coordinator_t::send_blocks(worker_t& worker)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return reference || worker.dropped || stopping; });
+    if (worker.dropped || stopping)
+        return;
+    // the message does not change once the job started
+    const std::vector<char>& orbit = reference_message;
+    lock.unlock();
+    if (!tcp::send_all(worker.socket, orbit.data(), orbit.size())) {
+        drop(worker, "did not take the reference orbit");
+        return;
+    }
+
+    // a worker holds a block per thread, the next one goes out as soon as a result came back
+    for (;;) {
+        lock.lock();
+        changed.wait(lock, [&] {
+            return (!queue.empty() && (int)worker.in_flight.size() < worker.threads) || worker.dropped || stopping;
+        });
+        if (worker.dropped || stopping)
+            return;
+        block_message_t message;
+        message.header = {message_t::BLOCK, (uint32_t)(sizeof(message) - sizeof(message.header))};
+        message.id = queue.front();
+        message.block = tasks[message.id].block;
+        queue.pop_front();
+        worker.in_flight.insert(message.id);
+        lock.unlock();
+        if (!tcp::send_all(worker.socket, &message, sizeof(message))) {
+            drop(worker, "closed its connection");
+            return;
+        }
+    }
+}
+
+void coordinator_t::receive_results(worker_t& worker)
+{
+    for (;;) {
+        // heartbeats come every HEARTBEAT_MS, a receive timing out after TIMEOUT_MS means the worker hangs or is gone
+        message_header_t header;
+        if (!tcp::receive_all(worker.socket, &header, sizeof(header))) {
+            drop(worker, "closed its connection or went silent");
+            return;
+        }
+        if (header.type == message_t::HEARTBEAT && header.size == 0)
+            continue;
+
+        uint64_t id;
+        if (header.type != message_t::RESULT || header.size < sizeof(id) ||
+            !tcp::receive_all(worker.socket, &id, sizeof(id))) {
+            drop(worker, "sent a malformed message");
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        auto task = tasks.find(id);
+        size_t expected = 0;
+        if (worker.in_flight.count(id) && task != tasks.end())
+            expected = (size_t)task->second.block.width * task->second.block.height;
+        lock.unlock();
+        std::vector<float> values(expected);
+        if (expected == 0 || header.size != sizeof(id) + expected * sizeof(float) ||
+            !tcp::receive_all(worker.socket, values.data(), expected * sizeof(float))) {
+            drop(worker, "sent a result it was not asked for");
+            return;
+        }
+
+        lock.lock();
+        task = tasks.find(id);
+        if (task == tasks.end())
+            return; // stopping, the coordinator answered every task already
+        worker.in_flight.erase(id);
+        std::promise<std::vector<float>> result = std::move(task->second.result);
+        tasks.erase(task);
+        lock.unlock();
+        changed.notify_all();
+        result.set_value(std::move(values));
+    }
+}
+
+void coordinator_t::drop(worker_t& worker, const char* reason)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (worker.dropped)
+        return;
+    worker.dropped = true;
+    // its blocks go first, the caller is most likely waiting for them
+    size_t requeued = worker.in_flight.size();
+    for (auto it = worker.in_flight.rbegin(); it != worker.in_flight.rend(); ++it)
+        queue.push_front(*it);
+    worker.in_flight.clear();
+    bool quiet = stopping;
+    lock.unlock();
+    tcp::shutdown(worker.socket);
+    changed.notify_all();
+    if (!quiet)
+        std::cout << "[DIST] [WARN]: \"Worker " << worker.id << " " << reason << ", its " << requeued
+            << " blocks go to the others\"" << std::endl;
+}
+
+// the blocks of one job, until the coordinator closes the connection
+static size_t work_job(tcp::socket_t socket, int threads)
+{
+    hello_t hello = {MAGIC, VERSION, threads};
+    message_header_t header;
+    if (!send_header(socket, message_t::HELLO, sizeof(hello)) || !tcp::send_all(socket, &hello, sizeof(hello)) ||
+        !tcp::receive_all(socket, &header, sizeof(header)))
+        return 0;
+    const size_t fixed = REFERENCE_LIMBS * sizeof(uint32_t) + sizeof(int32_t);
+    if (header.type != message_t::REFERENCE || header.size < fixed + 2 * sizeof(double) ||
+        (header.size - fixed) % (2 * sizeof(double)) != 0) {
+        std::cout << "[DIST] [ERR]: \"The coordinator sent no reference orbit\"" << std::endl;
+        return 0;
+    }
+    arb_prec_t centre_x, centre_y;
+    int32_t iterations;
+    std::vector<double> values((header.size - fixed) / sizeof(double));
+    if (!tcp::receive_all(socket, centre_x.buffer(), arb_prec_t::size() * sizeof(uint32_t)) ||
+        !tcp::receive_all(socket, centre_y.buffer(), arb_prec_t::size() * sizeof(uint32_t)) ||
+        !tcp::receive_all(socket, &iterations, sizeof(iterations)) ||
+        !tcp::receive_all(socket, values.data(), values.size() * sizeof(double)))
+        return 0;
+    std::cout << "[DIST] reference orbit of " << values.size() / 2 - 1 << " iterations received" << std::endl;
+
+    // the orbit is kept once, every table is built on it for the reach of the blocks, it iterates nothing itself
+    auto orbit = std::make_shared<const reference_orbit_t>(centre_x, centre_y, iterations, std::move(values), 0.0);
+    std::map<double, std::shared_ptr<const reference_orbit_t>> tables;
+    std::deque<double> table_order;
+
+    std::mutex mutex, send_mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<uint64_t, distributed_block_t>> blocks;
+    bool closed = false;
+    size_t rendered = 0;
+
+    auto table_for = [&](double reach) {
+        std::lock_guard<std::mutex> guard(mutex);
+        std::shared_ptr<const reference_orbit_t>& table = tables[reach];
+        if (!table) {
+            table = orbit->with_reach(reach);
+            table_order.push_back(reach);
+            if (table_order.size() > TABLES_KEPT) {
+                tables.erase(table_order.front());
+                table_order.pop_front();
+            }
+        }
+        return tables[reach];
+    };
+    auto render = [&]() {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return !blocks.empty() || closed; });
+            if (closed)
+                return;
+            auto [id, block] = blocks.front();
+            blocks.pop_front();
+            lock.unlock();
+
+            // rows top down, like render_view_tile hands them on
+            std::shared_ptr<const reference_orbit_t> table = table_for(block.reach);
+            std::vector<float> values((size_t)block.width * block.height);
+            float pixel[2];
+            for (int row = 0; row < block.height; row++) {
+                double dc_i = block.centre_i + (0.5 * block.height - row - 0.5) * block.spacing;
+                for (int column = 0; column < block.width; column++) {
+                    table->iterate(block.centre_r + (column + 0.5 - 0.5 * block.width) * block.spacing, dc_i, pixel);
+                    values[(size_t)row * block.width + column] = pixel[0];
+                }
+            }
+
+            std::lock_guard<std::mutex> guard(send_mutex);
+            bool sent = send_header(socket, message_t::RESULT, sizeof(id) + values.size() * sizeof(float)) &&
+                tcp::send_all(socket, &id, sizeof(id)) &&
+                tcp::send_all(socket, values.data(), values.size() * sizeof(float));
+            lock.lock();
+            closed = closed || !sent;
+            rendered += sent;
+        }
+    };
+    auto heartbeat = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        const auto period = std::chrono::milliseconds(coordinator_t::HEARTBEAT_MS);
+        while (!changed.wait_for(lock, period, [&] { return closed; })) {
+            lock.unlock();
+            std::lock_guard<std::mutex> guard(send_mutex);
+            bool sent = send_header(socket, message_t::HEARTBEAT, 0);
+            lock.lock();
+            closed = closed || !sent;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(render);
+    workers.emplace_back(heartbeat);
+    for (;;) {
+        block_message_t message;
+        if (!tcp::receive_all(socket, &message.header, sizeof(message.header)))
+            break;
+        if (message.header.type != message_t::BLOCK ||
+            message.header.size != sizeof(message) - sizeof(message.header) ||
+            !tcp::receive_all(socket, &message.id, message.header.size))
+            break;
+        const distributed_block_t& block = message.block;
+        if (block.width <= 0 || block.height <= 0 || block.width > MAX_BLOCK_PIXELS / block.height) {
+            std::cout << "[DIST] [ERR]: \"The coordinator sent a block of " << block.width << "x" << block.height
+                << " pixels\"" << std::endl;
+            break;
+        }
+        std::lock_guard<std::mutex> guard(mutex);
+        if (closed)
+            break;
+        blocks.emplace_back(message.id, block);
+        changed.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        closed = true;
+    }
+    changed.notify_all();
+    tcp::shutdown(socket);
+    for (std::thread& worker : workers)
+        worker.join();
+    return rendered;
+}
+
+void run_worker(const std::string& address, int port, int threads)
+{
+    bool waiting = false;
+    for (;;) {
+        tcp::socket_t socket = tcp::connect(address, port);
+        if (socket < 0) {
+            if (!waiting)
+                std::cout << "[DIST] waiting for a coordinator on " << address << ":" << port << std::endl;
+            waiting = true;
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        waiting = false;
+        tcp::set_no_delay(socket);
+        std::cout << "[DIST] joined the coordinator on " << address << ":" << port << " with " << threads
+            << " threads" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        size_t rendered = work_job(socket, threads);
+        tcp::close(socket);
+        std::cout << "[DIST] job over, " << rendered << " blocks in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    }
+}
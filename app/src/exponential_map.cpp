@@ -0,0 +1,145 @@
+#include "exponential_map.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+#include "perturbation.hpp"
+
+int exponential_map::columns(int width, int height, int tile_size)
+{
+    // the corners of a frame lie half its diagonal out, pi * diagonal columns space them a frame pixel apart
+    int columns = (int)std::ceil(std::numbers::pi * std::hypot((double)width, (double)height));
+    return (columns + tile_size - 1) / tile_size * tile_size;
+}
+
+int exponential_map::rows(int columns, double outer, double inner)
+{
+    return (int)std::ceil(std::log(outer / inner) * columns / (2.0 * std::numbers::pi));
+}
+
+bool exponential_map::render(iteration_file_t& file)
+{
+    const iteration_file_t::header_t& header = file.header();
+    if (header.projection != iteration_file_t::projection_t::EXPONENTIAL || header.height < 2) {
+        std::cout << "[EXPMAP] [ERR]: \"The iteration file holds no exponential map\"" << std::endl;
+        return false;
+    }
+    const int columns = (int)header.width, rows = (int)header.height, tile = (int)header.tile_size;
+    const double outer = file.pixel().to_double();
+    const double step = 2.0 * std::numbers::pi / columns;   // radians per column, ln radius per row
+
+    auto start = std::chrono::steady_clock::now();
+    auto reference = std::make_shared<const reference_orbit_t>(file.centre_x(), file.centre_y(),
+        (int)header.max_iterations, outer);
+    std::cout << "[EXPMAP] " << columns << "x" << rows << " strip, reference orbit of " << reference->length()
+        << " iterations in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+        << " s" << std::endl;
+
+    // a row of tiles at a time, its BLA table only has to reach the outer edge of the row
+    const int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int tile_y = 0; tile_y < file.tiles_y(); tile_y++) {
+        std::shared_ptr<const reference_orbit_t> table;
+        std::atomic<int> next{0};
+        auto work = [&]() {
+            for (int tile_x = next++; tile_x < file.tiles_x(); tile_x = next++) {
+                if (file.complete(tile_x, tile_y))
+                    continue; // finished before the render resumed
+                float* values = file.tile(tile_x, tile_y);
+                for (int y = 0; y < tile; y++) {
+                    int row = tile_y * tile + y;
+                    double radius = outer * std::exp(-(row + 0.5) * step);
+                    for (int x = 0; x < tile; x++) {
+                        double angle = (tile_x * tile + x + 0.5) * step;
+                        float pixel[2];
+                        table->iterate(radius * std::cos(angle), radius * std::sin(angle), pixel);
+                        values[(size_t)y * tile + x] = pixel[0];
+                    }
+                }
+                file.finish(tile_x, tile_y);
+            }
+        };
+
+        bool missing = false;
+        for (int tile_x = 0; tile_x < file.tiles_x(); tile_x++)
+            missing = missing || !file.complete(tile_x, tile_y);
+        if (!missing)
+            continue;
+        table = reference->with_reach(outer * std::exp(-tile_y * tile * step));
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(work);
+        work();
+        for (std::thread& worker : workers)
+            worker.join();
+        if (tile_y % 16 == 15 || tile_y + 1 == file.tiles_y())
+            std::cout << "[EXPMAP] " << std::min(rows, (tile_y + 1) * tile) << " of " << rows << " rows, "
+                << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s"
+                << std::endl;
+    }
+    return true;
+}
+
+exponential_map_t::exponential_map_t(iteration_file_t& file) :
+    file(file), columns((int)file.header().width), rows((int)file.header().height),
+    tile_size((int)file.header().tile_size)
+{
+    outer_log = std::log(file.pixel().to_double());
+    rows_per_log = columns / (2.0 * std::numbers::pi);
+}
+
+bool exponential_map_t::complete(void) const
+{
+    for (int tile_y = 0; tile_y < file.tiles_y(); tile_y++)
+        for (int tile_x = 0; tile_x < file.tiles_x(); tile_x++)
+            if (!file.complete(tile_x, tile_y)) {
+                std::cout << "[EXPMAP] [ERR]: \"Tile " << tile_x << ", " << tile_y << " of the strip was never "
+                    "rendered, run --expmap again to finish it\"" << std::endl;
+                return false;
+            }
+    return true;
+}
+
+double exponential_map_t::inner_width(int width) const
+{
+    return width * std::exp(outer_log - rows / rows_per_log);
+}
+
+float exponential_map_t::value(int row, int column) const
+{
+    const float* tile = file.tile(column / tile_size, row / tile_size);
+    return tile[(size_t)(row % tile_size) * tile_size + column % tile_size];
+}
+
+void exponential_map_t::sample_row(double view_width, int width, int height, int row, float* values) const
+{
+    const double pixel = view_width / width;
+    const double y = (0.5 * height - row - 0.5) * pixel;
+    for (int x = 0; x < width; x++) {
+        double dx = (x + 0.5 - 0.5 * width) * pixel;
+
+        // strip coordinates relative to pixel centres, the angle wraps around, radii past either end clamp
+        double s = (outer_log - 0.5 * std::log(dx * dx + y * y)) * rows_per_log - 0.5;
+        double t = std::atan2(y, dx) * rows_per_log - 0.5;
+        s = std::clamp(s, 0.0, rows - 1.0);
+        if (t < 0.0)
+            t += columns;
+        int row_0 = std::min((int)s, rows - 2), column_0 = (int)t % columns;
+        int row_1 = row_0 + 1, column_1 = (column_0 + 1) % columns;
+        double fs = s - row_0, ft = t - std::floor(t);
+
+        // bilinear between escaped samples, the nearest one where the interior is involved so its edge stays sharp
+        float v00 = value(row_0, column_0), v01 = value(row_0, column_1);
+        float v10 = value(row_1, column_0), v11 = value(row_1, column_1);
+        if (v00 < 0.0f || v01 < 0.0f || v10 < 0.0f || v11 < 0.0f)
+            values[x] = fs < 0.5 ? (ft < 0.5 ? v00 : v01) : (ft < 0.5 ? v10 : v11);
+        else
+            values[x] = (float)((1.0 - fs) * ((1.0 - ft) * v00 + ft * v01) + fs * ((1.0 - ft) * v10 + ft * v11));
+    }
+}
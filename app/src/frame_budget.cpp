@@ -0,0 +1,71 @@
+#include "frame_budget.hpp"
+
+#include <algorithm>
+
+frame_budget_t::frame_budget_t(double target_ms, double initial_budget) :
+    work{}, in_flight{}, next(0), measuring(false),
+    target_ns(target_ms * 1e6), ns_per_unit(0.0), budget_units(initial_budget)
+{
+    glGenQueries(QUERIES, queries);
+}
+
+frame_budget_t::~frame_budget_t()
+{
+    glDeleteQueries(QUERIES, queries);
+}
+
+void frame_budget_t::collect(void)
+{
+    for (int i = 0; i < QUERIES; i++) {
+        if (!in_flight[i])
+            continue;
+
+        int available = 0;
+        glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed_ns);
+        in_flight[i] = false;
+        if (work[i] <= 0.0)
+            continue;
+
+        double measured = elapsed_ns / work[i];
+        ns_per_unit = ns_per_unit == 0.0 ? measured : ns_per_unit + SMOOTHING * (measured - ns_per_unit);
+        budget_units = std::min(target_ns / ns_per_unit, budget_units * MAX_GROWTH);
+    }
+}
+
+double frame_budget_t::budget(void)
+{
+    collect();
+    return budget_units;
+}
+
+void frame_budget_t::reset(double initial_budget)
+{
+    for (int i = 0; i < QUERIES; i++)
+        work[i] = 0.0;
+    ns_per_unit = 0.0;
+    budget_units = initial_budget;
+}
+
+void frame_budget_t::begin(void)
+{
+    // every query still in flight, this frame goes unmeasured rather than waiting
+    measuring = !in_flight[next];
+    if (measuring)
+        glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+}
+
+void frame_budget_t::end(double units)
+{
+    if (!measuring)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    work[next] = units;
+    in_flight[next] = true;
+    next = (next + 1) % QUERIES;
+    measuring = false;
+}
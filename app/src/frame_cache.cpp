@@ -0,0 +1,278 @@
+#include "frame_cache.hpp"
+
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+frame_cache_t::frame_cache_t(int width, int height, unsigned int resample_program, unsigned int quad_vao) :
+    front(0), width(width), height(height), valid(false), generation_nr(0), view_nr(0), whole(false),
+    resample_program(resample_program), quad_vao(quad_vao)
+{
+    glGenFramebuffers(2, fbo);
+    glGenTextures(2, texture);
+    allocate();
+
+    resample_uniforms.resolve(resample_program);
+}
+
+frame_cache_t::~frame_cache_t()
+{
+    glDeleteFramebuffers(2, fbo);
+    glDeleteTextures(2, texture);
+}
+
+void frame_cache_t::allocate(void)
+{
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, texture[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // interpolating iteration counts makes no sense
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "[GL] [ERR]: \"Frame cache framebuffer " << i << " is incomplete\"" << std::endl;
+
+        // UNKNOWN in colour_shader.frag, nothing has been computed yet
+        glClearColor(-2.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    generation_nr++;
+}
+
+void frame_cache_t::resize(int new_width, int new_height)
+{
+    width = new_width;
+    height = new_height;
+    valid = false;
+    queue.clear();
+    allocate();
+}
+
+void frame_cache_t::update(const arb_prec_t& new_offset_x, const arb_prec_t& new_offset_y, const arb_prec_t& new_zoom)
+{
+    if (!valid) {
+        offset_x = new_offset_x;
+        offset_y = new_offset_y;
+        zoom = new_zoom;
+        valid = true;
+        queue.clear();
+        enqueue({0, 0, width, height});
+        sort_queue();
+        view_nr++;
+        whole = true;
+        return;
+    }
+
+    if (zoom == new_zoom) {
+        // c = (p / size - 0.5) * zoom - offset, so pixel p of the new frame shows what pixel p + shift showed in the previous one
+        double shift_x = (arb_prec_t(offset_x) - new_offset_x).to_double() / zoom.to_double() * width;
+        double shift_y = (arb_prec_t(offset_y) - new_offset_y).to_double() / zoom.to_double() * height;
+        long dx = std::lround(shift_x);
+        long dy = std::lround(shift_y);
+
+        if (dx == 0 && dy == 0 && fabs(shift_x) <= MAX_SUBPIXEL_ERROR && fabs(shift_y) <= MAX_SUBPIXEL_ERROR)
+            return;
+
+        if (fabs(shift_x - dx) <= MAX_SUBPIXEL_ERROR && fabs(shift_y - dy) <= MAX_SUBPIXEL_ERROR &&
+            std::labs(dx) < width && std::labs(dy) < height) {
+            offset_x = new_offset_x;
+            offset_y = new_offset_y;
+            shift((int)dx, (int)dy);
+            sort_queue();
+            whole = false;
+            return;
+        }
+    }
+
+    // anything else starts over, with the previous frame scaled into place as a preview
+    resample(new_offset_x, new_offset_y, new_zoom);
+    offset_x = new_offset_x;
+    offset_y = new_offset_y;
+    zoom = new_zoom;
+
+    queue.clear();
+    enqueue({0, 0, width, height});
+    sort_queue();
+    view_nr++;
+    whole = true;
+}
+
+void frame_cache_t::shift(int dx, int dy)
+{
+    rect_t overlap = {
+        std::max(0, -dx), std::max(0, -dy),
+        width - std::abs(dx), height - std::abs(dy)
+    };
+
+    int back = 1 - front;
+    glDisable(GL_SCISSOR_TEST); // blits are scissored as well
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[front]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[back]);
+    glClearColor(-2.0f, 0.0f, 0.0f, 0.0f); // exposed strips show as UNKNOWN until rendered
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBlitFramebuffer(
+        overlap.x + dx, overlap.y + dy, overlap.x + dx + overlap.width, overlap.y + dy + overlap.height,
+        overlap.x,      overlap.y,      overlap.x + overlap.width,      overlap.y + overlap.height,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    front = back;
+    generation_nr++;
+
+    // unfinished regions move along with the pixels around them
+    std::deque<rect_t> moved;
+    moved.swap(queue);
+    for (const rect_t& region : moved) {
+        int x0 = std::max(0, region.x - dx), x1 = std::min(width,  region.x + region.width  - dx);
+        int y0 = std::max(0, region.y - dy), y1 = std::min(height, region.y + region.height - dy);
+        if (x0 < x1 && y0 < y1)
+            queue.push_back({x0, y0, x1 - x0, y1 - y0});
+    }
+
+    // full height columns first, the rows then only cover the width the columns left over
+    if (dx > 0)
+        enqueue({width - dx, 0, dx, height});
+    else if (dx < 0)
+        enqueue({0, 0, -dx, height});
+
+    if (dy > 0)
+        enqueue({overlap.x, height - dy, overlap.width, dy});
+    else if (dy < 0)
+        enqueue({overlap.x, 0, overlap.width, -dy});
+}
+
+void frame_cache_t::resample(const arb_prec_t& new_offset_x, const arb_prec_t& new_offset_y, const arb_prec_t& new_zoom)
+{
+    // t = p / size - 0.5 maps to t * new_zoom / zoom + (offset - new_offset) / zoom in the previous frame
+    double prev_zoom = zoom.to_double();
+    float scale  = (float)(new_zoom.to_double() / prev_zoom);
+    float bias_x = (float)((arb_prec_t(offset_x) - new_offset_x).to_double() / prev_zoom);
+    float bias_y = (float)((arb_prec_t(offset_y) - new_offset_y).to_double() / prev_zoom);
+
+    int back = 1 - front;
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo[back]);
+    glViewport(0, 0, width, height);
+
+    glUseProgram(resample_program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture[front]);
+    glUniform1i(resample_uniforms.u_previous_frame, 0);
+    glUniform2f(resample_uniforms.u_resolution, (float)width, (float)height);
+    glUniform2f(resample_uniforms.u_resample_scale, scale, scale);
+    glUniform2f(resample_uniforms.u_resample_bias, bias_x, bias_y);
+
+    glBindVertexArray(quad_vao);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    front = back;
+    generation_nr++;
+}
+
+void frame_cache_t::enqueue(const rect_t& region)
+{
+    for (int y = region.y; y < region.y + region.height; y += TILE_SIZE) {
+        for (int x = region.x; x < region.x + region.width; x += TILE_SIZE) {
+            queue.push_back({
+                x, y,
+                std::min(TILE_SIZE, region.x + region.width  - x),
+                std::min(TILE_SIZE, region.y + region.height - y)});
+        }
+    }
+}
+
+void frame_cache_t::sort_queue(void)
+{
+    // the centre is where the user is looking, render it first
+    auto distance = [this](const rect_t& r) {
+        long cx = 2 * r.x + r.width  - width;
+        long cy = 2 * r.y + r.height - height;
+        return cx * cx + cy * cy;
+    };
+    std::stable_sort(queue.begin(), queue.end(), [&distance](const rect_t& a, const rect_t& b) {
+        return distance(a) < distance(b);
+    });
+}
+
+std::vector<rect_t> frame_cache_t::next_tiles(size_t pixel_budget, bool split_rows)
+{
+    std::vector<rect_t> tiles;
+    size_t pixels = 0;
+    while (!queue.empty()) {
+        rect_t& tile = queue.front();
+        size_t tile_pixels = (size_t)tile.width * tile.height;
+        if (!tiles.empty() && pixels + tile_pixels > pixel_budget)
+            break;
+
+        if (tiles.empty() && split_rows && tile_pixels > pixel_budget) {
+            int rows = std::max(1, (int)(pixel_budget / tile.width));
+            if (rows < tile.height) {
+                tiles.push_back({tile.x, tile.y, tile.width, rows});
+                tile.y += rows;
+                tile.height -= rows;
+                break;
+            }
+        }
+
+        tiles.push_back(tile);
+        pixels += tile_pixels;
+        queue.pop_front();
+    }
+    return tiles;
+}
+
+void frame_cache_t::bind(void)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo[front]);
+    glViewport(0, 0, width, height);
+}
+
+void frame_cache_t::show_preview(const std::vector<float>& iterations, int preview_width, int preview_height)
+{
+    // only shown once per view, a texture of its own is cheaper to create than to keep around
+    unsigned int preview_texture, preview_fbo;
+    glGenTextures(1, &preview_texture);
+    glBindTexture(GL_TEXTURE_2D, preview_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, preview_width, preview_height, 0, GL_RG, GL_FLOAT, iterations.data());
+    glGenFramebuffers(1, &preview_fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, preview_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, preview_texture, 0);
+
+    glDisable(GL_SCISSOR_TEST); // blits are scissored as well
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[front]);
+    glBlitFramebuffer(0, 0, preview_width, preview_height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    generation_nr++;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteFramebuffers(1, &preview_fbo);
+    glDeleteTextures(1, &preview_texture);
+}
+
+std::vector<float> frame_cache_t::read(void)
+{
+    std::vector<float> iterations(2 * (size_t)width * height);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[front]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RG, GL_FLOAT, iterations.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return iterations;
+}
+
+void frame_cache_t::load(const std::vector<float>& iterations)
+{
+    glBindTexture(GL_TEXTURE_2D, texture[front]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RG, GL_FLOAT, iterations.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    queue.clear();
+    generation_nr++;
+}
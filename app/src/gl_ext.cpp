@@ -0,0 +1,82 @@
+#include "gl_ext.hpp"
+
+#include <cstring>
+
+PFNGLDISPATCHCOMPUTEPROC gl_ext_glDispatchCompute = nullptr;
+PFNGLBINDIMAGETEXTUREPROC gl_ext_glBindImageTexture = nullptr;
+PFNGLMEMORYBARRIERPROC gl_ext_glMemoryBarrier = nullptr;
+PFNGLGETPROGRAMBINARYPROC gl_ext_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC gl_ext_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC gl_ext_glProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC gl_ext_glMaxShaderCompilerThreadsKHR = nullptr;
+
+static bool context_at_least(int wanted_major, int wanted_minor)
+{
+    int major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    return major > wanted_major || (major == wanted_major && minor >= wanted_minor);
+}
+
+static bool has_extension(const char* name)
+{
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool load_gl_ext(GLADloadproc load)
+{
+    if (!context_at_least(4, 3))
+        return false;
+
+    gl_ext_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+    gl_ext_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)load("glBindImageTexture");
+    gl_ext_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+    return gl_ext_glDispatchCompute && gl_ext_glBindImageTexture && gl_ext_glMemoryBarrier;
+}
+
+bool load_gl_program_binary(GLADloadproc load)
+{
+    if (!context_at_least(4, 1))
+        return false;
+
+    gl_ext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+    gl_ext_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+    gl_ext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+    if (!gl_ext_glGetProgramBinary || !gl_ext_glProgramBinary || !gl_ext_glProgramParameteri)
+        return false;
+
+    int formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+bool load_gl_parallel_compile(GLADloadproc load)
+{
+    if (has_extension("GL_KHR_parallel_shader_compile"))
+        gl_ext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+    else if (has_extension("GL_ARB_parallel_shader_compile"))
+        gl_ext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+    if (!gl_ext_glMaxShaderCompilerThreadsKHR)
+        return false;
+
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // as many as the implementation wants
+    return true;
+}
+
+std::string gl_driver(void)
+{
+    std::string driver;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const char* value = (const char*)glGetString(name);
+        driver += value ? value : "";
+        driver += '\n';
+    }
+    return driver;
+}
@@ -0,0 +1,98 @@
+#include "headless_context.hpp"
+
+#include <glad/glad.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+// EGL extension strings are space separated lists
+static bool has_extension(const char* extensions, const char* name)
+{
+    size_t length = std::strlen(name);
+    for (const char* found = extensions; found && (found = std::strstr(found, name)); found += length) {
+        bool starts = found == extensions || found[-1] == ' ';
+        bool ends = found[length] == ' ' || found[length] == '\0';
+        if (starts && ends)
+            return true;
+    }
+    return false;
+}
+
+headless_context_t::headless_context_t(void) : display(nullptr), context(nullptr)
+{
+    EGLDisplay egl_display = EGL_NO_DISPLAY;
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display)
+            egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (egl_display == EGL_NO_DISPLAY)
+        egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &major, &minor)) {
+        std::cout << "[EGL] [ERR]: \"No display to render on\"" << std::endl;
+        return;
+    }
+    display = egl_display;
+
+    const char* extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    if (!has_extension(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "[EGL] [ERR]: \"Display can not make an OpenGL context current without a surface\"" << std::endl;
+        return;
+    }
+
+    // without EGL_KHR_no_config_context any config that renders OpenGL will do, it never gets a surface
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    if (!has_extension(extensions, "EGL_KHR_no_config_context")) {
+        const EGLint config_attributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLint configs = 0;
+        if (!eglChooseConfig(egl_display, config_attributes, &config, 1, &configs) || configs == 0) {
+            std::cout << "[EGL] [ERR]: \"Display has no OpenGL config\"" << std::endl;
+            return;
+        }
+    }
+
+    // fragment_shader.frag needs GLSL 4.50
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT) {
+        std::cout << "[EGL] [ERR]: \"Failed to create an OpenGL 4.5 core context\"" << std::endl;
+        return;
+    }
+    if (!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+        std::cout << "[EGL] [ERR]: \"Failed to make the context current\"" << std::endl;
+        eglDestroyContext(egl_display, egl_context);
+        return;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)proc_address)) {
+        std::cout << "[GLAD] [ERR]: Failed to initialize GLAD" << std::endl;
+        eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(egl_display, egl_context);
+        return;
+    }
+    context = egl_context;
+}
+
+headless_context_t::~headless_context_t()
+{
+    if (context) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+    }
+    if (display)
+        eglTerminate(display);
+}
+
+void* headless_context_t::proc_address(const char* name)
+{
+    return (void*)eglGetProcAddress(name);
+}
@@ -0,0 +1,121 @@
+#include "histogram.hpp"
+
+#include <iostream>
+
+histogram_t::histogram_t(unsigned int scatter_program, unsigned int scan_program, unsigned int quad_vao) :
+    cdf_index(0), dirty(true), scatter_program(scatter_program), scan_program(scan_program), quad_vao(quad_vao)
+{
+    glGenFramebuffers(1, &counts_fbo);
+    glGenTextures(1, &counts_texture);
+    glGenFramebuffers(2, scan_fbo);
+    glGenTextures(2, scan_texture);
+    glGenVertexArrays(1, &empty_vao);
+
+    allocate(counts_fbo, counts_texture);
+    for (int i = 0; i < 2; i++)
+        allocate(scan_fbo[i], scan_texture[i]);
+
+    scatter_uniforms.resolve(scatter_program);
+    count_uniforms.resolve(scatter_program);
+    scan_uniforms.resolve(scan_program);
+
+    clear();
+}
+
+histogram_t::~histogram_t()
+{
+    glDeleteFramebuffers(1, &counts_fbo);
+    glDeleteTextures(1, &counts_texture);
+    glDeleteFramebuffers(2, scan_fbo);
+    glDeleteTextures(2, scan_texture);
+    glDeleteVertexArrays(1, &empty_vao);
+}
+
+void histogram_t::allocate(unsigned int fbo, unsigned int texture)
+{
+    // 32 bit floats count exactly up to 2^24 pixels per bin
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, BINS, 1, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "[GL] [ERR]: \"Histogram framebuffer is incomplete\"" << std::endl;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void histogram_t::clear(void)
+{
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, counts_fbo);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    dirty = true;
+}
+
+void histogram_t::scatter(unsigned int iterations, const rect_t& region, float weight)
+{
+    if (region.width <= 0 || region.height <= 0)
+        return;
+
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, counts_fbo);
+    glViewport(0, 0, BINS, 1);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    glUseProgram(scatter_program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, iterations);
+    glUniform1i(scatter_uniforms.u_iterations, 0);
+    glUniform4i(scatter_uniforms.u_region, region.x, region.y, region.width, region.height);
+    glUniform1f(scatter_uniforms.u_bin_scale, BIN_SCALE);
+    glUniform1i(scatter_uniforms.u_bins, BINS);
+    glUniform1f(count_uniforms.u_weight, weight);
+
+    glBindVertexArray(empty_vao);
+    glDrawArrays(GL_POINTS, 0, region.width * region.height);
+
+    glDisable(GL_BLEND);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    dirty = true;
+}
+
+unsigned int histogram_t::cdf(void)
+{
+    if (!dirty)
+        return scan_texture[cdf_index];
+
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(0, 0, BINS, 1);
+    glUseProgram(scan_program);
+    glUniform1i(scan_uniforms.u_partial_sums, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(quad_vao);
+
+    // log2(BINS) steps, each adds the partial sum stride bins to the left
+    unsigned int source = counts_texture;
+    int target = 0;
+    for (int stride = 1; stride < BINS; stride *= 2) {
+        glBindFramebuffer(GL_FRAMEBUFFER, scan_fbo[target]);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glUniform1i(scan_uniforms.u_stride, stride);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+        source = scan_texture[target];
+        cdf_index = target;
+        target = 1 - target;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    dirty = false;
+    return scan_texture[cdf_index];
+}
@@ -0,0 +1,356 @@
+#include "http_server.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "tcp_socket.hpp"
+
+static std::string percent_decode(const std::string& text)
+{
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '%' && i + 2 < text.size() && std::isxdigit((unsigned char)text[i + 1]) &&
+            std::isxdigit((unsigned char)text[i + 2])) {
+            decoded += (char)std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            decoded += text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    return decoded;
+}
+
+static void parse_target(const std::string& target, http_request_t& request)
+{
+    size_t question = target.find('?');
+    request.path = percent_decode(target.substr(0, question));
+    if (question == std::string::npos)
+        return;
+    std::string query = target.substr(question + 1);
+    for (size_t start = 0; start <= query.size();) {
+        size_t end = std::min(query.find('&', start), query.size());
+        std::string pair = query.substr(start, end - start);
+        size_t equals = pair.find('=');
+        if (!pair.empty())
+            request.query[percent_decode(pair.substr(0, equals))] =
+                equals == std::string::npos ? "" : percent_decode(pair.substr(equals + 1));
+        start = end + 1;
+    }
+}
+
+const char* http_server_t::status_text(int status)
+{
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+static bool send_response(intptr_t socket, const http_response_t& response, bool keep_alive)
+{
+    std::string head = "HTTP/1.1 " + std::to_string(response.status) + " " +
+        http_server_t::status_text(response.status) + "\r\n" +
+        "Content-Type: " + response.content_type + "\r\n" +
+        "Content-Length: " + std::to_string(response.body.size()) + "\r\n" +
+        "Connection: " + (keep_alive ? "keep-alive" : "close") + "\r\n";
+    for (const auto& [name, value] : response.headers)
+        head += name + ": " + value + "\r\n";
+    head += "\r\n";
+    return tcp::send_all(socket, head.data(), head.size()) &&
+        tcp::send_all(socket, response.body.data(), response.body.size());
+}
+
+http_server_t::http_server_t(handler_t handler, int threads, size_t queue_limit) :
+    handler(std::move(handler)), queue_limit(queue_limit)
+{
+    for (int i = 0; i < std::max(threads, 1); i++)
+        pool.emplace_back(&http_server_t::serve_connections, this);
+}
+
+http_server_t::~http_server_t()
+{
+    {
+        std::lock_guard<std::mutex> guard(connections_mutex);
+        stopping = true;
+    }
+    connections_changed.notify_all();
+    wake();
+    for (std::thread& thread : pool)
+        thread.join();
+    for (intptr_t socket : {listener, wake_sender, wake_receiver})
+        if (socket >= 0)
+            tcp::close(socket);
+    for (const auto* connections : {&idle, &returned})
+        for (const connection_t& connection : *connections)
+            tcp::close(connection.socket);
+    for (const connection_t& connection : ready)
+        tcp::close(connection.socket);
+}
+
+bool http_server_t::listen(int port)
+{
+    // localhost only, the server is meant for viewers on the same machine
+    listener = tcp::listen("127.0.0.1", port);
+    if (listener < 0) {
+        std::cout << "[HTTP] [ERR]: \"Could not listen on 127.0.0.1:" << port << "\"" << std::endl;
+        return false;
+    }
+    if (!tcp::pair(wake_sender, wake_receiver)) {
+        std::cout << "[HTTP] [ERR]: \"Could not connect the wake sockets\"" << std::endl;
+        tcp::close(listener);
+        listener = -1;
+        return false;
+    }
+    return true;
+}
+
+void http_server_t::wake(void)
+{
+    char signal = 0;
+    if (wake_sender >= 0)
+        tcp::send_all(wake_sender, &signal, sizeof(signal));
+}
+
+void http_server_t::run(void)
+{
+    std::vector<intptr_t> sockets;
+    std::vector<bool> readable;
+    char signals[256];
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> guard(connections_mutex);
+            if (stopping)
+                return;
+            for (connection_t& connection : returned) {
+                connection.idle_since = now;
+                idle.push_back(std::move(connection));
+            }
+            returned.clear();
+        }
+
+        // connections idle past the timeout are dropped, the next one to time out bounds the wait
+        int timeout = IDLE_TIMEOUT_MS;
+        for (size_t i = 0; i < idle.size();) {
+            int idle_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(now - idle[i].idle_since).count();
+            if (idle_ms >= IDLE_TIMEOUT_MS) {
+                tcp::close(idle[i].socket);
+                idle[i] = std::move(idle.back());
+                idle.pop_back();
+                continue;
+            }
+            timeout = std::min(timeout, IDLE_TIMEOUT_MS - idle_ms);
+            i++;
+        }
+
+        sockets.assign({listener, wake_receiver});
+        for (const connection_t& connection : idle)
+            sockets.push_back(connection.socket);
+        if (!tcp::wait_readable(sockets, timeout, readable))
+            return;
+        if (readable[1] && tcp::receive(wake_receiver, signals, sizeof(signals)) <= 0)
+            return;
+
+        // a request arrived, or the client closed, either way a thread of the pool finds out
+        std::vector<connection_t> arrived;
+        for (size_t i = idle.size(); i-- > 0;) {
+            if (!readable[i + 2])
+                continue;
+            arrived.push_back(std::move(idle[i]));
+            idle[i] = std::move(idle.back());
+            idle.pop_back();
+        }
+
+        std::unique_lock<std::mutex> lock(connections_mutex);
+        for (connection_t& connection : arrived)
+            ready.push_back(std::move(connection));
+        if (readable[0]) {
+            intptr_t socket = tcp::accept(listener);
+            if (socket < 0)
+                return;
+            tcp::set_no_delay(socket);
+            tcp::set_timeout(socket, IDLE_TIMEOUT_MS);
+            if (idle.size() + ready.size() + returned.size() >= queue_limit) {
+                lock.unlock();
+                http_response_t busy;
+                busy.status = 503;
+                busy.body = "busy, try again\n";
+                busy.headers.emplace_back("Retry-After", "1");
+                send_response(socket, busy, false);
+                tcp::close(socket);
+            } else {
+                // waits for its first request like any idle connection
+                idle.push_back({socket, std::string(), now});
+            }
+        }
+        if (lock.owns_lock())
+            lock.unlock();
+        if (!arrived.empty())
+            connections_changed.notify_all();
+    }
+}
+
+void http_server_t::serve_connections(void)
+{
+    for (;;) {
+        std::unique_lock<std::mutex> lock(connections_mutex);
+        connections_changed.wait(lock, [this] { return !ready.empty() || stopping; });
+        if (stopping)
+            return;
+        connection_t connection = std::move(ready.front());
+        ready.pop_front();
+        lock.unlock();
+
+        if (!serve(connection)) {
+            tcp::close(connection.socket);
+            continue;
+        }
+
+        // a request the client sent right behind the last one is received already, waiting on the socket would
+        // miss it, so it queues for a thread again
+        lock.lock();
+        bool pipelined = connection.buffer.find("\r\n\r\n") != std::string::npos;
+        if (pipelined)
+            ready.push_back(std::move(connection));
+        else
+            returned.push_back(std::move(connection));
+        lock.unlock();
+        if (pipelined)
+            connections_changed.notify_one();
+        else
+            wake();
+    }
+}
+
+bool http_server_t::serve(connection_t& connection)
+{
+    std::string& buffer = connection.buffer;
+    char chunk[4096];
+
+    // the request line and headers, a client may already have sent the next request behind them
+    size_t end;
+    while ((end = buffer.find("\r\n\r\n")) == std::string::npos && buffer.size() <= MAX_REQUEST_SIZE) {
+        long received = tcp::receive(connection.socket, chunk, sizeof(chunk));
+        if (received <= 0)
+            return false; // closed, or stalled past the timeout
+        buffer.append(chunk, (size_t)received);
+    }
+    // too large whether the terminator is still missing or arrived beyond the limit
+    if (end == std::string::npos || end > MAX_REQUEST_SIZE) {
+        http_response_t too_large;
+        too_large.status = 431;
+        send_response(connection.socket, too_large, false);
+        return false;
+    }
+    std::string head = buffer.substr(0, end);
+    buffer.erase(0, end + 4);
+
+    http_request_t request;
+    size_t line_end = head.find("\r\n");
+    std::string line = head.substr(0, line_end);
+    size_t first_space = line.find(' '), second_space = line.rfind(' ');
+    if (first_space == std::string::npos || second_space <= first_space) {
+        http_response_t bad;
+        bad.status = 400;
+        send_response(connection.socket, bad, false);
+        return false;
+    }
+    request.method = line.substr(0, first_space);
+    parse_target(line.substr(first_space + 1, second_space - first_space - 1), request);
+
+    // HTTP/1.1 keeps connections alive unless asked not to, HTTP/1.0 only when asked to
+    std::string headers = head.substr(std::min(line_end, head.size()));
+    for (char& c : headers)
+        c = (char)std::tolower((unsigned char)c);
+    bool keep_alive = line.compare(second_space + 1, std::string::npos, "HTTP/1.1") == 0 ?
+        headers.find("\nconnection: close") == std::string::npos :
+        headers.find("\nconnection: keep-alive") != std::string::npos;
+
+    http_response_t response;
+    if (request.method != "GET") {
+        response.status = 405;
+        response.body = "only GET\n";
+    } else {
+        response = handler(request);
+    }
+    return send_response(connection.socket, response, keep_alive) && keep_alive;
+}
+
+http_client_t::~http_client_t()
+{
+    close();
+}
+
+bool http_client_t::connect(int port)
+{
+    close();
+    connection = tcp::connect("127.0.0.1", port);
+    if (connection < 0)
+        return false;
+    tcp::set_no_delay(connection);
+    return true;
+}
+
+void http_client_t::close(void)
+{
+    if (connection >= 0)
+        tcp::close(connection);
+    connection = -1;
+    buffer.clear();
+}
+
+bool http_client_t::get(const std::string& target, http_response_t& response)
+{
+    std::string request = "GET " + target + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    if (connection < 0 || !tcp::send_all(connection, request.data(), request.size()))
+        return false;
+
+    // reads until the head is complete, then until the body has the announced length
+    char chunk[65536];
+    size_t end, length = 0;
+    bool head = true;
+    for (;;) {
+        if (head && (end = buffer.find("\r\n\r\n")) != std::string::npos) {
+            std::string lines = buffer.substr(0, end + 2);
+            buffer.erase(0, end + 4);
+            head = false;
+            response = http_response_t();
+            response.status = std::atoi(lines.c_str() + std::min(lines.find(' '), lines.size()));
+            for (size_t start = lines.find("\r\n") + 2; start < lines.size();) {
+                size_t line_end = lines.find("\r\n", start), colon = lines.find(':', start);
+                if (colon < line_end) {
+                    std::string name = lines.substr(start, colon - start);
+                    std::string value = lines.substr(colon + 1, line_end - colon - 1);
+                    value.erase(0, std::min(value.find_first_not_of(' '), value.size()));
+                    for (char& c : name)
+                        c = (char)std::tolower((unsigned char)c);
+                    if (name == "content-length")
+                        length = (size_t)std::strtoull(value.c_str(), nullptr, 10);
+                    else if (name == "content-type")
+                        response.content_type = value;
+                    else
+                        response.headers.emplace_back(name, value);
+                }
+                start = line_end + 2;
+            }
+        }
+        if (!head && buffer.size() >= length) {
+            response.body = buffer.substr(0, length);
+            buffer.erase(0, length);
+            return true;
+        }
+        long received = tcp::receive(connection, chunk, sizeof(chunk));
+        if (received <= 0)
+            return false;
+        buffer.append(chunk, (size_t)received);
+    }
+}
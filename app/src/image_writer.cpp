@@ -0,0 +1,422 @@
+#include "image_writer.hpp"
+
+#include <bit>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef MANDELBROT_ZLIB
+    #include <zlib.h>
+#endif
+
+// rows handed to encoders beyond the height, or missing at the end, are errors of the caller worth a message
+static bool check_rows(int rows_written, int rows, int height)
+{
+    if (rows_written + rows <= height)
+        return true;
+    std::cout << "[IMAGE] [ERR]: \"Band of " << rows << " rows past the end of an image of " << height << " rows\""
+        << std::endl;
+    return false;
+}
+
+static bool check_complete(int rows_written, int height)
+{
+    if (rows_written == height)
+        return true;
+    std::cout << "[IMAGE] [ERR]: \"Image ended after " << rows_written << " of " << height << " rows\"" << std::endl;
+    return false;
+}
+
+class ppm_encoder_t : public image_encoder_t {
+    std::unique_ptr<std::ostream> output;
+    std::ostream& file;
+    const int width, height;
+    int rows_written = 0;
+
+public:
+    ppm_encoder_t(std::unique_ptr<std::ostream> output, int width, int height) :
+        output(std::move(output)), file(*this->output), width(width), height(height)
+    {
+        if (file)
+            file << "P6\n" << width << " " << height << "\n255\n";
+    }
+
+    bool valid(void) const { return (bool)file; }
+
+    pixel_format_t format(void) const override { return pixel_format_t::RGB8; }
+
+    bool encode(const image_band_t& band) override
+    {
+        if (!check_rows(rows_written, band.rows, height))
+            return false;
+        rows_written += band.rows;
+        file.write((const char*)band.rgb.data(), 3 * (size_t)width * band.rows);
+        return (bool)file;
+    }
+
+    bool finish(void) override
+    {
+        file.flush();
+        return check_complete(rows_written, height) && !file.fail();
+    }
+};
+
+// PFM stores rows bottom up, in a file every row is written straight to its place, ahead of the rows before it. A
+// string stream can not seek past its end, there the rows are kept until finish writes them in file order
+class pfm_encoder_t : public image_encoder_t {
+    std::unique_ptr<std::ostream> output;
+    std::ostream& file;
+    const int width, height;
+    const bool seekable;
+    int rows_written = 0;
+    std::streamoff header_size = 0;
+    std::vector<float> rows;    // every row so far when the output is not seekable
+
+public:
+    pfm_encoder_t(std::unique_ptr<std::ostream> output, int width, int height, bool seekable) :
+        output(std::move(output)), file(*this->output), width(width), height(height), seekable(seekable)
+    {
+        // a negative scale marks little endian floats
+        if (file)
+            file << "Pf\n" << width << " " << height << "\n"
+                << (std::endian::native == std::endian::little ? "-1.0" : "1.0") << "\n";
+        header_size = file.tellp();
+    }
+
+    bool valid(void) const { return (bool)file; }
+
+    pixel_format_t format(void) const override { return pixel_format_t::ITERATION; }
+
+    bool encode(const image_band_t& band) override
+    {
+        if (!check_rows(rows_written, band.rows, height))
+            return false;
+        const size_t row_bytes = sizeof(float) * width;
+        if (!seekable) {
+            rows.insert(rows.end(), band.iterations.begin(), band.iterations.begin() + (size_t)band.rows * width);
+            rows_written += band.rows;
+            return true;
+        }
+        for (int row = 0; row < band.rows; row++, rows_written++) {
+            file.seekp(header_size + (std::streamoff)(height - 1 - rows_written) * row_bytes);
+            file.write((const char*)&band.iterations[(size_t)row * width], row_bytes);
+        }
+        return (bool)file;
+    }
+
+    bool finish(void) override
+    {
+        if (!check_complete(rows_written, height))
+            return false;
+        for (int row = height - 1; row >= 0 && !seekable; row--)
+            file.write((const char*)&rows[(size_t)row * width], sizeof(float) * width);
+        file.flush();
+        return !file.fail();
+    }
+};
+
+#ifdef MANDELBROT_ZLIB
+// rows are filtered one by one with the filter scoring lowest, the heuristic of libpng, and fed to deflate as they
+// come, IDAT chunks are written whenever IDAT_SIZE bytes of compressed data are ready
+class png_encoder_t : public image_encoder_t {
+    static constexpr size_t IDAT_SIZE = 1 << 16;
+    static constexpr int BYTES_PER_PIXEL = 3;
+    static constexpr int FILTERS = 5;   // none, sub, up, average, paeth
+
+    std::unique_ptr<std::ostream> output;
+    std::ostream& file;
+    const int width, height;
+    int rows_written = 0;
+    z_stream stream;
+    bool stream_open = false;
+    std::vector<uint8_t> previous;          // unfiltered row above, zeros above the first row
+    std::vector<uint8_t> filtered[FILTERS]; // filter byte followed by the filtered row
+    std::vector<uint8_t> idat;
+
+    static void put_u32(uint8_t* target, uint32_t value)
+    {
+        target[0] = (uint8_t)(value >> 24);
+        target[1] = (uint8_t)(value >> 16);
+        target[2] = (uint8_t)(value >> 8);
+        target[3] = (uint8_t)value;
+    }
+
+    bool write_chunk(const char* type, const uint8_t* data, size_t size)
+    {
+        uint8_t header[8];
+        put_u32(header, (uint32_t)size);
+        std::memcpy(header + 4, type, 4);
+        uLong crc = crc32(crc32(0L, Z_NULL, 0), header + 4, 4);
+        if (size > 0)
+            crc = crc32(crc, data, (uInt)size); // a null buffer resets the crc instead
+        uint8_t trailer[4];
+        put_u32(trailer, (uint32_t)crc);
+
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)data, size);
+        file.write((const char*)trailer, sizeof(trailer));
+        return (bool)file;
+    }
+
+    // runs deflate over the input set on the stream, writing every IDAT filled on the way
+    bool deflate_input(int flush)
+    {
+        for (;;) {
+            int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR)
+                return false;
+            if (stream.avail_out == 0) {
+                if (!write_chunk("IDAT", idat.data(), idat.size()))
+                    return false;
+                stream.next_out = idat.data();
+                stream.avail_out = (uInt)idat.size();
+                continue;
+            }
+            if (flush == Z_FINISH ? result == Z_STREAM_END : stream.avail_in == 0)
+                return true;
+        }
+    }
+
+    static uint8_t paeth(int left, int up, int up_left)
+    {
+        int estimate = left + up - up_left;
+        int distance_left = std::abs(estimate - left), distance_up = std::abs(estimate - up);
+        int distance_up_left = std::abs(estimate - up_left);
+        if (distance_left <= distance_up && distance_left <= distance_up_left)
+            return (uint8_t)left;
+        return (uint8_t)(distance_up <= distance_up_left ? up : up_left);
+    }
+
+    // filters a row every way, returns the filter whose bytes as signed values sum up the smallest
+    int filter_row(const uint8_t* row)
+    {
+        const size_t row_bytes = (size_t)BYTES_PER_PIXEL * width;
+        int best = 0;
+        unsigned long best_score = ~0ul;
+        for (int filter = 0; filter < FILTERS; filter++) {
+            uint8_t* target = filtered[filter].data() + 1;
+            unsigned long score = 0;
+            for (size_t i = 0; i < row_bytes; i++) {
+                int left = i >= BYTES_PER_PIXEL ? row[i - BYTES_PER_PIXEL] : 0;
+                int up = previous[i];
+                int up_left = i >= BYTES_PER_PIXEL ? previous[i - BYTES_PER_PIXEL] : 0;
+                uint8_t predicted = 0;
+                switch (filter) {
+                    case 1: predicted = (uint8_t)left; break;
+                    case 2: predicted = (uint8_t)up; break;
+                    case 3: predicted = (uint8_t)((left + up) / 2); break;
+                    case 4: predicted = paeth(left, up, up_left); break;
+                }
+                target[i] = (uint8_t)(row[i] - predicted);
+                score += (unsigned long)std::abs((int)(int8_t)target[i]);
+            }
+            if (score < best_score) {
+                best_score = score;
+                best = filter;
+            }
+        }
+        return best;
+    }
+
+public:
+    png_encoder_t(std::unique_ptr<std::ostream> output, int width, int height) :
+        output(std::move(output)), file(*this->output), width(width), height(height),
+        previous((size_t)BYTES_PER_PIXEL * width, 0), idat(IDAT_SIZE)
+    {
+        for (int filter = 0; filter < FILTERS; filter++) {
+            filtered[filter].resize(1 + (size_t)BYTES_PER_PIXEL * width);
+            filtered[filter][0] = (uint8_t)filter;
+        }
+        if (!file)
+            return;
+
+        std::memset(&stream, 0, sizeof(stream));
+        if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            std::cout << "[IMAGE] [ERR]: \"deflateInit failed\"" << std::endl;
+            return;
+        }
+        stream_open = true;
+        stream.next_out = idat.data();
+        stream.avail_out = (uInt)idat.size();
+
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        file.write((const char*)signature, sizeof(signature));
+        uint8_t header[13];
+        put_u32(header, (uint32_t)width);
+        put_u32(header + 4, (uint32_t)height);
+        header[8] = 8;  // bits per channel
+        header[9] = 2;  // truecolour
+        header[10] = 0; // deflate
+        header[11] = 0; // adaptive filtering
+        header[12] = 0; // not interlaced
+        write_chunk("IHDR", header, sizeof(header));
+    }
+
+    ~png_encoder_t()
+    {
+        if (stream_open)
+            deflateEnd(&stream);
+    }
+
+    bool valid(void) const { return stream_open && (bool)file; }
+
+    pixel_format_t format(void) const override { return pixel_format_t::RGB8; }
+
+    bool encode(const image_band_t& band) override
+    {
+        if (!check_rows(rows_written, band.rows, height))
+            return false;
+        const size_t row_bytes = (size_t)BYTES_PER_PIXEL * width;
+        for (int row = 0; row < band.rows; row++, rows_written++) {
+            const uint8_t* pixels = &band.rgb[row * row_bytes];
+            std::vector<uint8_t>& best = filtered[filter_row(pixels)];
+            std::memcpy(previous.data(), pixels, row_bytes);
+
+            stream.next_in = best.data();
+            stream.avail_in = (uInt)best.size();
+            if (!deflate_input(Z_NO_FLUSH))
+                return false;
+        }
+        return true;
+    }
+
+    bool finish(void) override
+    {
+        if (!check_complete(rows_written, height) || !deflate_input(Z_FINISH))
+            return false;
+        if (!write_chunk("IDAT", idat.data(), idat.size() - stream.avail_out) || !write_chunk("IEND", nullptr, 0))
+            return false;
+        file.flush();
+        return !file.fail();
+    }
+};
+#endif // MANDELBROT_ZLIB
+
+// encoder for the format of an extension writing into output, which is a file when seekable, nullptr with a message
+// when the format is unknown or output could not be opened
+static std::unique_ptr<image_encoder_t> make_encoder(const std::string& name, std::unique_ptr<std::ostream> output,
+    int width, int height, bool seekable)
+{
+    std::string extension = name.size() >= 4 ? name.substr(name.size() - 4) : "";
+    for (char& c : extension)
+        c = (char)std::tolower((unsigned char)c);
+
+    std::unique_ptr<image_encoder_t> encoder;
+    bool valid = false;
+    if (extension == ".ppm") {
+        auto ppm = std::make_unique<ppm_encoder_t>(std::move(output), width, height);
+        valid = ppm->valid();
+        encoder = std::move(ppm);
+    } else if (extension == ".pfm") {
+        auto pfm = std::make_unique<pfm_encoder_t>(std::move(output), width, height, seekable);
+        valid = pfm->valid();
+        encoder = std::move(pfm);
+    } else if (extension == ".png") {
+#ifdef MANDELBROT_ZLIB
+        auto png = std::make_unique<png_encoder_t>(std::move(output), width, height);
+        valid = png->valid();
+        encoder = std::move(png);
+#else
+        std::cout << "[IMAGE] [ERR]: \"Built without zlib, PNG is not available, write .ppm instead\"" << std::endl;
+        return nullptr;
+#endif
+    } else {
+        std::cout << "[IMAGE] [ERR]: \"Unknown image format " << name << ", use .png, .ppm or .pfm\"" << std::endl;
+        return nullptr;
+    }
+    if (!valid) {
+        std::cout << "[IMAGE] [ERR]: \"Could not create " << name << "\"" << std::endl;
+        return nullptr;
+    }
+    return encoder;
+}
+
+std::unique_ptr<image_writer_t> image_writer_t::open(const std::string& path, int width, int height)
+{
+    std::unique_ptr<image_encoder_t> encoder = make_encoder(path,
+        std::make_unique<std::ofstream>(path, std::ios::binary), width, height, true);
+    if (!encoder)
+        return nullptr;
+
+    std::unique_ptr<image_writer_t> writer(new image_writer_t(std::move(encoder)));
+    writer->thread = std::thread(&image_writer_t::run, writer.get());
+    return writer;
+}
+
+bool encode_image(const std::string& extension, int width, int height, const image_band_t& image, std::string& bytes)
+{
+    auto output = std::make_unique<std::ostringstream>(std::ios::binary);
+    std::ostringstream& encoded = *output;
+    std::unique_ptr<image_encoder_t> encoder = make_encoder(extension, std::move(output), width, height, false);
+    if (!encoder || !encoder->encode(image) || !encoder->finish())
+        return false;
+    bytes = encoded.str();
+    return true;
+}
+
+image_writer_t::image_writer_t(std::unique_ptr<image_encoder_t> encoder) : encoder(std::move(encoder))
+{
+}
+
+image_writer_t::~image_writer_t()
+{
+    if (thread.joinable())
+        close();
+}
+
+void image_writer_t::run(void)
+{
+    for (;;) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        queue_changed.wait(lock, [this] { return !queue.empty() || closing; });
+        if (queue.empty())
+            break;
+        image_band_t band = std::move(queue.front());
+        queue.pop_front();
+        bool skip = failed;
+        lock.unlock();
+        queue_changed.notify_all(); // room for the next band
+
+        // bands after a failure are dropped, so write() never waits on a writer that gave up
+        if (!skip && !encoder->encode(band))
+            fail();
+    }
+    if (!failed && !encoder->finish())
+        fail();
+}
+
+void image_writer_t::fail(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex);
+        failed = true;
+    }
+    queue_changed.notify_all(); // wakes write() waiting for room
+}
+
+bool image_writer_t::write(image_band_t band)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_changed.wait(lock, [this] { return queue.size() < QUEUED_BANDS || failed; });
+    if (failed || closing)
+        return false;
+    queue.push_back(std::move(band));
+    lock.unlock();
+    queue_changed.notify_all();
+    return true;
+}
+
+bool image_writer_t::close(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(queue_mutex);
+        closing = true;
+    }
+    queue_changed.notify_all();
+    if (thread.joinable())
+        thread.join();
+    return !failed;
+}
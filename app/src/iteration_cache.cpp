@@ -0,0 +1,150 @@
+#include "iteration_cache.hpp"
+
+#include "util.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+
+iteration_cache_t::iteration_cache_t(const std::string& directory, uint64_t max_bytes) :
+    directory(max_bytes ? directory : std::string()), max_bytes(max_bytes)
+{
+}
+
+std::string iteration_cache_t::default_directory(void)
+{
+    return user_cache_directory("iterations");
+}
+
+std::string iteration_cache_t::source_version(std::initializer_list<const char*> sources)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (const char* source : sources)
+        hash = fnv1a(hash, source, std::char_traits<char>::length(source) + 1); // the 0 separates sources
+    char version[20];
+    std::snprintf(version, sizeof(version), "%016llx", (unsigned long long)hash);
+    return version;
+}
+
+std::string iteration_cache_t::identity(const view_t& view)
+{
+    // the engine is text, the rest raw limbs and integers of the host, entries are not shared between byte orders
+    std::string result = view.engine;
+    result += '\0';
+    for (const arb_prec_t* value : {&view.x, &view.y, &view.scale})
+        result.append((const char*)value->buffer(), value->size() * sizeof(uint32_t));
+    for (int32_t number : {view.width, view.height, view.max_iterations})
+        result.append((const char*)&number, sizeof(number));
+    return result;
+}
+
+std::string iteration_cache_t::path(uint64_t hash) const
+{
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return directory + "/" + name;
+}
+
+bool iteration_cache_t::load(const view_t& view, std::vector<float>& values) const
+{
+    if (directory.empty())
+        return false;
+
+    std::string key = identity(view);
+    uint64_t hash = fnv1a(FNV_OFFSET, key.data(), key.size());
+    std::string entry = path(hash);
+    std::ifstream file(entry, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t magic = 0, version = 0, key_length = 0;
+    uint64_t stored_hash = 0, count = 0, checksum = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&stored_hash, sizeof(stored_hash));
+    file.read((char*)&key_length, sizeof(key_length));
+    if (!file || magic != MAGIC || version != VERSION || stored_hash != hash || key_length != key.size())
+        return false;
+
+    std::string stored_key(key_length, '\0');
+    file.read(stored_key.data(), key_length);
+    file.read((char*)&count, sizeof(count));
+    file.read((char*)&checksum, sizeof(checksum));
+    if (!file || stored_key != key || count * sizeof(float) > max_bytes)
+        return false;
+
+    values.resize(count);
+    file.read((char*)values.data(), count * sizeof(float));
+    if (!file || fnv1a(FNV_OFFSET, values.data(), count * sizeof(float)) != checksum) {
+        // cut short or damaged on disk, it would never load again
+        std::cout << "[CACHE] [WARN]: \"Removing damaged entry " << entry << "\"" << std::endl;
+        file.close();
+        std::error_code error;
+        std::filesystem::remove(entry, error);
+        values.clear();
+        return false;
+    }
+
+    // eviction goes by modification time, a load counts as a use
+    std::error_code error;
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+void iteration_cache_t::store(const view_t& view, const std::vector<float>& values) const
+{
+    if (!fits(values.size()))
+        return;
+
+    std::string key = identity(view);
+    uint64_t hash = fnv1a(FNV_OFFSET, key.data(), key.size());
+    bool written = write_atomically(path(hash), [&](std::ostream& file) {
+        uint32_t magic = MAGIC, version = VERSION, key_length = (uint32_t)key.size();
+        uint64_t count = values.size();
+        uint64_t checksum = fnv1a(FNV_OFFSET, values.data(), count * sizeof(float));
+        file.write((const char*)&magic, sizeof(magic));
+        file.write((const char*)&version, sizeof(version));
+        file.write((const char*)&hash, sizeof(hash));
+        file.write((const char*)&key_length, sizeof(key_length));
+        file.write(key.data(), key.size());
+        file.write((const char*)&count, sizeof(count));
+        file.write((const char*)&checksum, sizeof(checksum));
+        file.write((const char*)values.data(), count * sizeof(float));
+    }, "CACHE");
+    if (written)
+        evict();
+}
+
+void iteration_cache_t::evict(void) const
+{
+    struct entry_t {
+        std::filesystem::file_time_type used;
+        uint64_t size;
+        std::filesystem::path path;
+    };
+    std::vector<entry_t> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+        // temporary files of stores in flight are left to their sessions
+        if (item.path().extension() != ".bin")
+            continue;
+        entry_t entry = {item.last_write_time(error), item.file_size(error), item.path()};
+        if (error)
+            continue; // removed by another session meanwhile
+        entries.push_back(entry);
+        total += entry.size;
+    }
+    if (total <= max_bytes)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const entry_t& a, const entry_t& b) { return a.used < b.used; });
+    for (const entry_t& entry : entries) {
+        if (total <= max_bytes)
+            break;
+        if (std::filesystem::remove(entry.path, error))
+            total -= entry.size;
+    }
+}
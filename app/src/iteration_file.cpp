@@ -0,0 +1,291 @@
+#include "iteration_file.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static size_t tile_bytes(const iteration_file_t::header_t& header)
+{
+    return sizeof(float) * header.tile_size * header.tile_size;
+}
+
+bool iteration_file_t::map(const std::string& path, size_t size, bool create)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+        create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cout << "[ITERFILE] [ERR]: \"Could not open " << path << "\"" << std::endl;
+        return false;
+    }
+    file_handle = file;
+    LARGE_INTEGER file_size;
+    if (create) {
+        // sparse, so tiles not rendered yet take no disk space
+        DWORD returned;
+        DeviceIoControl(file, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &returned, NULL);
+        file_size.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(file, file_size, NULL, FILE_BEGIN) || !SetEndOfFile(file)) {
+            std::cout << "[ITERFILE] [ERR]: \"Could not size " << path << "\"" << std::endl;
+            return false;
+        }
+    } else if (!GetFileSizeEx(file, &file_size)) {
+        return false;
+    }
+    mapping_size = (size_t)file_size.QuadPart;
+    if (mapping_size < sizeof(header_t)) {
+        std::cout << "[ITERFILE] [ERR]: \"" << path << " is no iteration file\"" << std::endl;
+        return false;
+    }
+    mapping_handle = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(mapping_size >> 32),
+        (DWORD)mapping_size, NULL);
+    if (mapping_handle)
+        mapping = (uint8_t*)MapViewOfFile(mapping_handle, FILE_MAP_ALL_ACCESS, 0, 0, mapping_size);
+#else
+    file_descriptor = ::open(path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (file_descriptor < 0) {
+        std::cout << "[ITERFILE] [ERR]: \"Could not open " << path << "\"" << std::endl;
+        return false;
+    }
+    if (create && ftruncate(file_descriptor, (off_t)size) != 0) {
+        std::cout << "[ITERFILE] [ERR]: \"Could not size " << path << "\"" << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (fstat(file_descriptor, &status) != 0)
+        return false;
+    mapping_size = (size_t)status.st_size;
+    if (mapping_size < sizeof(header_t)) {
+        std::cout << "[ITERFILE] [ERR]: \"" << path << " is no iteration file\"" << std::endl;
+        return false;
+    }
+    void* address = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+    mapping = address == MAP_FAILED ? nullptr : (uint8_t*)address;
+    #ifdef MADV_HUGEPAGE
+        // only a hint, file backed huge pages depend on the file system and the kernel configuration
+        if (mapping)
+            madvise(mapping, mapping_size, MADV_HUGEPAGE);
+    #endif
+#endif
+    if (!mapping) {
+        std::cout << "[ITERFILE] [ERR]: \"Could not map " << path << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void iteration_file_t::layout(void)
+{
+    status_offset = align_up(sizeof(header_t), PAGE_SIZE);
+    tiles_offset = status_offset + align_up((size_t)tiles_x() * tiles_y(), PAGE_SIZE);
+}
+
+void iteration_file_t::sync(size_t offset, size_t size)
+{
+    size_t start = offset / PAGE_SIZE * PAGE_SIZE;
+    size_t length = align_up(offset + size, PAGE_SIZE) - start;
+#ifdef _WIN32
+    FlushViewOfFile(mapping + start, length);
+    FlushFileBuffers(file_handle);
+#else
+    msync(mapping + start, length, MS_SYNC);
+#endif
+}
+
+void iteration_file_t::release(size_t offset, size_t size)
+{
+    size_t start = offset / PAGE_SIZE * PAGE_SIZE;
+    size_t length = align_up(offset + size, PAGE_SIZE) - start;
+#ifdef _WIN32
+    VirtualUnlock(mapping + start, length); // trims pages which are not locked from the working set
+#else
+    madvise(mapping + start, length, MADV_DONTNEED); // the pages of a shared mapping are read back from the file
+#endif
+}
+
+std::unique_ptr<iteration_file_t> iteration_file_t::create(const std::string& path, int width, int height,
+    int tile_size, int max_iterations, const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+    projection_t projection)
+{
+    header_t header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.tile_size = (uint32_t)tile_size;
+    header.max_iterations = (uint32_t)max_iterations;
+    header.limbs = (uint32_t)arb_prec_t::size();
+    std::memcpy(header.centre_x, centre_x.buffer(), sizeof(uint32_t) * arb_prec_t::size());
+    std::memcpy(header.centre_y, centre_y.buffer(), sizeof(uint32_t) * arb_prec_t::size());
+    std::memcpy(header.pixel, pixel.buffer(), sizeof(uint32_t) * arb_prec_t::size());
+    header.projection = projection;
+
+    std::unique_ptr<iteration_file_t> file(new iteration_file_t());
+    size_t tiles = (size_t)((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+    size_t size = align_up(sizeof(header_t), PAGE_SIZE) + align_up(tiles, PAGE_SIZE) + tiles * tile_bytes(header);
+    if (!file->map(path, size, true))
+        return nullptr;
+    std::memcpy(file->mapping, &header, sizeof(header));
+    file->layout();
+    file->sync(0, file->tiles_offset);
+
+    file->flusher = std::thread(&iteration_file_t::flush_tiles, file.get());
+    return file;
+}
+
+std::unique_ptr<iteration_file_t> iteration_file_t::open(const std::string& path)
+{
+    std::unique_ptr<iteration_file_t> file(new iteration_file_t());
+    if (!file->map(path, 0, false))
+        return nullptr;
+
+    const header_t& header = file->header();
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.tile_size == 0) {
+        std::cout << "[ITERFILE] [ERR]: \"" << path << " is no iteration file\"" << std::endl;
+        return nullptr;
+    }
+    if (header.limbs != arb_prec_t::size()) {
+        std::cout << "[ITERFILE] [ERR]: \"" << path << " was written with " << header.limbs
+            << " limbs of precision, this build has " << arb_prec_t::size() << "\"" << std::endl;
+        return nullptr;
+    }
+    file->layout();
+    if (file->mapping_size < file->tiles_offset + (size_t)file->tiles_x() * file->tiles_y() * tile_bytes(header)) {
+        std::cout << "[ITERFILE] [ERR]: \"" << path << " is truncated\"" << std::endl;
+        return nullptr;
+    }
+
+    file->flusher = std::thread(&iteration_file_t::flush_tiles, file.get());
+    return file;
+}
+
+iteration_file_t::~iteration_file_t()
+{
+    close();
+}
+
+int iteration_file_t::tiles_x(void) const
+{
+    return (int)((header().width + header().tile_size - 1) / header().tile_size);
+}
+
+int iteration_file_t::tiles_y(void) const
+{
+    return (int)((header().height + header().tile_size - 1) / header().tile_size);
+}
+
+arb_prec_t iteration_file_t::centre_x(void) const
+{
+    arb_prec_t value;
+    std::memcpy(value.buffer(), header().centre_x, sizeof(uint32_t) * arb_prec_t::size());
+    return value;
+}
+
+arb_prec_t iteration_file_t::centre_y(void) const
+{
+    arb_prec_t value;
+    std::memcpy(value.buffer(), header().centre_y, sizeof(uint32_t) * arb_prec_t::size());
+    return value;
+}
+
+arb_prec_t iteration_file_t::pixel(void) const
+{
+    arb_prec_t value;
+    std::memcpy(value.buffer(), header().pixel, sizeof(uint32_t) * arb_prec_t::size());
+    return value;
+}
+
+float* iteration_file_t::tile(int tile_x, int tile_y)
+{
+    size_t index = (size_t)tile_y * tiles_x() + tile_x;
+    return (float*)(mapping + tiles_offset + index * tile_bytes(header()));
+}
+
+bool iteration_file_t::complete(int tile_x, int tile_y) const
+{
+    return mapping[status_offset + (size_t)tile_y * tiles_x() + tile_x] != 0;
+}
+
+void iteration_file_t::finish(int tile_x, int tile_y)
+{
+    std::unique_lock<std::mutex> lock(pending_mutex);
+    pending_changed.wait(lock, [this] { return pending.size() < MAX_PENDING_TILES; });
+    pending.push_back((size_t)tile_y * tiles_x() + tile_x);
+    lock.unlock();
+    pending_changed.notify_all();
+}
+
+void iteration_file_t::flush_tiles(void)
+{
+    const size_t bytes = tile_bytes(header());
+    for (;;) {
+        std::unique_lock<std::mutex> lock(pending_mutex);
+        pending_changed.wait(lock, [this] { return !pending.empty() || closing; });
+        if (pending.empty())
+            break;
+        size_t index = pending.front();
+        pending.pop_front();
+        lock.unlock();
+        pending_changed.notify_all(); // room for the next tile
+
+        // the status byte is only set once the values are on the disk, a crash never leaves a tile marked done early
+        size_t offset = tiles_offset + index * bytes;
+        sync(offset, bytes);
+        mapping[status_offset + index] = 1;
+        sync(status_offset + index, 1);
+        release(offset, bytes);
+    }
+}
+
+void iteration_file_t::release_row(int tile_y)
+{
+    const size_t bytes = tile_bytes(header()) * tiles_x();
+    release(tiles_offset + (size_t)tile_y * bytes, bytes);
+}
+
+void iteration_file_t::close(void)
+{
+    if (flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(pending_mutex);
+            closing = true;
+        }
+        pending_changed.notify_all();
+        flusher.join();
+    }
+#ifdef _WIN32
+    if (mapping) {
+        FlushViewOfFile(mapping, 0);
+        UnmapViewOfFile(mapping);
+    }
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+    if (file_handle) {
+        FlushFileBuffers(file_handle);
+        CloseHandle(file_handle);
+    }
+    mapping_handle = file_handle = nullptr;
+#else
+    if (mapping) {
+        msync(mapping, mapping_size, MS_SYNC);
+        munmap(mapping, mapping_size);
+    }
+    if (file_descriptor >= 0)
+        ::close(file_descriptor);
+    file_descriptor = -1;
+#endif
+    mapping = nullptr;
+}
@@ -0,0 +1,183 @@
+#include "palette.hpp"
+
+#include "util.hpp"
+
+#include <glad/glad.h>
+
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+// the cosine palette colour_shader.frag used to evaluate per pixel, sampled at 32 evenly spaced angles
+static constexpr colour_t cosine_colours[] = {
+    {255, 191,  64}, {253, 168,  43}, {245, 144,  26}, {234, 119,  13},
+    {218,  95,   4}, {198,  71,   0}, {176,  50,   1}, {152,  32,   7},
+    {128,  17,  17}, {103,   7,  32}, { 79,   1,  50}, { 57,   0,  71},
+    { 37,   4,  95}, { 21,  13, 119}, { 10,  26, 144}, {  2,  43, 168},
+    {  0,  64, 191}, {  2,  87, 212}, { 10, 111, 229}, { 21, 136, 242},
+    { 37, 160, 251}, { 57, 184, 255}, { 79, 205, 254}, {103, 223, 248},
+    {127, 238, 238}, {152, 248, 223}, {176, 254, 205}, {198, 255, 184},
+    {218, 251, 160}, {234, 242, 136}, {245, 229, 111}, {253, 212,  87},
+};
+
+static constexpr colour_t ocean_colours[] = {
+    {  0,   7, 100}, { 32, 107, 203}, {237, 255, 255}, {255, 170,   0}, {  0,   2,   0},
+};
+
+static constexpr colour_t fire_colours[] = {
+    {  0,   0,   0}, {128,   0,   0}, {255,  64,   0}, {255, 200,   0}, {255, 255, 224}, {255, 200,   0}, {128,  16,   0},
+};
+
+static constexpr colour_t grey_colours[] = {
+    {  0,   0,   0}, {255, 255, 255},
+};
+
+template <size_t N>
+static palette_t make_palette(const char* name, const colour_t (&colours)[N])
+{
+    return palette_t{name, std::vector<colour_t>(colours, colours + N)};
+}
+
+uint64_t palette_t::hash(void) const
+{
+    // FNV-1a over the colour count, least significant byte first, and the colours
+    uint8_t count[sizeof(uint64_t)];
+    for (size_t i = 0; i < sizeof(uint64_t); i++)
+        count[i] = (uint8_t)((uint64_t)colours.size() >> (8 * i));
+    uint64_t result = fnv1a(FNV_OFFSET, count, sizeof(count));
+    for (const colour_t& colour : colours) {
+        const uint8_t rgb[3] = {colour.r, colour.g, colour.b};
+        result = fnv1a(result, rgb, sizeof(rgb));
+    }
+    return result;
+}
+
+const std::vector<palette_t>& builtin_palettes(void)
+{
+    static const std::vector<palette_t> palettes = {
+        make_palette("cosine", cosine_colours),
+        make_palette("ocean",  ocean_colours),
+        make_palette("fire",   fire_colours),
+        make_palette("grey",   grey_colours),
+    };
+    return palettes;
+}
+
+bool load_palette(const std::string& path, palette_t& palette)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "[PALETTE] [ERR]: \"Unable to open " << path << "\"" << std::endl;
+        return false;
+    }
+
+    std::vector<colour_t> colours;
+    std::string line;
+    for (size_t line_nr = 1; std::getline(file, line); line_nr++) {
+        line = line.substr(0, line.find("//"));
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        std::istringstream stream(line);
+        unsigned int r, g, b;
+        std::string hex;
+        if (stream >> std::ws && stream.peek() == '#') {
+            stream >> hex;
+            if (hex.size() != 7 || hex.find_first_not_of("0123456789abcdefABCDEF", 1) != std::string::npos) {
+                std::cout << "[PALETTE] [ERR]: \"" << path << ":" << line_nr << " expected #rrggbb\"" << std::endl;
+                return false;
+            }
+            unsigned long value = std::stoul(hex.substr(1), nullptr, 16);
+            r = (value >> 16) & 0xFF;
+            g = (value >>  8) & 0xFF;
+            b =  value        & 0xFF;
+        } else if (!(stream >> r >> g >> b) || r > 255 || g > 255 || b > 255) {
+            std::cout << "[PALETTE] [ERR]: \"" << path << ":" << line_nr << " expected r g b in 0-255\"" << std::endl;
+            return false;
+        }
+        colours.push_back({(uint8_t)r, (uint8_t)g, (uint8_t)b});
+    }
+
+    if (colours.empty()) {
+        std::cout << "[PALETTE] [ERR]: \"" << path << " contains no colours\"" << std::endl;
+        return false;
+    }
+
+    size_t name_start = path.find_last_of("\\/");
+    palette.name = name_start == std::string::npos ? path : path.substr(name_start + 1);
+    palette.colours = std::move(colours);
+    return true;
+}
+
+colour_t palette_colour(const palette_t& palette, double position)
+{
+    // the palette is a cycle so the last colour blends back into the first
+    const size_t count = palette.colours.size();
+    position = (position - std::floor(position)) * count;
+    size_t index = (size_t)position % count;
+    const colour_t& a = palette.colours[index];
+    const colour_t& b = palette.colours[(index + 1) % count];
+    double t = position - (size_t)position;
+
+    return {(uint8_t)(a.r + (b.r - a.r) * t + 0.5), (uint8_t)(a.g + (b.g - a.g) * t + 0.5),
+        (uint8_t)(a.b + (b.b - a.b) * t + 0.5)};
+}
+
+void colour_iterations(const palette_t& palette, float period, const float* iterations, size_t stride, size_t count,
+    uint8_t* rgb)
+{
+    for (size_t i = 0; i < count; i++, iterations += stride, rgb += 3) {
+        // INTERIOR of mandelbrot.glsl
+        colour_t colour = *iterations <= -1.0f ? colour_t{0, 0, 0} : palette_colour(palette, *iterations / period);
+        rgb[0] = colour.r;
+        rgb[1] = colour.g;
+        rgb[2] = colour.b;
+    }
+}
+
+std::vector<uint8_t> bake_palette(const palette_t& palette, size_t entries)
+{
+    std::vector<uint8_t> texels(entries * 4);
+    for (size_t i = 0; i < entries; i++) {
+        // texel centres
+        colour_t colour = palette_colour(palette, (i + 0.5) / entries);
+        texels[4 * i + 0] = colour.r;
+        texels[4 * i + 1] = colour.g;
+        texels[4 * i + 2] = colour.b;
+        texels[4 * i + 3] = 255;
+    }
+    return texels;
+}
+
+palette_cache_t::~palette_cache_t()
+{
+    for (const auto& entry : textures)
+        glDeleteTextures(1, &entry.second);
+}
+
+unsigned int palette_cache_t::texture(const palette_t& palette)
+{
+    uint64_t key = palette.hash();
+    auto cached = textures.find(key);
+    if (cached != textures.end())
+        return cached->second;
+
+    int max_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    size_t entries = std::clamp(palette.colours.size() * TEXELS_PER_COLOUR, MIN_TEXELS, (size_t)max_size);
+    std::vector<uint8_t> texels = bake_palette(palette, entries);
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, (int)entries, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_REPEAT); // the palette cycles
+    glBindTexture(GL_TEXTURE_1D, 0);
+
+    textures.emplace(key, texture);
+    return texture;
+}
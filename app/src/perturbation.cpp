@@ -0,0 +1,172 @@
+#include "perturbation.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "cpu_engine.hpp"
+
+// inside the main cardioid or the period 2 bulb by far more than the doubles of c are off, like inside_main_bulbs of
+// cpu_engine.cpp, pixels of a deep view along the boundary still iterate
+static bool clearly_inside_main_bulbs(double c_r, double c_i)
+{
+    constexpr double MARGIN = 1e-9;
+    double x = c_r - 0.25;
+    double y_sqr = c_i * c_i;
+    double q = x * x + y_sqr;
+    double bulb_x = c_r + 1.0;
+    return q * (q + x) < 0.25 * y_sqr - MARGIN || bulb_x * bulb_x + y_sqr < 0.0625 - MARGIN;
+}
+
+reference_orbit_t::reference_orbit_t(const arb_prec_t& centre_x, const arb_prec_t& centre_y, int max_iterations,
+    double max_delta) :
+    centre_x(centre_x), centre_y(centre_y), max_iterations(max_iterations)
+{
+    auto values = std::make_shared<std::vector<double>>();
+    values->reserve(2 * ((size_t)max_iterations + 1));
+    values->push_back(0.0);
+    values->push_back(0.0);
+
+    arb_prec_t z_r(0.0f), z_i(0.0f);
+    for (int n = 0; n < max_iterations; n++) {
+        arb_prec_t z_r_next = z_r * z_r;
+        z_r_next -= z_i * z_i;
+        z_r_next += this->centre_x;
+        z_i *= z_r;
+        z_i *= 2.0f;
+        z_i += this->centre_y;
+        z_r = z_r_next;
+
+        double r = z_r.to_double(), i = z_i.to_double();
+        values->push_back(r);
+        values->push_back(i);
+        if (r * r + i * i >= cpu_engine::BAILOUT_SQR)
+            break;
+    }
+    orbit = values;
+    build_bla(max_delta);
+}
+
+reference_orbit_t::reference_orbit_t(const arb_prec_t& centre_x, const arb_prec_t& centre_y, int max_iterations,
+    std::vector<double> orbit, double max_delta) :
+    centre_x(centre_x), centre_y(centre_y), max_iterations(max_iterations),
+    orbit(std::make_shared<const std::vector<double>>(std::move(orbit)))
+{
+    build_bla(max_delta);
+}
+
+reference_orbit_t::reference_orbit_t(const reference_orbit_t& other, double max_delta) :
+    centre_x(other.centre_x), centre_y(other.centre_y), max_iterations(other.max_iterations), orbit(other.orbit)
+{
+    build_bla(max_delta);
+}
+
+std::shared_ptr<const reference_orbit_t> reference_orbit_t::with_reach(double max_delta) const
+{
+    return std::shared_ptr<const reference_orbit_t>(new reference_orbit_t(*this, max_delta));
+}
+
+void reference_orbit_t::build_bla(double max_delta)
+{
+    // single steps from m = 1, Z_0 = 0 makes the step from 0 purely quadratic
+    const std::vector<double>& orbit = *this->orbit;
+    const size_t steps = length();
+    std::vector<double> radius;
+    std::vector<bla_t> level;
+    for (size_t m = 1; m < steps; m++) {
+        double z_r = orbit[2 * m], z_i = orbit[2 * m + 1];
+        radius.push_back(BLA_EPSILON * std::hypot(z_r, z_i));
+        level.push_back({2.0 * z_r, 2.0 * z_i, 1.0, 0.0, 0.0});
+    }
+
+    // x followed by y: A = A_y A_x, B = A_y B_x + B_y, valid while x is and while the dz x hands on stays in y's radius
+    while (!level.empty()) {
+        for (size_t j = 0; j < level.size(); j++)
+            level[j].radius_sqr = radius[j] * radius[j];
+        levels.push_back(level);
+
+        std::vector<bla_t> merged(level.size() / 2);
+        std::vector<double> merged_radius(merged.size());
+        for (size_t j = 0; j < merged.size(); j++) {
+            const bla_t& x = level[2 * j];
+            const bla_t& y = level[2 * j + 1];
+            merged[j].a_r = y.a_r * x.a_r - y.a_i * x.a_i;
+            merged[j].a_i = y.a_r * x.a_i + y.a_i * x.a_r;
+            merged[j].b_r = y.a_r * x.b_r - y.a_i * x.b_i + y.b_r;
+            merged[j].b_i = y.a_r * x.b_i + y.a_i * x.b_r + y.b_i;
+            double a_x = std::hypot(x.a_r, x.a_i), b_x = std::hypot(x.b_r, x.b_i);
+            double handed_on = a_x > 0.0 ? std::max(0.0, (radius[2 * j + 1] - b_x * max_delta) / a_x) : 0.0;
+            merged_radius[j] = std::min(radius[2 * j], handed_on);
+        }
+        level.swap(merged);
+        radius.swap(merged_radius);
+    }
+}
+
+void reference_orbit_t::iterate(double dc_r, double dc_i, float* pixel) const
+{
+    pixel[0] = cpu_engine::INTERIOR;
+    pixel[1] = 0.0f;
+
+    // Z_1 is the centre of the reference in doubles
+    const std::vector<double>& orbit = *this->orbit;
+    if (orbit.size() > 2 && clearly_inside_main_bulbs(orbit[2] + dc_r, orbit[3] + dc_i))
+        return;
+
+    const size_t end = length();
+    double dz_r = 0.0, dz_i = 0.0;
+    size_t m = 0;
+    int n = 0;
+    while (n < max_iterations) {
+        double z_r = orbit[2 * m] + dz_r, z_i = orbit[2 * m + 1] + dz_i;
+        double r_sqr = z_r * z_r + z_i * z_i;
+        if (r_sqr >= cpu_engine::BAILOUT_SQR) {
+            // log-log smoothing, smooth_iteration of mandelbrot.glsl
+            pixel[0] = (float)(n + 1.0 - std::log2(std::log(r_sqr) / std::log(cpu_engine::BAILOUT_SQR)));
+            pixel[1] = (float)r_sqr;
+            return;
+        }
+
+        double dz_sqr = dz_r * dz_r + dz_i * dz_i;
+        if (m > 0 && (r_sqr < dz_sqr || m == end)) {
+            // rebase, the pixel continues from the start of the orbit with its full value as the difference
+            dz_r = z_r;
+            dz_i = z_i;
+            m = 0;
+            continue;
+        }
+
+        // longest valid run starting here, runs of 2^k start at m - 1 aligned to 2^k
+        bool skipped = false;
+        if (m > 0 && !levels.empty()) {
+            size_t j = m - 1;
+            int top = (int)levels.size() - 1;
+            for (int k = j ? std::min(std::countr_zero(j), top) : top; k >= 0; k--) {
+                size_t index = j >> k;
+                size_t run = (size_t)1 << k;
+                if (index >= levels[k].size() || n + (int)run > max_iterations)
+                    continue;
+                const bla_t& bla = levels[k][index];
+                if (dz_sqr >= bla.radius_sqr)
+                    continue;
+                double next_r = bla.a_r * dz_r - bla.a_i * dz_i + bla.b_r * dc_r - bla.b_i * dc_i;
+                dz_i = bla.a_r * dz_i + bla.a_i * dz_r + bla.b_r * dc_i + bla.b_i * dc_r;
+                dz_r = next_r;
+                m += run;
+                n += (int)run;
+                skipped = true;
+                break;
+            }
+        }
+        if (skipped)
+            continue;
+
+        // dz' = 2 Z dz + dz^2 + dc
+        double Z_r = orbit[2 * m], Z_i = orbit[2 * m + 1];
+        double next_r = 2.0 * (Z_r * dz_r - Z_i * dz_i) + (dz_r * dz_r - dz_i * dz_i) + dc_r;
+        dz_i = 2.0 * (Z_r * dz_i + Z_i * dz_r) + 2.0 * dz_r * dz_i + dc_i;
+        dz_r = next_r;
+        m++;
+        n++;
+    }
+}
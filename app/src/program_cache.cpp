@@ -0,0 +1,115 @@
+#include "program_cache.hpp"
+
+#include "gl_ext.hpp"
+#include "util.hpp"
+
+#include <fstream>
+#include <cstdio>
+
+program_cache_t::program_cache_t(const std::string& directory, bool available) :
+    directory(available ? directory : std::string())
+{
+    if (!this->directory.empty())
+        driver = gl_driver();
+}
+
+std::string program_cache_t::default_directory(void)
+{
+    return user_cache_directory("programs");
+}
+
+uint64_t program_cache_t::source_hash(const std::vector<stage_t>& stages)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (const stage_t& stage : stages) {
+        hash = fnv1a(hash, &stage.type, sizeof(stage.type));
+        hash = fnv1a(hash, stage.source, std::char_traits<char>::length(stage.source) + 1); // the 0 separates stages
+    }
+    return hash;
+}
+
+std::string program_cache_t::path(uint64_t source_hash) const
+{
+    // the driver is part of the name as well, several GPUs or drivers can share one cache
+    char name[40];
+    uint64_t key = fnv1a(source_hash, driver.data(), driver.size());
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return directory + "/" + name;
+}
+
+unsigned int program_cache_t::load(const std::vector<stage_t>& stages) const
+{
+    if (directory.empty())
+        return 0;
+
+    uint64_t hash = source_hash(stages);
+    std::ifstream file(path(hash), std::ios::binary);
+    if (!file)
+        return 0;
+
+    uint32_t magic = 0, version = 0, driver_length = 0, format = 0, length = 0;
+    uint64_t stored_hash = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&stored_hash, sizeof(stored_hash));
+    file.read((char*)&driver_length, sizeof(driver_length));
+    if (!file || magic != MAGIC || version != VERSION || stored_hash != hash || driver_length != driver.size())
+        return 0;
+
+    std::string stored_driver(driver_length, '\0');
+    file.read(stored_driver.data(), driver_length);
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+    if (!file || stored_driver != driver)
+        return 0;
+
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if (!file)
+        return 0;
+
+    // a driver may still refuse a binary it wrote itself, e.g. after an update that kept the version string
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei)length);
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void program_cache_t::prepare(unsigned int program) const
+{
+    if (!directory.empty())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void program_cache_t::store(unsigned int program, const std::vector<stage_t>& stages) const
+{
+    if (directory.empty())
+        return;
+
+    int length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    uint64_t hash = source_hash(stages);
+    write_atomically(path(hash), [&](std::ostream& file) {
+        uint32_t magic = MAGIC, version = VERSION, driver_length = (uint32_t)driver.size();
+        uint32_t binary_format = format, binary_length = (uint32_t)length;
+        file.write((const char*)&magic, sizeof(magic));
+        file.write((const char*)&version, sizeof(version));
+        file.write((const char*)&hash, sizeof(hash));
+        file.write((const char*)&driver_length, sizeof(driver_length));
+        file.write(driver.data(), driver.size());
+        file.write((const char*)&binary_format, sizeof(binary_format));
+        file.write((const char*)&binary_length, sizeof(binary_length));
+        file.write(binary.data(), length);
+    }, "CACHE");
+}
@@ -0,0 +1,186 @@
+#include "pyramid.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "image_writer.hpp"
+#include "perturbation.hpp"
+#include "tiered_program.hpp"
+#include "tile_renderer.hpp"
+
+// one resolution of the pyramid, every level spans the same extent from the same top left corner
+struct pyramid_level_t {
+    int index;
+    arb_prec_t pixel;           // spacing of the pixels in the complex plane
+    int width, height;          // pixels of the level image
+    std::string directory;
+};
+
+// path of a tile, its directory exists once the level started
+static std::string tile_path(const pyramid_options_t& options, const pyramid_level_t& level, int column, int row)
+{
+    if (options.layout == pyramid_options_t::layout_t::DZI)
+        return level.directory + "/" + std::to_string(column) + "_" + std::to_string(row) + ".png";
+    return level.directory + "/" + std::to_string(column) + "/" + std::to_string(row) + ".png";
+}
+
+// renders a tile and writes it under a temporary name, which is renamed once the file is complete
+static bool write_tile(tile_renderer_t& renderer, const pyramid_options_t& options, const pyramid_level_t& level,
+    const arb_prec_t& corner_x, const arb_prec_t& corner_y, int column, int row, const std::string& path)
+{
+    const int tile = options.tile_size;
+    arb_prec_t half_pixel = arb_prec_t(level.pixel).divide(2);
+    arb_prec_t x = arb_prec_t(corner_x) + arb_prec_t(half_pixel).multiply((unsigned int)(2 * column * tile + tile));
+    arb_prec_t y = arb_prec_t(corner_y) - arb_prec_t(half_pixel).multiply((unsigned int)(2 * row * tile + tile));
+    std::vector<float> iterations = renderer.render(x, y, level.pixel, tile);
+    if (iterations.empty())
+        return false;
+
+    // edge tiles are cropped to the level image, tile rows come bottom up
+    image_band_t band;
+    const int columns = std::min(tile, level.width - column * tile);
+    band.rows = std::min(tile, level.height - row * tile);
+    band.rgb.resize(3 * (size_t)columns * band.rows);
+    for (int tile_row = 0; tile_row < band.rows; tile_row++) {
+        const float* source = &iterations[2 * (size_t)(tile - 1 - tile_row) * tile];
+        colour_iterations(options.palette, options.palette_period, source, 2, columns,
+            &band.rgb[3 * (size_t)tile_row * columns]);
+    }
+
+    std::string partial = path.substr(0, path.size() - 4) + ".part.png";
+    std::unique_ptr<image_writer_t> writer = image_writer_t::open(partial, columns, band.rows);
+    if (!writer || !writer->write(std::move(band)) || !writer->close())
+        return false;
+    std::error_code error;
+    std::filesystem::rename(partial, path, error);
+    return !error;
+}
+
+static bool write_descriptor(const pyramid_options_t& options)
+{
+    std::ofstream file(options.path);
+    if (!file) {
+        std::cout << "[PYRAMID] [ERR]: \"Could not create " << options.path << "\"" << std::endl;
+        return false;
+    }
+    file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"0\" TileSize=\""
+        << options.tile_size << "\">\n"
+        << "  <Size Width=\"" << options.width << "\" Height=\"" << options.height << "\"/>\n"
+        << "</Image>\n";
+    return (bool)file;
+}
+
+bool write_pyramid(const pyramid_options_t& options)
+{
+    const bool dzi = options.layout == pyramid_options_t::layout_t::DZI;
+    const int tile = options.tile_size;
+
+    // pixels of the full image, XYZ level 0 is a single tile
+    const int width = dzi ? options.width : tile;
+    const int height = dzi ? options.height : tile;
+    arb_prec_t pixel = arb_prec_t(options.extent).divide((unsigned int)width);
+    arb_prec_t corner_x = arb_prec_t(options.centre_x) - arb_prec_t(pixel).multiply((unsigned int)width).divide(2);
+    arb_prec_t corner_y = arb_prec_t(options.centre_y) + arb_prec_t(pixel).multiply((unsigned int)height).divide(2);
+
+    std::string root = options.path;
+    int deepest = options.levels;
+    if (dzi) {
+        if (options.path.size() < 4 || options.path.substr(options.path.size() - 4) != ".dzi") {
+            std::cout << "[PYRAMID] [ERR]: \"DZI pyramids are written to a .dzi descriptor\"" << std::endl;
+            return false;
+        }
+        // the descriptor goes first, viewers show what exists of a partial pyramid
+        root = options.path.substr(0, options.path.size() - 4) + "_files";
+        deepest = (int)std::ceil(std::log2((double)std::max(width, height)));
+        if (!write_descriptor(options))
+            return false;
+    }
+
+    // one orbit at the location for every tile of every level, each level spans the whole extent
+    double reach = 0.5 * pixel.to_double() * std::hypot((double)width, (double)height);
+    auto start = std::chrono::steady_clock::now();
+    auto reference = std::make_shared<const reference_orbit_t>(options.centre_x, options.centre_y,
+        options.max_iterations, reach);
+    std::cout << "[PYRAMID] reference orbit of " << reference->length() << " iterations in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+
+    const int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<tile_renderer_t>> renderers;
+    for (int i = 0; i < threads; i++)
+        renderers.push_back(std::make_unique<perturbation_tile_renderer_t>(reference, 1));
+
+    for (int index = 0; index <= deepest; index++) {
+        pyramid_level_t level;
+        level.index = index;
+        level.directory = root + "/" + std::to_string(index);
+        if (dzi) {
+            // every level below the full image halves it, rounding up
+            unsigned int scale = 1u << (deepest - index);
+            level.pixel = arb_prec_t(pixel).multiply(scale);
+            level.width = (int)((width + scale - 1) / scale);
+            level.height = (int)((height + scale - 1) / scale);
+        } else {
+            level.pixel = arb_prec_t(pixel).divide(1u << index);
+            level.width = level.height = tile << index;
+        }
+        arb_prec_t tile_zoom = tile_renderer_t::tile_zoom(level.pixel, tile);
+        if (tiered_program_t::required_bits(tile_zoom, tile, tile) > reference_orbit_t::FRACTION_BITS)
+            std::cout << "[PYRAMID] [WARN]: \"Level " << index << " needs more than "
+                << reference_orbit_t::FRACTION_BITS << " fraction bits, expect blocks\"" << std::endl;
+
+        const int columns = (level.width + tile - 1) / tile, rows = (level.height + tile - 1) / tile;
+        std::error_code error;
+        std::filesystem::create_directories(level.directory, error);
+        for (int column = 0; !dzi && column < columns; column++)
+            std::filesystem::create_directories(level.directory + "/" + std::to_string(column), error);
+        if (error) {
+            std::cout << "[PYRAMID] [ERR]: \"Could not create " << level.directory << "\"" << std::endl;
+            return false;
+        }
+
+        // workers take the tiles of the level in order, the level is done when all of them joined
+        std::atomic<size_t> next{0};
+        std::atomic<int> written{0}, skipped{0};
+        std::atomic<bool> failed{false};
+        auto work = [&](tile_renderer_t* renderer) {
+            for (size_t i = next++; i < (size_t)columns * rows && !failed; i = next++) {
+                int column = (int)(i % columns), row = (int)(i / columns);
+                std::string path = tile_path(options, level, column, row);
+                if (std::filesystem::exists(path)) {
+                    skipped++;
+                    continue;
+                }
+                if (write_tile(*renderer, options, level, corner_x, corner_y, column, row, path)) {
+                    written++;
+                } else {
+                    std::cout << "[PYRAMID] [ERR]: \"Could not write " << path << "\"" << std::endl;
+                    failed = true;
+                }
+            }
+        };
+        auto level_start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(work, renderers[i].get());
+        work(renderers[0].get());
+        for (std::thread& worker : workers)
+            worker.join();
+        if (failed)
+            return false;
+
+        std::cout << "[PYRAMID] level " << index << " of " << deepest << ": " << level.width << "x" << level.height
+            << ", " << written << " tiles written, " << skipped << " already there, "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - level_start).count() << " s"
+            << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#include "render_cache.hpp"
+
+render_cache_t::render_cache_t(size_t max_bytes) : max_bytes(max_bytes)
+{
+}
+
+render_cache_t::value_t render_cache_t::get(const std::string& key, const std::function<value_t(void)>& render,
+    source_t* source)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        order.splice(order.begin(), order, found->second.order);
+        counters.hits++;
+        if (source)
+            *source = source_t::HIT;
+        return found->second.value;
+    }
+    auto pending = rendering.find(key);
+    if (pending != rendering.end()) {
+        std::shared_future<value_t> result = pending->second;
+        counters.coalesced++;
+        lock.unlock();
+        if (source)
+            *source = source_t::COALESCED;
+        return result.get();
+    }
+
+    // this thread renders, the ones asking for the key meanwhile wait on the future
+    std::promise<value_t> promise;
+    rendering.emplace(key, promise.get_future().share());
+    counters.misses++;
+    lock.unlock();
+    if (source)
+        *source = source_t::MISS;
+
+    value_t value = render();
+
+    lock.lock();
+    rendering.erase(key);
+    if (value)
+        insert(key, value);
+    lock.unlock();
+    promise.set_value(value);
+    return value;
+}
+
+void render_cache_t::insert(const std::string& key, const value_t& value)
+{
+    if (value->size() > max_bytes)
+        return;
+    order.push_front(key);
+    entries[key] = {value, order.begin()};
+    counters.bytes += value->size();
+    while (counters.bytes > max_bytes) {
+        auto oldest = entries.find(order.back());
+        counters.bytes -= oldest->second.value->size();
+        entries.erase(oldest);
+        order.pop_back();
+        counters.evictions++;
+    }
+}
+
+render_cache_t::stats_t render_cache_t::stats(void)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    stats_t stats = counters;
+    stats.entries = entries.size();
+    return stats;
+}
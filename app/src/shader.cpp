@@ -0,0 +1,187 @@
+#include "shader.hpp"
+
+#include "gl_ext.hpp"
+#include "gen_shaders.h"
+
+#include <iostream>
+
+static const char* stage_name(unsigned int type)
+{
+    switch (type) {
+        case GL_VERTEX_SHADER:   return "vertex";
+        case GL_FRAGMENT_SHADER: return "fragment";
+        case GL_COMPUTE_SHADER:  return "compute";
+        default:                 return "unknown";
+    }
+}
+
+// only queued, the status is not asked for so a parallel compiling driver is not made to wait
+static unsigned int compile_shader(unsigned int type, const char* source)
+{
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+static bool check_compile(unsigned int shader, unsigned int type)
+{
+    int success;
+    char infoLog[512];
+
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success); // check compile output
+    if(!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "[GL] [ERR]: \"Failed to compile " << stage_name(type) << " shader\", " << infoLog << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// GLSL has no #include, libraries go right after the #version line so the stage can use everything they declare
+static std::string splice_libraries(const char* source, std::initializer_list<const char*> libraries)
+{
+    std::string spliced = source;
+    size_t version = spliced.find("#version");
+    size_t line_end = version == std::string::npos ? 0 : spliced.find('\n', version);
+    size_t position = line_end == std::string::npos ? spliced.size() : line_end + 1;
+    for (const char* library : libraries) {
+        std::string text = library;
+        text += '\n';
+        spliced.insert(position, text);
+        position += text.size();
+    }
+    return spliced;
+}
+
+static bool check_link(unsigned int program)
+{
+    int success;
+    char infoLog[512];
+
+    glGetProgramiv(program, GL_LINK_STATUS, &success); // check link output
+    if(!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "[GL] [ERR]: \"Failed to link shaders\", " << infoLog << std::endl;
+        return false;
+    }
+    return true;
+}
+
+program_build_t::program_build_t(std::vector<std::pair<unsigned int, std::string>> stages,
+    const program_cache_t* cache) :
+    program(0), stages(std::move(stages)), cache(cache), cached(false)
+{
+    if (cache) {
+        program = cache->load(cache_stages());
+        cached = program != 0;
+        if (cached)
+            return;
+    }
+
+    // compile and link are queued back to back, a failed compile shows up as a failed link
+    program = glCreateProgram();
+    if (cache)
+        cache->prepare(program);
+    for (const auto& stage : this->stages) {
+        shaders.push_back(compile_shader(stage.first, stage.second.c_str()));
+        glAttachShader(program, shaders.back());
+    }
+    glLinkProgram(program);
+}
+
+program_build_t::~program_build_t()
+{
+    for (unsigned int shader : shaders)
+        glDeleteShader(shader);
+    glDeleteProgram(program); // ignores 0, finish() hands the program over
+}
+
+std::vector<program_cache_t::stage_t> program_build_t::cache_stages(void) const
+{
+    std::vector<program_cache_t::stage_t> cache_stages;
+    for (const auto& stage : stages)
+        cache_stages.push_back({stage.first, stage.second.c_str()});
+    return cache_stages;
+}
+
+bool program_build_t::ready(void) const
+{
+    if (cached || !program)
+        return true;
+    if (!glMaxShaderCompilerThreadsKHR)
+        return false; // no way to ask without stalling
+    int complete = GL_FALSE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+unsigned int program_build_t::finish(void)
+{
+    if (!cached && program) {
+        bool compiled = true;
+        for (size_t i = 0; i < shaders.size(); i++)
+            compiled = check_compile(shaders[i], stages[i].first) && compiled;
+
+        // clean up the shaders, as program has been linked, so individual units are no longer necessary
+        for (unsigned int shader : shaders)
+            glDeleteShader(shader);
+        shaders.clear();
+
+        if (!compiled || !check_link(program)) {
+            glDeleteProgram(program);
+            program = 0;
+        } else if (cache) {
+            cache->store(program, cache_stages());
+        }
+    }
+
+    unsigned int finished = program;
+    program = 0;
+    return finished;
+}
+
+std::unique_ptr<program_build_t> start_program(const char* vertex_source, const char* fragment_source,
+    std::initializer_list<const char*> fragment_libraries, const program_cache_t* cache)
+{
+    return std::make_unique<program_build_t>(std::vector<std::pair<unsigned int, std::string>>{
+        {GL_VERTEX_SHADER, vertex_source}, {GL_FRAGMENT_SHADER, splice_libraries(fragment_source, fragment_libraries)}},
+        cache);
+}
+
+std::unique_ptr<program_build_t> start_compute_program(const char* compute_source,
+    std::initializer_list<const char*> libraries, const program_cache_t* cache)
+{
+    return std::make_unique<program_build_t>(std::vector<std::pair<unsigned int, std::string>>{
+        {GL_COMPUTE_SHADER, splice_libraries(compute_source, libraries)}}, cache);
+}
+
+feature_set_t default_features(void)
+{
+    feature_set_t features = 0;
+    for (unsigned int i = 0; i < GSV::shader_feature_count; i++)
+        if (GSV::shader_features[i].enabled)
+            features |= 1u << i;
+    return features;
+}
+
+std::string feature_defines(feature_set_t features)
+{
+    std::string defines;
+    for (unsigned int i = 0; i < GSV::shader_feature_count; i++)
+        if (features & (1u << i))
+            defines += std::string("#define ") + GSV::shader_features[i].define + "\n";
+    return defines;
+}
+
+unsigned int build_program(const char* vertex_source, const char* fragment_source,
+    std::initializer_list<const char*> fragment_libraries, const program_cache_t* cache)
+{
+    return start_program(vertex_source, fragment_source, fragment_libraries, cache)->finish();
+}
+
+unsigned int build_compute_program(const char* compute_source, std::initializer_list<const char*> libraries,
+    const program_cache_t* cache)
+{
+    return start_compute_program(compute_source, libraries, cache)->finish();
+}
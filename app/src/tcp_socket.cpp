@@ -0,0 +1,205 @@
+#include "tcp_socket.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <unistd.h>
+#endif
+
+// Winsock needs starting once per process, everything else needs nothing
+static bool started(void)
+{
+#ifdef _WIN32
+    static const bool started = [] { WSADATA data; return WSAStartup(MAKEWORD(2, 2), &data) == 0; }();
+    return started;
+#else
+    return true;
+#endif
+}
+
+static bool make_address(const std::string& address, int port, sockaddr_in& result)
+{
+    result = {};
+    result.sin_family = AF_INET;
+    result.sin_port = htons((uint16_t)port);
+    return port > 0 && port <= 65535 && inet_pton(AF_INET, address.c_str(), &result.sin_addr) == 1;
+}
+
+tcp::socket_t tcp::listen(const std::string& address, int port)
+{
+    sockaddr_in endpoint;
+    if (!started() || !make_address(address, port, endpoint))
+        return -1;
+    socket_t listener = (socket_t)::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener < 0)
+        return -1;
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    if (::bind(listener, (const sockaddr*)&endpoint, sizeof(endpoint)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+tcp::socket_t tcp::accept(socket_t listener)
+{
+    socket_t connection = (socket_t)::accept(listener, nullptr, nullptr);
+    return connection < 0 ? -1 : connection;
+}
+
+tcp::socket_t tcp::connect(const std::string& address, int port)
+{
+    sockaddr_in endpoint;
+    if (!started() || !make_address(address, port, endpoint))
+        return -1;
+    socket_t connection = (socket_t)::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (connection < 0)
+        return -1;
+    if (::connect(connection, (const sockaddr*)&endpoint, sizeof(endpoint)) != 0) {
+        close(connection);
+        return -1;
+    }
+    return connection;
+}
+
+bool tcp::pair(socket_t& first, socket_t& second)
+{
+    // a listener on a port of the system's choosing, accepting the one connection made to it
+    first = second = -1;
+    sockaddr_in endpoint = {};
+    endpoint.sin_family = AF_INET;
+    endpoint.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(endpoint);
+    socket_t listener = started() ? (socket_t)::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP) : -1;
+    if (listener < 0)
+        return false;
+    if (::bind(listener, (const sockaddr*)&endpoint, sizeof(endpoint)) == 0 && ::listen(listener, 1) == 0 &&
+        ::getsockname(listener, (sockaddr*)&endpoint, &length) == 0) {
+        first = (socket_t)::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (first >= 0 && ::connect(first, (const sockaddr*)&endpoint, sizeof(endpoint)) == 0)
+            second = accept(listener);
+    }
+    close(listener);
+    if (second < 0) {
+        if (first >= 0)
+            close(first);
+        first = -1;
+        return false;
+    }
+    set_no_delay(first);
+    return true;
+}
+
+bool tcp::send_all(socket_t socket, const void* data, size_t size)
+{
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+#ifdef _WIN32
+        int sent = ::send((SOCKET)socket, bytes, (int)std::min(size, (size_t)1 << 30), 0);
+#else
+        ssize_t sent = ::send((int)socket, bytes, size, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0)
+            return false;
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+long tcp::receive(socket_t socket, void* data, size_t size)
+{
+#ifdef _WIN32
+    int received = ::recv((SOCKET)socket, (char*)data, (int)std::min(size, (size_t)1 << 30), 0);
+#else
+    ssize_t received = ::recv((int)socket, data, size, 0);
+#endif
+    return received < 0 ? -1 : (long)received;
+}
+
+bool tcp::receive_all(socket_t socket, void* data, size_t size)
+{
+    char* bytes = (char*)data;
+    while (size > 0) {
+        long received = receive(socket, bytes, size);
+        if (received <= 0)
+            return false;
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+bool tcp::wait_readable(const std::vector<socket_t>& sockets, int milliseconds, std::vector<bool>& readable)
+{
+    std::vector<pollfd> polled(sockets.size());
+    for (size_t i = 0; i < sockets.size(); i++) {
+        polled[i].fd = (decltype(pollfd::fd))sockets[i];
+        polled[i].events = POLLIN;
+    }
+#ifdef _WIN32
+    int result = WSAPoll(polled.data(), (ULONG)polled.size(), milliseconds);
+#else
+    int result = ::poll(polled.data(), (nfds_t)polled.size(), milliseconds);
+#endif
+    readable.assign(sockets.size(), false);
+    for (size_t i = 0; i < sockets.size() && result > 0; i++)
+        readable[i] = (polled[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+    return result >= 0;
+}
+
+void tcp::set_timeout(socket_t socket, int milliseconds)
+{
+#ifdef _WIN32
+    DWORD timeout = (DWORD)milliseconds;
+#else
+    timeval timeout = {milliseconds / 1000, (milliseconds % 1000) * 1000};
+#endif
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+void tcp::set_no_delay(socket_t socket)
+{
+    int no_delay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+}
+
+void tcp::shutdown(socket_t socket)
+{
+#ifdef _WIN32
+    ::shutdown((SOCKET)socket, SD_BOTH);
+#else
+    ::shutdown((int)socket, SHUT_RDWR);
+#endif
+}
+
+void tcp::close(socket_t socket)
+{
+#ifdef _WIN32
+    closesocket((SOCKET)socket);
+#else
+    ::close((int)socket);
+#endif
+}
+
+bool tcp::parse_endpoint(const std::string& text, std::string& address, int& port)
+{
+    size_t colon = text.rfind(':');
+    address = colon == std::string::npos ? "127.0.0.1" : text.substr(0, colon);
+    std::string port_text = colon == std::string::npos ? text : text.substr(colon + 1);
+    char* end = nullptr;
+    port = (int)std::strtol(port_text.c_str(), &end, 10);
+    return !port_text.empty() && *end == '\0' && port > 0 && port <= 65535;
+}
@@ -0,0 +1,123 @@
+#include "tiered_program.hpp"
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include "gen_shaders.h"
+
+tiered_program_t::tiered_program_t(builder_t builder, linked_t linked) :
+    builder(builder), linked(linked), builds(GSV::precision_tier_count), programs(GSV::precision_tier_count, 0),
+    failed(GSV::precision_tier_count, false), current(0)
+{
+}
+
+tiered_program_t::~tiered_program_t()
+{
+    for (unsigned int program : programs)
+        glDeleteProgram(program); // ignores 0
+}
+
+unsigned int tiered_program_t::poll(size_t tier, bool wait)
+{
+    if (programs[tier] || failed[tier])
+        return programs[tier];
+    if (!builds[tier])
+        builds[tier] = builder(GSV::precision_tiers[tier].defines);
+    if (!wait && !builds[tier]->ready())
+        return 0;
+
+    programs[tier] = builds[tier]->finish();
+    builds[tier].reset();
+    failed[tier] = programs[tier] == 0;
+    if (failed[tier])
+        std::cout << "[GL] [ERR]: \"Precision tier " << name(tier) << " failed to build\"" << std::endl;
+    else
+        linked(programs[tier]);
+    return programs[tier];
+}
+
+// first tier that resolves the view and has not failed, the deepest one left when none resolves it
+size_t tiered_program_t::wanted(double bits) const
+{
+    size_t deepest = GSV::precision_tier_count;
+    for (size_t tier = 0; tier < GSV::precision_tier_count; tier++) {
+        if (failed[tier])
+            continue;
+        if (GSV::precision_tiers[tier].fraction_bits >= bits)
+            return tier;
+        if (deepest == GSV::precision_tier_count ||
+            GSV::precision_tiers[tier].fraction_bits > GSV::precision_tiers[deepest].fraction_bits)
+            deepest = tier;
+    }
+    return deepest; // deeper than any tier reaches, pixels start to merge
+}
+
+double tiered_program_t::required_bits(const arb_prec_t& zoom, int width, int height)
+{
+    // neighbouring pixels are zoom / size apart, c has to resolve that with GUARD_BITS to spare
+    double spacing = zoom.to_double() / std::max(std::max(width, height), 1);
+    return spacing > 0.0 ? std::ceil(-std::log2(spacing)) + GUARD_BITS : HUGE_VAL;
+}
+
+unsigned int tiered_program_t::program(const arb_prec_t& zoom, int width, int height, bool wait)
+{
+    double bits = required_bits(zoom, width, height);
+    for (size_t tier = wanted(bits); tier != GSV::precision_tier_count; tier = wanted(bits)) {
+        if (unsigned int program = poll(tier, wait)) {
+            current = tier;
+            return program;
+        }
+        if (failed[tier])
+            continue; // failed just now, the next one is wanted instead
+
+        // still being built, a linked tier that resolves the view as well does until then
+        for (size_t other = tier + 1; other < GSV::precision_tier_count; other++) {
+            if (programs[other] && GSV::precision_tiers[other].fraction_bits >= std::min(bits,
+                (double)GSV::precision_tiers[tier].fraction_bits)) {
+                current = other;
+                return programs[other];
+            }
+        }
+        return 0;
+    }
+    return 0;
+}
+
+size_t tiered_program_t::wanted_tier(const arb_prec_t& zoom, int width, int height) const
+{
+    return wanted(required_bits(zoom, width, height));
+}
+
+void tiered_program_t::prefetch(void)
+{
+    for (size_t tier = 0; tier < GSV::precision_tier_count; tier++) {
+        if (!programs[tier] && !failed[tier] && !builds[tier])
+            builds[tier] = builder(GSV::precision_tiers[tier].defines);
+    }
+}
+
+void tiered_program_t::collect(void)
+{
+    for (size_t tier = 0; tier < GSV::precision_tier_count; tier++) {
+        if (builds[tier] && builds[tier]->ready())
+            poll(tier, false);
+    }
+}
+
+bool tiered_program_t::building(void) const
+{
+    return std::any_of(builds.begin(), builds.end(), [](const auto& build) { return build != nullptr; });
+}
+
+bool tiered_program_t::broken(void) const
+{
+    return std::all_of(failed.begin(), failed.end(), [](bool tier_failed) { return tier_failed; });
+}
+
+const char* tiered_program_t::name(size_t tier)
+{
+    return GSV::precision_tiers[tier].name;
+}
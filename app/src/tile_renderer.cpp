@@ -0,0 +1,206 @@
+#include "tile_renderer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include "cpu_engine.hpp"
+#include "gl_ext.hpp"
+#include "iteration_cache.hpp"
+#include "shader.hpp"
+#include "gen_shaders.h"
+
+arb_prec_t tile_renderer_t::tile_zoom(const arb_prec_t& pixel, int size)
+{
+    return arb_prec_t(pixel) * arb_prec_t((float)size); // sizes are far below 2^24, exact as a float
+}
+
+// offset of tile pixel centres from the view centre in half pixels, k * pixel / 2 is exact for k below 2^24
+static arb_prec_t tile_centre(const arb_prec_t& centre, const arb_prec_t& half_pixel, int half_pixels)
+{
+    return arb_prec_t(centre) + arb_prec_t(half_pixel) * (float)half_pixels;
+}
+
+void tile_renderer_t::view_tile_centre(const arb_prec_t& centre_x, const arb_prec_t& centre_y,
+    const arb_prec_t& pixel, int width, int height, int tile, int tile_x, int tile_y, arb_prec_t& x, arb_prec_t& y)
+{
+    arb_prec_t half_pixel = arb_prec_t(pixel).divide(2);
+    x = tile_centre(centre_x, half_pixel, 2 * tile_x * tile + tile - width);
+    y = tile_centre(centre_y, half_pixel, height - 2 * tile_y * tile - tile);
+}
+
+bool tile_renderer_t::render_view_tile(const arb_prec_t& centre_x, const arb_prec_t& centre_y, const arb_prec_t& pixel,
+    int width, int height, int tile, int tile_x, int tile_y, float* values)
+{
+    arb_prec_t x, y;
+    view_tile_centre(centre_x, centre_y, pixel, width, height, tile, tile_x, tile_y, x, y);
+    std::vector<float> iterations = render(x, y, pixel, tile);
+    if (iterations.empty()) {
+        std::cout << "[RENDER] [ERR]: \"Tile " << tile_x << ", " << tile_y << " failed\"" << std::endl;
+        return false;
+    }
+    // the engines return rows bottom up with the final |z|^2 next to every value
+    for (int row = 0; row < tile; row++)
+        for (int column = 0; column < tile; column++)
+            values[(size_t)row * tile + column] = iterations[2 * ((size_t)(tile - 1 - row) * tile + column)];
+    return true;
+}
+
+cpu_tile_renderer_t::cpu_tile_renderer_t(int max_iterations) : max_iterations(max_iterations)
+{
+}
+
+std::vector<float> cpu_tile_renderer_t::render(const arb_prec_t& centre_x, const arb_prec_t& centre_y,
+    const arb_prec_t& pixel, int size)
+{
+    // the view is c = translated * zoom - offset, the offset is the negated centre
+    return cpu_engine::render(arb_prec_t(centre_x).negate(), arb_prec_t(centre_y).negate(), tile_zoom(pixel, size),
+        size, size, max_iterations);
+}
+
+int cpu_tile_renderer_t::fraction_bits(void) const
+{
+    return cpu_engine::FRACTION_BITS;
+}
+
+std::string cpu_tile_renderer_t::engine(void)
+{
+    return "cpu " + std::to_string(cpu_engine::VERSION);
+}
+
+perturbation_tile_renderer_t::perturbation_tile_renderer_t(std::shared_ptr<const reference_orbit_t> reference,
+    int threads) :
+    reference(std::move(reference)), threads(std::max(1, threads))
+{
+}
+
+std::vector<float> perturbation_tile_renderer_t::render(const arb_prec_t& centre_x, const arb_prec_t& centre_y,
+    const arb_prec_t& pixel, int size)
+{
+    // the tile centre is taken off the reference exactly, what is left fits a double at any depth
+    const double centre_r = (arb_prec_t(centre_x) - reference->x()).to_double();
+    const double centre_i = (arb_prec_t(centre_y) - reference->y()).to_double();
+    const double spacing = pixel.to_double();
+
+    std::vector<float> iterations(2 * (size_t)size * size);
+    auto render_rows = [&](int first_row) {
+        for (int y = first_row; y < size; y += threads)
+            for (int x = 0; x < size; x++)
+                reference->iterate(centre_r + (x + 0.5 - 0.5 * size) * spacing,
+                    centre_i + (y + 0.5 - 0.5 * size) * spacing, &iterations[2 * ((size_t)y * size + x)]);
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(render_rows, i);
+    render_rows(0);
+    for (std::thread& worker : workers)
+        worker.join();
+    return iterations;
+}
+
+int perturbation_tile_renderer_t::fraction_bits(void) const
+{
+    return reference_orbit_t::FRACTION_BITS;
+}
+
+std::string perturbation_tile_renderer_t::engine(void)
+{
+    return "perturbation " + std::to_string(reference_orbit_t::VERSION);
+}
+
+gpu_tile_renderer_t::gpu_tile_renderer_t(int max_iterations, GLADloadproc load) :
+    program_cache(program_cache_t::default_directory(), load_gl_program_binary(load)),
+    defines(feature_defines(default_features()) + "#define MAX_ITTERATIONS (" + std::to_string(max_iterations) + ")\n"),
+    fbo(0), texture(0), texture_size(0)
+{
+    programs = std::make_unique<tiered_program_t>([this](const char* tier_defines) {
+        return start_program(GSV::vertex_shader, GSV::fragment_shader,
+            {defines.c_str(), tier_defines, GSV::mandelbrot, GSV::arb_prec_ops}, &program_cache);
+    }, [this](unsigned int program) { view_state.attach(program); });
+
+    // full screen quad, same as the one of main.cpp
+    const float vertices[] = {-1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f, 1.0f, -1.0f, 0.0f};
+    const unsigned int indices[] = {0, 1, 2, 0, 3, 1};
+    glGenVertexArrays(1, &quad_vao);
+    glBindVertexArray(quad_vao);
+    glGenBuffers(1, &quad_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glGenBuffers(1, &quad_ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glGenFramebuffers(1, &fbo);
+    glGenTextures(1, &texture);
+}
+
+gpu_tile_renderer_t::~gpu_tile_renderer_t()
+{
+    programs.reset(); // deletes the programs while the context is still current
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &texture);
+    glDeleteVertexArrays(1, &quad_vao);
+    glDeleteBuffers(1, &quad_vbo);
+    glDeleteBuffers(1, &quad_ebo);
+}
+
+std::vector<float> gpu_tile_renderer_t::render(const arb_prec_t& centre_x, const arb_prec_t& centre_y,
+    const arb_prec_t& pixel, int size)
+{
+    arb_prec_t zoom = tile_zoom(pixel, size);
+    unsigned int program = programs->program(zoom, size, size, true);
+    if (!program)
+        return {};
+
+    if (texture_size != size) {
+        texture_size = size;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, size, size, 0, GL_RG, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "[GL] [ERR]: \"Tile framebuffer is incomplete\"" << std::endl;
+            texture_size = 0;
+            return {};
+        }
+    }
+
+    view_state.set_resolution(size, size);
+    view_state.set_view(arb_prec_t(centre_x).negate(), arb_prec_t(centre_y).negate(), zoom);
+    view_state.upload();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, size, size);
+    glUseProgram(program);
+    glBindVertexArray(quad_vao);
+    glEnable(GL_SCISSOR_TEST);
+    for (int row = 0; row < size; row += ROWS_PER_DRAW) {
+        glScissor(0, row, size, std::min(ROWS_PER_DRAW, size - row));
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        glFlush();
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    std::vector<float> iterations(2 * (size_t)size * size);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, size, size, GL_RG, GL_FLOAT, iterations.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return iterations;
+}
+
+int gpu_tile_renderer_t::fraction_bits(void) const
+{
+    return GSV::precision_tiers[GSV::precision_tier_count - 1].fraction_bits;
+}
+
+std::string gpu_tile_renderer_t::engine(void) const
+{
+    return "gpu " + iteration_cache_t::source_version({defines.c_str(), GSV::vertex_shader, GSV::fragment_shader,
+        GSV::mandelbrot, GSV::arb_prec_ops}) + "\n" + gl_driver();
+}
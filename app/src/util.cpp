@@ -1 +1,61 @@
-#include "util.hpp"
\ No newline at end of file
+#include "util.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <cstdlib>
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string user_cache_directory(const std::string& name)
+{
+    if (const char* local = std::getenv("LOCALAPPDATA"))
+        return std::string(local) + "/mandelbrot/" + name;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"))
+        return std::string(xdg) + "/mandelbrot/" + name;
+    if (const char* home = std::getenv("HOME"))
+        return std::string(home) + "/.cache/mandelbrot/" + name;
+    return std::string();
+}
+
+bool write_atomically(const std::string& path, const std::function<void(std::ostream&)>& write, const char* tag)
+{
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (!directory.empty())
+        std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cout << "[" << tag << "] [ERR]: \"Could not create " << directory.string() << "\", " << error.message()
+            << std::endl;
+        return false;
+    }
+
+    std::string temporary = path + "." + std::to_string(std::random_device{}()) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (file)
+            write(file);
+        if (!file) {
+            std::cout << "[" << tag << "] [ERR]: \"Could not write " << temporary << "\"" << std::endl;
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cout << "[" << tag << "] [ERR]: \"Could not replace " << path << "\", " << error.message() << std::endl;
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
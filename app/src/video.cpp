@@ -0,0 +1,258 @@
+#include "video.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "distributed.hpp"
+#include "perturbation.hpp"
+#include "tiered_program.hpp"
+
+static constexpr int BAND_OCTAVES = 4;  // frames share a BLA table while within 2^4 of the width it was built for
+static constexpr int BLOCK_ROWS = 64;   // rows of a frame a worker of a coordinator renders at once
+static constexpr int COORDINATOR_THREADS = 4; // frames a coordinator has its workers on, two blocks each are queued
+
+// width of the view at a time, exponential between the keyframes around it
+static double frame_width(const std::vector<video_keyframe_t>& keyframes, double time)
+{
+    size_t next = 1;
+    while (next + 1 < keyframes.size() && keyframes[next].time < time)
+        next++;
+    const video_keyframe_t& from = keyframes[next - 1];
+    const video_keyframe_t& to = keyframes[next];
+    double t = std::clamp((time - from.time) / (to.time - from.time), 0.0, 1.0);
+    return std::exp2((1.0 - t) * std::log2(from.width.to_double()) + t * std::log2(to.width.to_double()));
+}
+
+// rgb8 to planar 4:2:0 in BT.601 video range, chroma from the mean of each 2x2 block
+static void rgb_to_yuv420(const std::vector<uint8_t>& rgb, int width, int height, std::vector<uint8_t>& yuv)
+{
+    yuv.resize((size_t)width * height * 3 / 2);
+    uint8_t* y_plane = yuv.data();
+    uint8_t* u_plane = y_plane + (size_t)width * height;
+    uint8_t* v_plane = u_plane + (size_t)width * height / 4;
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        int r = rgb[3 * i], g = rgb[3 * i + 1], b = rgb[3 * i + 2];
+        y_plane[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+    for (int y = 0; y < height / 2; y++)
+        for (int x = 0; x < width / 2; x++) {
+            int r = 0, g = 0, b = 0;
+            for (int corner = 0; corner < 4; corner++) {
+                size_t i = 3 * ((size_t)(2 * y + corner / 2) * width + 2 * x + corner % 2);
+                r += rgb[i];
+                g += rgb[i + 1];
+                b += rgb[i + 2];
+            }
+            r = (r + 2) / 4;
+            g = (g + 2) / 4;
+            b = (b + 2) / 4;
+            size_t i = (size_t)y * (width / 2) + x;
+            u_plane[i] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            v_plane[i] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+}
+
+// pixels of one frame as dc from the centre, or resampled from the exponential map, rows top down like the renders
+static void render_frame(const reference_orbit_t* reference, const video_options_t& options, double view_width,
+    std::vector<uint8_t>& yuv)
+{
+    const int width = options.width, height = options.height;
+    const double pixel = view_width / width;
+    std::vector<float> values(2 * (size_t)width);
+    std::vector<uint8_t> rgb(3 * (size_t)width * height);
+    for (int y = 0; y < height; y++) {
+        if (options.exponential_map) {
+            options.exponential_map->sample_row(view_width, width, height, y, values.data());
+            colour_iterations(options.palette, options.palette_period, values.data(), 1, width,
+                &rgb[3 * (size_t)y * width]);
+            continue;
+        }
+        double dc_i = (0.5 * height - y - 0.5) * pixel;
+        for (int x = 0; x < width; x++)
+            reference->iterate((x + 0.5 - 0.5 * width) * pixel, dc_i, &values[2 * (size_t)x]);
+        colour_iterations(options.palette, options.palette_period, values.data(), 2, width,
+            &rgb[3 * (size_t)y * width]);
+    }
+    rgb_to_yuv420(rgb, width, height, yuv);
+}
+
+// the same frame in blocks of rows on the workers of a coordinator, false when it stopped
+static bool render_frame_distributed(coordinator_t& coordinator, const video_options_t& options, double view_width,
+    double reach, std::vector<uint8_t>& yuv)
+{
+    const int width = options.width, height = options.height;
+    const double pixel = view_width / width;
+    std::vector<std::future<std::vector<float>>> blocks;
+    for (int first = 0; first < height; first += BLOCK_ROWS) {
+        int rows = std::min(BLOCK_ROWS, height - first);
+        blocks.push_back(coordinator.submit({0.0, (0.5 * height - first - 0.5 * rows) * pixel, pixel, width, rows,
+            reach}));
+    }
+    std::vector<uint8_t> rgb(3 * (size_t)width * height);
+    for (size_t i = 0; i < blocks.size(); i++) {
+        std::vector<float> values = blocks[i].get();
+        if (values.empty())
+            return false;
+        colour_iterations(options.palette, options.palette_period, values.data(), 1, values.size(),
+            &rgb[3 * i * BLOCK_ROWS * width]);
+    }
+    rgb_to_yuv420(rgb, width, height, yuv);
+    return true;
+}
+
+bool write_video(const video_options_t& options, std::ostream& stream)
+{
+    const std::vector<video_keyframe_t>& keyframes = options.keyframes;
+    bool ascending = keyframes.size() >= 2;
+    for (size_t k = 1; k < keyframes.size(); k++)
+        ascending = ascending && keyframes[k].time > keyframes[k - 1].time;
+    if (!ascending) {
+        std::cout << "[VIDEO] [ERR]: \"A video needs at least two keyframes at ascending times\"" << std::endl;
+        return false;
+    }
+    if (options.width % 2 || options.height % 2) {
+        std::cout << "[VIDEO] [ERR]: \"4:2:0 frames need an even width and height\"" << std::endl;
+        return false;
+    }
+
+    // the widest and the deepest view of the video, every frame lies between them
+    double widest = 0.0;
+    const video_keyframe_t* deepest = &keyframes.front();
+    for (const video_keyframe_t& keyframe : keyframes) {
+        double view_width = keyframe.width.to_double();
+        if (view_width <= 0.0) {
+            std::cout << "[VIDEO] [ERR]: \"Keyframe widths must be positive\"" << std::endl;
+            return false;
+        }
+        widest = std::max(widest, view_width);
+        if (view_width < deepest->width.to_double())
+            deepest = &keyframe;
+    }
+    double bits = tiered_program_t::required_bits(deepest->width, options.width, options.width);
+    if (options.exponential_map && deepest->width.to_double() < options.exponential_map->inner_width(options.width))
+        std::cout << "[VIDEO] [WARN]: \"The deepest frame lies past the inner edge of the exponential map, its centre "
+            "will be blurred\"" << std::endl;
+    else if (!options.exponential_map && bits > reference_orbit_t::FRACTION_BITS)
+        std::cout << "[VIDEO] [WARN]: \"The deepest frame needs " << (int)bits << " fraction bits, the reference "
+            << "resolves " << reference_orbit_t::FRACTION_BITS << ", expect blocks\"" << std::endl;
+
+    const int frames = (int)std::lround((keyframes.back().time - keyframes.front().time) * options.fps) + 1;
+    const double diagonal = std::hypot((double)options.width, (double)options.height);
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<const reference_orbit_t> reference;
+    if (options.exponential_map) {
+        std::cout << "[VIDEO] " << frames << " frames of " << options.width << "x" << options.height << " at "
+            << options.fps << " fps from the exponential map" << std::endl;
+    } else {
+        reference = std::make_shared<const reference_orbit_t>(options.centre_x, options.centre_y,
+            options.max_iterations, 0.5 * widest / options.width * diagonal);
+        std::cout << "[VIDEO] " << frames << " frames of " << options.width << "x" << options.height << " at "
+            << options.fps << " fps, reference orbit of " << reference->length() << " iterations in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+        if (options.coordinator)
+            options.coordinator->start(reference);
+    }
+
+    stream << "YUV4MPEG2 W" << options.width << " H" << options.height << " F" << options.fps
+        << ":1 Ip A1:1 C420jpeg\n";
+
+    // BLA tables of the bands frames in flight are in, frames go deeper or wider so neighbouring bands are kept
+    auto band_of = [&](double view_width) { return (int)(std::log2(widest / view_width) / BAND_OCTAVES); };
+    auto band_reach = [&](int band) {
+        return 0.5 * std::ldexp(widest, -band * BAND_OCTAVES) / options.width * diagonal;
+    };
+    std::mutex table_mutex;
+    std::map<int, std::shared_ptr<const reference_orbit_t>> tables;
+    auto table_for = [&](double view_width) -> std::shared_ptr<const reference_orbit_t> {
+        if (!reference)
+            return nullptr;
+        int band = band_of(view_width);
+        std::lock_guard<std::mutex> guard(table_mutex);
+        std::shared_ptr<const reference_orbit_t>& table = tables[band];
+        if (!table)
+            table = reference->with_reach(band_reach(band));
+        std::shared_ptr<const reference_orbit_t> found = table;
+        std::erase_if(tables, [band](const auto& entry) { return std::abs(entry.first - band) > 1; });
+        return found;
+    };
+
+    // workers take frames in order and stay at most two frames per worker ahead of the one the stream waits for, on a
+    // coordinator they mostly wait for its workers
+    const int threads = options.coordinator ? COORDINATOR_THREADS :
+        (int)std::max(1u, std::thread::hardware_concurrency());
+    std::mutex frame_mutex;
+    std::condition_variable frames_changed;
+    std::map<int, std::vector<uint8_t>> finished;
+    int next = 0, written = 0;
+    bool failed = false;
+    auto work = [&]() {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(frame_mutex);
+            frames_changed.wait(lock, [&] { return next < written + 2 * threads || failed; });
+            if (next >= frames || failed)
+                return;
+            int frame = next++;
+            lock.unlock();
+
+            double view_width = frame_width(keyframes, keyframes.front().time + (double)frame / options.fps);
+            std::vector<uint8_t> yuv;
+            bool rendered = true;
+            if (options.coordinator)
+                rendered = render_frame_distributed(*options.coordinator, options, view_width,
+                    band_reach(band_of(view_width)), yuv);
+            else
+                render_frame(table_for(view_width).get(), options, view_width, yuv);
+
+            lock.lock();
+            failed = failed || !rendered;
+            finished[frame] = std::move(yuv);
+            lock.unlock();
+            frames_changed.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(work);
+
+    while (written < frames) {
+        std::unique_lock<std::mutex> lock(frame_mutex);
+        frames_changed.wait(lock, [&] { return finished.count(written) != 0 || failed; });
+        if (failed)
+            break;
+        std::vector<uint8_t> yuv = std::move(finished[written]);
+        finished.erase(written);
+        lock.unlock();
+
+        stream << "FRAME\n";
+        stream.write((const char*)yuv.data(), (std::streamsize)yuv.size());
+        lock.lock();
+        failed = !stream;
+        written++;
+        lock.unlock();
+        frames_changed.notify_all();
+        if (failed)
+            break;
+        if (written % options.fps == 0)
+            std::cout << "[VIDEO] " << written << " of " << frames << " frames, "
+                << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    stream.flush();
+    if (failed || !stream) {
+        std::cout << "[VIDEO] [ERR]: \"Could not write frame " << written << "\"" << std::endl;
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[VIDEO] " << frames << " frames in " << seconds << " s, " << frames / seconds << " frames per second"
+        << std::endl;
+    return true;
+}
@@ -0,0 +1,90 @@
+#include "view_state.hpp"
+
+#include <iostream>
+#include <cstddef>
+
+#include "gen_shaders.h"
+
+static_assert(sizeof(float) == 4 && sizeof(unsigned int) == 4, "std140 layout assumes 32 bit scalars");
+
+view_state_t::view_state_t(void) : data{}, dirty(true)
+{
+    static_assert(offsetof(layout_t, zoom) == 32, "std140 aligns arrays to 16 bytes");
+
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(data), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+view_state_t::~view_state_t()
+{
+    glDeleteBuffers(1, &ubo);
+}
+
+void view_state_t::attach(unsigned int program)
+{
+    unsigned int index = glGetUniformBlockIndex(program, GSV::view_state);
+    if (index == GL_INVALID_INDEX) {
+        std::cout << "[GL] [ERR]: \"Program " << program << " has no " << GSV::view_state << " block\"" << std::endl;
+        return;
+    }
+    glUniformBlockBinding(program, index, BINDING);
+}
+
+bool view_state_t::set_limbs(std140_uint_t* dst, const arb_prec_t& src)
+{
+    bool changed = false;
+    for (size_t limb_i = 0; limb_i < arb_prec_t::size(); limb_i++) {
+        changed |= dst[limb_i].value != src.buffer()[limb_i];
+        dst[limb_i].value = src.buffer()[limb_i];
+    }
+    return changed;
+}
+
+void view_state_t::set_resolution(int width, int height)
+{
+    if (data.resolution[0] == (float)width && data.resolution[1] == (float)height)
+        return;
+    data.resolution[0] = (float)width;
+    data.resolution[1] = (float)height;
+    dirty = true;
+}
+
+void view_state_t::set_time(float time)
+{
+    if (data.time == time)
+        return;
+    data.time = time;
+    dirty = true;
+}
+
+void view_state_t::set_colour(float palette_period, float offset, float exposure, colour_mode_t mode)
+{
+    if (data.palette_period == palette_period && data.colour_offset == offset && data.exposure == exposure &&
+        data.colour_mode == mode)
+        return;
+    data.palette_period = palette_period;
+    data.colour_offset = offset;
+    data.exposure = exposure;
+    data.colour_mode = mode;
+    dirty = true;
+}
+
+void view_state_t::set_view(const arb_prec_t& offset_x, const arb_prec_t& offset_y, const arb_prec_t& zoom)
+{
+    dirty |= set_limbs(data.offset_r, offset_x);
+    dirty |= set_limbs(data.offset_i, offset_y);
+    dirty |= set_limbs(data.zoom, zoom);
+}
+
+void view_state_t::upload(void)
+{
+    if (!dirty)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    dirty = false;
+}
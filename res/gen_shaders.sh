@@ -12,6 +12,66 @@ HEADER_VAR=""
 
 SHADER_PROGRAM_T="shader_program_t"
 UNIFORM_NAME_T="uniform_name_t  "
+PRECISION_TIER_T="precision_tier_t"
+SHADER_FEATURE_T="shader_feature_t"
+
+# precision tiers of mandelbrot.glsl, cheapest first: name|fraction bits of c it resolves|defines spliced in before it
+# double loses two mantissa bits to the integer part of c, arbprec keeps all limbs but the first for fractions
+# the arbprec tiers are slower than the double ones wherever fp64 is native, they take over where it is missing
+PRECISION_TIERS=(
+	'double|51|#define PRECISION_TIER TIER_DOUBLE'
+	'double_double|104|#define PRECISION_TIER TIER_DOUBLE_DOUBLE'
+	'arbprec_2|32|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 2'
+	'arbprec_3|64|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 3'
+	'arbprec_4|96|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 4'
+	'arbprec_5|128|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 5'
+	'arbprec_6|160|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 6'
+	'arbprec_7|192|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 7'
+	'arbprec_8|224|#define PRECISION_TIER TIER_ARBPREC\n#define PRECISION 8'
+)
+
+# compile time features of the shaders: name|define|on by default
+# the defines of a feature set are spliced in before everything else, each set is a program variant of its own
+SHADER_FEATURES=(
+	'debug_square|FEATURE_DEBUG_SQUARE|0'
+	'cardioid_check|FEATURE_CARDIOID_CHECK|1'
+	'periodicity|FEATURE_PERIODICITY|1'
+	'smoothing|FEATURE_SMOOTHING|1'
+)
+
+# one shader source: its program text, the names of its uniforms and its declaration
+process_file() {
+	local f=$1
+	local PREFIX=$2
+
+	PROC_FILE_NAME=${f##*/} # remove pathing of file
+	PROC_FILE_NAME_NO_EXT=${PROC_FILE_NAME%\.*}
+	echo "processing $f"
+	HEADER_VAR="${HEADER_VAR}"$'\n\n'"/* generated from ${PREFIX}${PREFIX:+/}${PROC_FILE_NAME} */"
+	HEADER_VAR="${HEADER_VAR}"$'\n'"extern ${SHADER_PROGRAM_T} ${PREFIX}${PREFIX:+_}${PROC_FILE_NAME_NO_EXT};"
+
+	while read -r uniform ;
+	do
+		# plain uniforms and uniform blocks, e.g. "layout(std140) uniform view_state {"
+		UNIFORM_NAME=${uniform%%//*}
+		UNIFORM_NAME=${UNIFORM_NAME%%\{*}
+		UNIFORM_NAME=${UNIFORM_NAME% =*}
+		UNIFORM_NAME=${UNIFORM_NAME%%[*}
+		UNIFORM_NAME=${UNIFORM_NAME%\;*}
+		UNIFORM_NAME=${UNIFORM_NAME%"${UNIFORM_NAME##*[![:space:]]}"}
+		UNIFORM_NAME=${UNIFORM_NAME##* }
+		if [ -z "$(grep -w "${UNIFORM_NAME}" <<< "$HEADER_VAR")" ]; then
+			# only process non duplicate keys
+			HEADER_VAR="${HEADER_VAR}"$'\n'"extern ${UNIFORM_NAME_T} ${UNIFORM_NAME};"
+			SOURCE_VAR="${SOURCE_VAR}"$'\n'"${UNIFORM_NAME_T} ${UNIFORM_NAME} = \"${UNIFORM_NAME}\";"
+		fi
+
+	done < <(grep -E '^(layout\(.*\) *)?uniform' $f)
+
+	SOURCE_VAR="${SOURCE_VAR}"$'\n'"${SHADER_PROGRAM_T} ${PROC_FILE_NAME_NO_EXT} = R\"("$'\n'
+	SOURCE_VAR="${SOURCE_VAR}$(awk '{printf "\t%s\n", $0}' < $f)"
+	SOURCE_VAR="${SOURCE_VAR})\";"$'\n\n'
+}
 
 process_folder() {
 	local DIR=$1
@@ -23,32 +83,43 @@ process_folder() {
 		if [[ -d $f ]]; then
 			process_folder $f
 		else
-			PROC_FILE_NAME=${f##*/} # remove pathing of file
-			PROC_FILE_NAME_NO_EXT=${PROC_FILE_NAME%\.*}
-			echo "processing $f"
-			HEADER_VAR="${HEADER_VAR}"$'\n\n'"/* generated from ${PREFIX}${PREFIX:+/}${PROC_FILE_NAME} */"
-			HEADER_VAR="${HEADER_VAR}"$'\n'"extern ${SHADER_PROGRAM_T} ${PREFIX}${PREFIX:+_}${PROC_FILE_NAME_NO_EXT};"
-			
-			while read -r uniform ;
-			do
-				UNIFORM_NAME=${uniform% =*}
-				UNIFORM_NAME=${UNIFORM_NAME%%[*}
-				UNIFORM_NAME=${UNIFORM_NAME##* }
-				if [ -z "$(grep "${UNIFORM_NAME}" <<< "$HEADER_VAR")" ]; then
-					# only process non duplicate keys
-					HEADER_VAR="${HEADER_VAR}"$'\n'"extern ${UNIFORM_NAME_T} ${UNIFORM_NAME%\;*};"
-					SOURCE_VAR="${SOURCE_VAR}"$'\n'"${UNIFORM_NAME_T} ${UNIFORM_NAME%\;*} = \"${UNIFORM_NAME%\;*}\";"
-				fi
-
-			done < <(grep '^uniform' $f)
-
-			SOURCE_VAR="${SOURCE_VAR}"$'\n'"${SHADER_PROGRAM_T} ${PROC_FILE_NAME_NO_EXT} = R\"("$'\n'
-			SOURCE_VAR="${SOURCE_VAR}$(awk '{printf "\t%s\n", $0}' < $f)"
-			SOURCE_VAR="${SOURCE_VAR})\";"$'\n\n'
+			process_file "$f" "$PREFIX"
 		fi
 	done
 }
 
+process_tiers() {
+	HEADER_VAR="${HEADER_VAR}"$'\n\n'"/* generated from PRECISION_TIERS in $(basename "$0") */"
+	HEADER_VAR="${HEADER_VAR}"$'\n'"extern const ${PRECISION_TIER_T} precision_tiers[];"
+	HEADER_VAR="${HEADER_VAR}"$'\n'"extern const unsigned int precision_tier_count;"
+
+	SOURCE_VAR="${SOURCE_VAR}const ${PRECISION_TIER_T} precision_tiers[] = {"
+	for tier in "${PRECISION_TIERS[@]}"
+	do
+		IFS='|' read -r TIER_NAME TIER_BITS TIER_DEFINES <<< "$tier"
+		echo "processing tier ${TIER_NAME}"
+		SOURCE_VAR="${SOURCE_VAR}"$'\n'"	{\"${TIER_NAME}\", \"${TIER_DEFINES}\", ${TIER_BITS}},"
+	done
+	SOURCE_VAR="${SOURCE_VAR}"$'\n'"};"$'\n'
+	SOURCE_VAR="${SOURCE_VAR}const unsigned int precision_tier_count = ${#PRECISION_TIERS[@]};"$'\n\n'
+}
+
+process_features() {
+	HEADER_VAR="${HEADER_VAR}"$'\n\n'"/* generated from SHADER_FEATURES in $(basename "$0") */"
+	HEADER_VAR="${HEADER_VAR}"$'\n'"extern const ${SHADER_FEATURE_T} shader_features[];"
+	HEADER_VAR="${HEADER_VAR}"$'\n'"extern const unsigned int shader_feature_count;"
+
+	SOURCE_VAR="${SOURCE_VAR}const ${SHADER_FEATURE_T} shader_features[] = {"
+	for feature in "${SHADER_FEATURES[@]}"
+	do
+		IFS='|' read -r FEATURE_NAME FEATURE_DEFINE FEATURE_DEFAULT <<< "$feature"
+		echo "processing feature ${FEATURE_NAME}"
+		SOURCE_VAR="${SOURCE_VAR}"$'\n'"	{\"${FEATURE_NAME}\", \"${FEATURE_DEFINE}\", ${FEATURE_DEFAULT}},"
+	done
+	SOURCE_VAR="${SOURCE_VAR}"$'\n'"};"$'\n'
+	SOURCE_VAR="${SOURCE_VAR}const unsigned int shader_feature_count = ${#SHADER_FEATURES[@]};"$'\n\n'
+}
+
 echo Generating "gen_shaders.cpp & gen_shaders.h"
 mkdir -p ${OUTPUT_DIR}
 touch ${HEADER}
@@ -66,7 +137,21 @@ extern \"C\" {
 namespace GSV {
 
 typedef const char* const ${SHADER_PROGRAM_T};
-typedef const char* const ${UNIFORM_NAME_T};"
+typedef const char* const ${UNIFORM_NAME_T};
+
+/* one program variant of mandelbrot.glsl */
+typedef struct {
+	const char* name;
+	const char* defines;		/* spliced in before mandelbrot.glsl */
+	int         fraction_bits;	/* fraction bits of c it resolves */
+} ${PRECISION_TIER_T};
+
+/* one compile time feature of the shaders */
+typedef struct {
+	const char* name;
+	const char* define;		/* defined while the feature is on */
+	int         enabled;	/* on by default */
+} ${SHADER_FEATURE_T};"
 
 SOURCE_VAR="/* File generated by $(basename "$0") */
 
@@ -82,6 +167,13 @@ namespace GSV {
 
 
 process_folder "${SHADER_DIR}"
+# shaders generated outside the source tree, such as arb_prec_ops.glsl, are passed as arguments
+for f in "$@"
+do
+	process_file "$f" ""
+done
+process_tiers
+process_features
 
 HEADER_VAR="${HEADER_VAR}
 
@@ -0,0 +1,81 @@
+#version 330 core
+
+// Colours the iteration buffer written by fragment_shader.frag, a palette or exposure change only reruns this pass
+// the defines of the feature set (SHADER_FEATURES in gen_shaders.sh) are spliced in after the #version line
+
+out vec4 FragColor;
+
+// leading members of the view_state block in fragment_shader.frag, std140 keeps their offsets identical
+layout(std140) uniform view_state {
+	vec2 u_resolution;
+	float u_time;
+	float u_palette_period;
+	float u_colour_offset;
+	float u_exposure;
+	uint u_colour_mode;
+};
+
+uniform sampler2D u_iterations;
+// baked by palette_cache_t (palette.hpp), repeats so the lookup needs no fract()
+uniform sampler1D u_palette;
+// cumulative pixel count per bin, written by histogram_t (histogram.hpp)
+uniform sampler2D u_cdf;
+// histogram bins per iteration
+uniform float u_bin_scale;
+
+#define INTERIOR		(-1.0) // points which never escaped
+#define UNKNOWN			(-2.0) // not computed yet and outside of the preview
+#define HISTOGRAM_COLOURING	(1u) // view_state_t::HISTOGRAM_COLOURING
+
+const vec4 background = vec4(0.2, 0.0, 0.2, 1.0);
+
+float 	histogram_position(in float iteration);
+
+void main()
+{
+#ifdef FEATURE_DEBUG_SQUARE
+	// red, green, blue and white squares around the centre of the view
+	vec2 translated = vec2((gl_FragCoord.x / u_resolution.x) - 0.5, (gl_FragCoord.y / u_resolution.y) - 0.5);
+	if (		all(greaterThan(translated.xy, vec2( 0.00,  0.00))) &&
+				all(lessThan(   translated.xy, vec2( 0.01,  0.01)))){
+		FragColor = vec4(1.0, 0.0, 0.0, 1.0);
+		return;
+	} else if (	all(greaterThan(translated.xy, vec2( 0.00, -0.01))) &&
+				all(lessThan(   translated.xy, vec2( 0.01,  0.00)))) {
+		FragColor = vec4(0.0, 1.0, 0.0, 1.0);
+		return;
+	} else if (	all(greaterThan(translated.xy, vec2(-0.01,  0.00))) &&
+				all(lessThan(   translated.xy, vec2( 0.00,  0.01)))) {
+		FragColor = vec4(0.0, 0.0, 1.0, 1.0);
+		return;
+	} else if (	all(greaterThan(translated.xy, vec2(-0.01, -0.01))) &&
+				all(lessThan(   translated.xy, vec2( 0.00,  0.00)))) {
+		FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+		return;
+	}
+#endif
+
+	vec2 iteration = texelFetch(u_iterations, ivec2(gl_FragCoord.xy), 0).rg;
+
+	if (iteration.x <= UNKNOWN)
+		FragColor = background;
+	else if (iteration.x <= INTERIOR)
+		FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+	else if (u_colour_mode == HISTOGRAM_COLOURING)
+		FragColor = vec4(texture(u_palette, histogram_position(iteration.x) + u_colour_offset).rgb * u_exposure, 1.0);
+	else
+		FragColor = vec4(texture(u_palette, iteration.x / u_palette_period + u_colour_offset).rgb * u_exposure, 1.0);
+}
+
+// fraction of the counted pixels with a lower iteration value, interpolated inside the bin
+float histogram_position(in float iteration)
+{
+	int bins = textureSize(u_cdf, 0).x;
+	float bin = min(iteration * u_bin_scale, float(bins - 1));
+	int index = int(bin);
+
+	float below = index > 0 ? texelFetch(u_cdf, ivec2(index - 1, 0), 0).r : 0.0;
+	float upto  = texelFetch(u_cdf, ivec2(index, 0), 0).r;
+	float total = texelFetch(u_cdf, ivec2(bins - 1, 0), 0).r;
+	return total > 0.0 ? mix(below, upto, fract(bin)) / total : 0.0;
+}
\ No newline at end of file
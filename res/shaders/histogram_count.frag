@@ -0,0 +1,12 @@
+#version 330 core
+
+// Adds the weight of one pixel to its bin, +1 when a pixel is counted and -1 when it is about to be overwritten
+
+out vec4 CountOut;
+
+uniform float u_weight;
+
+void main()
+{
+	CountOut = vec4(u_weight, 0.0, 0.0, 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#version 330 core
+
+// One point per pixel of a region of the iteration buffer, moved onto the histogram bin of its iteration value.
+// Drawn with additive blending into the bins x 1 count texture, see histogram.hpp
+
+uniform sampler2D u_iterations;
+// x, y, width and height of the region in the iteration buffer
+uniform ivec4 u_region;
+// histogram bins per iteration
+uniform float u_bin_scale;
+uniform int u_bins;
+
+void main()
+{
+	ivec2 pixel = u_region.xy + ivec2(gl_VertexID % u_region.z, gl_VertexID / u_region.z);
+	float iteration = texelFetch(u_iterations, pixel, 0).r;
+
+	if (iteration < 0.0) {
+		gl_Position = vec4(2.0, 2.0, 0.0, 1.0); // interior and unknown pixels are not counted, clipped away
+		return;
+	}
+
+	float bin = min(floor(iteration * u_bin_scale), float(u_bins - 1));
+	gl_Position = vec4((bin + 0.5) / float(u_bins) * 2.0 - 1.0, 0.0, 0.0, 1.0);
+}
\ No newline at end of file
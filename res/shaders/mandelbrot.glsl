@@ -0,0 +1,466 @@
+// Escape time kernels shared by every program that iterates the mandelbrot set, spliced in after the #version line
+// of fragment_shader.frag and compute_shader.comp by build_program (shader.hpp)
+// The defines of one precision tier (PRECISION_TIERS in gen_shaders.sh) are spliced in before this, they select the
+// number type the orbit is iterated in, the operations generated into arb_prec_ops.glsl follow after it. Every tier
+// implements the same orbit interface:
+//   orbit_t        c and z of one pixel
+//   orbit_start    c of a screen position, z = 0
+//   orbit_iterate  iterates z until it escapes or itterations reaches end, so long renders can be split into chunks
+//                  returns true once the outcome is known, when it escaped or was found to be periodic
+//   orbit_save     z as ORBIT_WORDS raw words, orbit_load restores it, lets a chunked render keep z in between
+//   orbit_c_estimate  c rounded to floats, for tests that only need to know roughly where the pixel lies
+// The defines of the feature set (SHADER_FEATURES in gen_shaders.sh) come first, a feature that is off compiles to
+// nothing:
+//   FEATURE_CARDIOID_CHECK  points inside the main cardioid or the period 2 bulb are not iterated at all
+//   FEATURE_PERIODICITY     orbits that return to an earlier z stop as interior, Brent's cycle detection
+//   FEATURE_SMOOTHING       escape counts are smoothed into a continuous value instead of whole iterations
+
+#define TIER_DOUBLE			0
+#define TIER_DOUBLE_DOUBLE	1 // unevaluated sum of two doubles, 106 bit mantissa
+#define TIER_ARBPREC		2 // PRECISION limbs of 32 bits, the first holding the integer part
+
+#ifndef PRECISION_TIER
+#define PRECISION_TIER		TIER_ARBPREC
+#endif
+
+// the view arrives with every limb of arb_prec_t, each tier reads as many of them as it can use
+#define VIEW_ARRAY_SIZE		9 // arb_prec_t::size()
+const float BASE = 4294967296.0;
+
+// iteration cap, gpu_tile_renderer_t (tile_renderer.hpp) defines its own before this
+#ifndef MAX_ITTERATIONS
+#define MAX_ITTERATIONS (256)
+#endif
+#define INTERIOR		(-1.0) // iteration value of points which never escaped
+#define BAILOUT_SQR		(256u) // escape radius squared, large enough for the log-log smoothing to join up between bands
+#define CARDIOID_MARGIN	(1e-4) // covers the error of orbit_c_estimate in the cardioid and bulb tests
+
+float 	smooth_iteration(in int itterations, in float r_sqr);
+vec2 	mandelbrot(
+			in vec2 translated, in uint offset_r[VIEW_ARRAY_SIZE], in uint offset_i[VIEW_ARRAY_SIZE],
+			in uint zoom[VIEW_ARRAY_SIZE]);
+
+// log-log smoothing of the escape count, runs once per pixel after the loop
+// n + 1 at the bailout radius falling to n at its square, so the bands join up into a continuous value
+float smooth_iteration(in int itterations, in float r_sqr)
+{
+#ifdef FEATURE_SMOOTHING
+	return float(itterations) + 1.0 - log2(log(r_sqr) / log(float(BAILOUT_SQR)));
+#else
+	return float(itterations);
+#endif
+}
+
+#if PRECISION_TIER == TIER_DOUBLE
+
+struct orbit_t {
+	dvec2 c;
+	dvec2 z;
+};
+#define ORBIT_WORDS 4
+
+// the first three limbs hold more than the 53 bits a double keeps
+double view_double(in uint x[VIEW_ARRAY_SIZE])
+{
+	double value = double(x[1]) + double(x[2]) / double(BASE) + double(x[3]) / (double(BASE) * double(BASE));
+	return x[0] != 0u ? -value : value;
+}
+
+void orbit_start(
+	out orbit_t orbit, in vec2 translated, in uint offset_r[VIEW_ARRAY_SIZE], in uint offset_i[VIEW_ARRAY_SIZE],
+	in uint zoom[VIEW_ARRAY_SIZE])
+{
+	orbit.c = dvec2(translated) * view_double(zoom) - dvec2(view_double(offset_r), view_double(offset_i));
+	orbit.z = dvec2(0.0);
+}
+
+// squared distance below which z counts as having come back, a few ulps of the double tier
+#define PERIODICITY_EPSILON	(1e-30LF)
+
+bool orbit_iterate(inout orbit_t orbit, inout int itterations, in int end, out vec2 result)
+{
+#ifdef FEATURE_PERIODICITY
+	dvec2 z_seen = orbit.z;
+	int seen_period = 1, seen_age = 0; // z_seen is moved along after 1, 2, 4, ... iterations
+#endif
+	for (; itterations < end; itterations++) {
+		double r_sqr = orbit.z.x * orbit.z.x + orbit.z.y * orbit.z.y;
+		if (r_sqr >= double(BAILOUT_SQR)) {
+			result = vec2(smooth_iteration(itterations, float(r_sqr)), r_sqr);
+			return true;
+		}
+		orbit.z = dvec2(
+			(orbit.z.x * orbit.z.x - orbit.z.y * orbit.z.y) + orbit.c.x,	// z.real^2 - z.imag^2 + c.real
+			(2.0 * orbit.z.x * orbit.z.y) + orbit.c.y);					// 2 * z.real * z.imag + c.imag
+#ifdef FEATURE_PERIODICITY
+		dvec2 distance = orbit.z - z_seen;
+		if (dot(distance, distance) < PERIODICITY_EPSILON) {
+			result = vec2(INTERIOR, 0.0);
+			return true;
+		}
+		if (++seen_age == seen_period) {
+			z_seen = orbit.z;
+			seen_age = 0;
+			seen_period *= 2;
+		}
+#endif
+	}
+
+	result = vec2(INTERIOR, 0.0);
+	return false;
+}
+
+void orbit_save(in orbit_t orbit, out uint words[ORBIT_WORDS])
+{
+	uvec2 x = unpackDouble2x32(orbit.z.x);
+	uvec2 y = unpackDouble2x32(orbit.z.y);
+	words[0] = x.x; words[1] = x.y;
+	words[2] = y.x; words[3] = y.y;
+}
+
+void orbit_load(inout orbit_t orbit, in uint words[ORBIT_WORDS])
+{
+	orbit.z = dvec2(packDouble2x32(uvec2(words[0], words[1])), packDouble2x32(uvec2(words[2], words[3])));
+}
+
+vec2 orbit_c_estimate(in orbit_t orbit)
+{
+	return vec2(orbit.c);
+}
+
+#elif PRECISION_TIER == TIER_DOUBLE_DOUBLE
+
+// a double-double is a dvec2 of hi + lo with |lo| at most half an ulp of hi, built on the error free transformations
+// of Knuth and Dekker, precise keeps the compiler from reassociating or contracting their error terms away
+dvec2 dd_quick_two_sum(in double a, in double b) // needs |a| >= |b|
+{
+	precise double s = a + b;
+	precise double e = b - (s - a);
+	return dvec2(s, e);
+}
+
+dvec2 dd_two_sum(in double a, in double b)
+{
+	precise double s = a + b;
+	precise double v = s - a;
+	precise double e = (a - (s - v)) + (b - v);
+	return dvec2(s, e);
+}
+
+dvec2 dd_add(in dvec2 a, in dvec2 b)
+{
+	dvec2 s = dd_two_sum(a.x, b.x);
+	dvec2 t = dd_two_sum(a.y, b.y);
+	s = dd_quick_two_sum(s.x, s.y + t.x);
+	return dd_quick_two_sum(s.x, s.y + t.y);
+}
+
+dvec2 dd_mul(in dvec2 a, in dvec2 b)
+{
+	precise double p = a.x * b.x;
+	precise double e = fma(a.x, b.x, -p) + (a.x * b.y + a.y * b.x);
+	return dd_quick_two_sum(p, e);
+}
+
+dvec2 dd_sqr(in dvec2 a)
+{
+	precise double p = a.x * a.x;
+	precise double e = fma(a.x, a.x, -p) + 2.0 * a.x * a.y;
+	return dd_quick_two_sum(p, e);
+}
+
+struct orbit_t {
+	dvec2 c_r, c_i;
+	dvec2 z_r, z_i;
+};
+#define ORBIT_WORDS 8
+
+// every limb is exact as a double, summing the first five of them covers the 106 bits a double-double keeps
+dvec2 view_double_double(in uint x[VIEW_ARRAY_SIZE])
+{
+	dvec2 value = dvec2(0.0);
+	double scale = 1.0;
+	for (int limb_i = 1; limb_i <= 5; limb_i++) {
+		value = dd_add(value, dvec2(double(x[limb_i]) * scale, 0.0));
+		scale /= double(BASE);
+	}
+	return x[0] != 0u ? -value : value;
+}
+
+void orbit_start(
+	out orbit_t orbit, in vec2 translated, in uint offset_r[VIEW_ARRAY_SIZE], in uint offset_i[VIEW_ARRAY_SIZE],
+	in uint zoom[VIEW_ARRAY_SIZE])
+{
+	dvec2 view_zoom = view_double_double(zoom);
+	orbit.c_r = dd_add(dd_mul(dvec2(translated.x, 0.0), view_zoom), -view_double_double(offset_r));
+	orbit.c_i = dd_add(dd_mul(dvec2(translated.y, 0.0), view_zoom), -view_double_double(offset_i));
+	orbit.z_r = dvec2(0.0);
+	orbit.z_i = dvec2(0.0);
+}
+
+// periodicity is only taken from a z that comes back exactly, no epsilon is small enough for every zoom of the tier
+bool orbit_iterate(inout orbit_t orbit, inout int itterations, in int end, out vec2 result)
+{
+#ifdef FEATURE_PERIODICITY
+	dvec2 seen_r = orbit.z_r, seen_i = orbit.z_i;
+	int seen_period = 1, seen_age = 0; // the seen z is moved along after 1, 2, 4, ... iterations
+#endif
+	for (; itterations < end; itterations++) {
+		dvec2 a_sqr = dd_sqr(orbit.z_r);
+		dvec2 b_sqr = dd_sqr(orbit.z_i);
+		double r_sqr = a_sqr.x + b_sqr.x; // the low parts cannot move it across the bailout
+		if (r_sqr >= double(BAILOUT_SQR)) {
+			result = vec2(smooth_iteration(itterations, float(r_sqr)), r_sqr);
+			return true;
+		}
+		dvec2 ab = dd_mul(orbit.z_r, orbit.z_i);
+		orbit.z_r = dd_add(dd_add(a_sqr, -b_sqr), orbit.c_r);	// z.real^2 - z.imag^2 + c.real
+		orbit.z_i = dd_add(ab * 2.0, orbit.c_i);				// 2 * z.real * z.imag + c.imag, doubling is exact
+#ifdef FEATURE_PERIODICITY
+		if (orbit.z_r == seen_r && orbit.z_i == seen_i) {
+			result = vec2(INTERIOR, 0.0);
+			return true;
+		}
+		if (++seen_age == seen_period) {
+			seen_r = orbit.z_r;
+			seen_i = orbit.z_i;
+			seen_age = 0;
+			seen_period *= 2;
+		}
+#endif
+	}
+
+	result = vec2(INTERIOR, 0.0);
+	return false;
+}
+
+void orbit_save(in orbit_t orbit, out uint words[ORBIT_WORDS])
+{
+	double parts[4] = double[4](orbit.z_r.x, orbit.z_r.y, orbit.z_i.x, orbit.z_i.y);
+	for (int part_i = 0; part_i < 4; part_i++) {
+		uvec2 part = unpackDouble2x32(parts[part_i]);
+		words[2 * part_i] = part.x;
+		words[2 * part_i + 1] = part.y;
+	}
+}
+
+void orbit_load(inout orbit_t orbit, in uint words[ORBIT_WORDS])
+{
+	double parts[4];
+	for (int part_i = 0; part_i < 4; part_i++)
+		parts[part_i] = packDouble2x32(uvec2(words[2 * part_i], words[2 * part_i + 1]));
+	orbit.z_r = dvec2(parts[0], parts[1]);
+	orbit.z_i = dvec2(parts[2], parts[3]);
+}
+
+vec2 orbit_c_estimate(in orbit_t orbit)
+{
+	return vec2(orbit.c_r.x, orbit.c_i.x);
+}
+
+#elif PRECISION_TIER == TIER_ARBPREC
+
+// Arbitrary precision
+// source: https://github.com/RohanFredriksson/glsl-arbitrary-precision
+#ifndef PRECISION
+#define PRECISION 3
+#endif
+const int ARRAY_SIZE = (PRECISION+1);
+
+#define assign(x, y) {for(int assign_i=0;assign_i<=PRECISION;assign_i++){x[assign_i]=y[assign_i];}}
+#define zero(x) {for(int zero_i=0;zero_i<=PRECISION;zero_i++){x[zero_i]=0u;}}
+#define load(x, v) {float load_value=(v); if (load_value<0.0) {x[0]=1u; load_value*=-1.0;} else {x[0]=0u;} for(int load_i=1; load_i<=PRECISION; load_i++) {x[load_i]=uint(load_value); load_value-=x[load_i]; load_value*=BASE;}}
+#define negate(x) {x[0]=(x[0]==0u?1u:0u);}
+// add, sub, mul, sqr and shift are unrolled for each PRECISION in arb_prec_ops.glsl, generated from arb_prec_n_t
+void 	arb_add(in uint a[ARRAY_SIZE], in uint b[ARRAY_SIZE], out uint r[ARRAY_SIZE]);
+void 	arb_sub(in uint a[ARRAY_SIZE], in uint b[ARRAY_SIZE], out uint r[ARRAY_SIZE]);
+void 	arb_mul(in uint a[ARRAY_SIZE], in uint b[ARRAY_SIZE], out uint r[ARRAY_SIZE]);
+void 	arb_sqr(in uint a[ARRAY_SIZE], out uint r[ARRAY_SIZE]);
+void 	arb_shift(inout uint x[ARRAY_SIZE], in int n);
+// end arbitrary precision
+
+void 	pixel_c_arbprec(
+			in vec2 c, in uint offset_r[ARRAY_SIZE], in uint offset_i[ARRAY_SIZE], in uint zoom[ARRAY_SIZE],
+			out uint c_r[ARRAY_SIZE], out uint c_i[ARRAY_SIZE]);
+bool 	iterate_arbprec(
+			in uint c_r[ARRAY_SIZE], in uint c_i[ARRAY_SIZE], inout uint z_r[ARRAY_SIZE], inout uint z_i[ARRAY_SIZE],
+			inout int itterations, in int end, out vec2 result);
+void 	step_mandelbrot_arb_prec(
+			in uint z_r[ARRAY_SIZE], in uint z_i[ARRAY_SIZE], 
+			in uint c_r[ARRAY_SIZE], in uint c_i[ARRAY_SIZE], 
+			out uint nz_r[ARRAY_SIZE], out uint nz_i[ARRAY_SIZE]);
+
+struct orbit_t {
+	uint c_r[ARRAY_SIZE];
+	uint c_i[ARRAY_SIZE];
+	uint z_r[ARRAY_SIZE];
+	uint z_i[ARRAY_SIZE];
+};
+#define ORBIT_WORDS (2*ARRAY_SIZE)
+
+// the view is cut down to the leading ARRAY_SIZE limbs
+void orbit_start(
+	out orbit_t orbit, in vec2 translated, in uint offset_r[VIEW_ARRAY_SIZE], in uint offset_i[VIEW_ARRAY_SIZE],
+	in uint zoom[VIEW_ARRAY_SIZE])
+{
+	uint view_r[ARRAY_SIZE];
+	uint view_i[ARRAY_SIZE];
+	uint view_zoom[ARRAY_SIZE];
+	assign(view_r, offset_r);
+	assign(view_i, offset_i);
+	assign(view_zoom, zoom);
+
+	pixel_c_arbprec(translated, view_r, view_i, view_zoom, orbit.c_r, orbit.c_i);
+	zero(orbit.z_r);
+	zero(orbit.z_i);
+}
+
+bool orbit_iterate(inout orbit_t orbit, inout int itterations, in int end, out vec2 result)
+{
+	return iterate_arbprec(orbit.c_r, orbit.c_i, orbit.z_r, orbit.z_i, itterations, end, result);
+}
+
+void orbit_save(in orbit_t orbit, out uint words[ORBIT_WORDS])
+{
+	for (int limb_i = 0; limb_i < ARRAY_SIZE; limb_i++) {
+		words[limb_i] = orbit.z_r[limb_i];
+		words[ARRAY_SIZE + limb_i] = orbit.z_i[limb_i];
+	}
+}
+
+void orbit_load(inout orbit_t orbit, in uint words[ORBIT_WORDS])
+{
+	for (int limb_i = 0; limb_i < ARRAY_SIZE; limb_i++) {
+		orbit.z_r[limb_i] = words[limb_i];
+		orbit.z_i[limb_i] = words[ARRAY_SIZE + limb_i];
+	}
+}
+
+// the integer part and the first fraction limb
+float arb_estimate(in uint x[ARRAY_SIZE])
+{
+	float value = float(x[1]) + float(x[2]) / BASE;
+	return x[0] != 0u ? -value : value;
+}
+
+vec2 orbit_c_estimate(in orbit_t orbit)
+{
+	return vec2(arb_estimate(orbit.c_r), arb_estimate(orbit.c_i));
+}
+
+// point of the complex plane at screen position c, relative to the centre of the view
+void pixel_c_arbprec(
+	in vec2 c, in uint offset_r[ARRAY_SIZE], in uint offset_i[ARRAY_SIZE], in uint zoom[ARRAY_SIZE],
+	out uint c_r[ARRAY_SIZE], out uint c_i[ARRAY_SIZE])
+{
+	load(c_r, c.x);
+	load(c_i, c.y);
+	
+	arb_mul(c_r, zoom, c_r);
+	arb_mul(c_i, zoom, c_i);
+	
+	arb_sub(c_r, offset_r, c_r);
+	arb_sub(c_i, offset_i, c_i);
+}
+
+// iterates z until it escapes or itterations reaches end, so long renders can be split into resumable chunks
+// returns true with the smoothed escape value in result when it escaped, z is left at the escaping value then
+// fixed point limbs round the same way every time, so a periodic orbit comes back to exactly the same limbs
+bool iterate_arbprec(
+	in uint c_r[ARRAY_SIZE], in uint c_i[ARRAY_SIZE], inout uint z_r[ARRAY_SIZE], inout uint z_i[ARRAY_SIZE],
+	inout int itterations, in int end, out vec2 result)
+{
+	uint nz_r[ARRAY_SIZE];
+    uint nz_i[ARRAY_SIZE];
+#ifdef FEATURE_PERIODICITY
+	uint seen_r[ARRAY_SIZE];
+	uint seen_i[ARRAY_SIZE];
+	assign(seen_r, z_r);
+	assign(seen_i, z_i);
+	int seen_period = 1, seen_age = 0; // the seen z is moved along after 1, 2, 4, ... iterations
+#endif
+
+	for (; itterations < end; itterations++) {
+		uint a_sqr[ARRAY_SIZE];
+        uint b_sqr[ARRAY_SIZE];
+        arb_sqr(z_r, a_sqr);
+        arb_sqr(z_i, b_sqr);
+        arb_add(a_sqr, b_sqr, a_sqr); // pretend a_sqr here is r_sqr
+        
+        if (a_sqr[1] >= BAILOUT_SQR) { // pretend a_sqr here is r_sqr
+            float r_sqr = float(a_sqr[1]) + float(a_sqr[2]) / BASE;
+            result = vec2(smooth_iteration(itterations, r_sqr), r_sqr);
+            return true;
+        }
+        
+		step_mandelbrot_arb_prec(z_r, z_i, c_r, c_i, nz_r, nz_i);
+		assign(z_r, nz_r);
+		assign(z_i, nz_i);
+#ifdef FEATURE_PERIODICITY
+		if (z_r == seen_r && z_i == seen_i) {
+			result = vec2(INTERIOR, 0.0);
+			return true;
+		}
+		if (++seen_age == seen_period) {
+			assign(seen_r, z_r);
+			assign(seen_i, z_i);
+			seen_age = 0;
+			seen_period *= 2;
+		}
+#endif
+	}
+
+	result = vec2(INTERIOR, 0.0);
+	return false;
+}
+
+void step_mandelbrot_arb_prec(
+	in uint z_r[ARRAY_SIZE], in uint z_i[ARRAY_SIZE], 
+	in uint c_r[ARRAY_SIZE], in uint c_i[ARRAY_SIZE], 
+	out uint nz_r[ARRAY_SIZE], out uint nz_i[ARRAY_SIZE])
+{
+	uint tmp1[ARRAY_SIZE];
+	uint tmp2[ARRAY_SIZE];
+	// calculate 'z.real
+	arb_sqr(z_r, tmp1); 			// z.real^2
+	arb_sqr(z_i, tmp2); 			// z.imag^2
+	arb_sub(tmp1, tmp2, tmp1);		// z.real^2 - z.imag^2
+	arb_add(tmp1, c_r, nz_r);		// z.real^2 - z.imag^2 + c.real
+
+	// calculate 'z.imag
+	arb_add(z_r, z_r, tmp1); 		// 2 * z.real
+	arb_mul(tmp1, z_i, tmp2); 		// 2 * z.real * z.imag
+	arb_add(tmp2, c_i, nz_i);		// 2 * z.real * z.imag + c.imag
+}
+
+#endif // PRECISION_TIER
+
+// true when c lies inside the main cardioid or the period 2 bulb, whose points never escape, always false without
+// FEATURE_CARDIOID_CHECK
+bool orbit_interior(in orbit_t orbit)
+{
+#ifdef FEATURE_CARDIOID_CHECK
+	vec2 c = orbit_c_estimate(orbit);
+	float x = c.x - 0.25;
+	float y_sqr = c.y * c.y;
+	float q = x * x + y_sqr;
+	float bulb_x = c.x + 1.0;
+	return q * (q + x) < 0.25 * y_sqr - CARDIOID_MARGIN || bulb_x * bulb_x + y_sqr < 0.0625 - CARDIOID_MARGIN;
+#else
+	return false;
+#endif
+}
+
+vec2 mandelbrot(
+	in vec2 translated, in uint offset_r[VIEW_ARRAY_SIZE], in uint offset_i[VIEW_ARRAY_SIZE],
+	in uint zoom[VIEW_ARRAY_SIZE])
+{
+	orbit_t orbit;
+	orbit_start(orbit, translated, offset_r, offset_i, zoom);
+
+	int itterations = 0;
+	vec2 result = vec2(INTERIOR, 0.0);
+	if (!orbit_interior(orbit))
+		orbit_iterate(orbit, itterations, MAX_ITTERATIONS, result);
+	return result; // INTERIOR when it never escaped
+}
\ No newline at end of file
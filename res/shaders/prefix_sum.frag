@@ -0,0 +1,18 @@
+#version 330 core
+
+// One Hillis-Steele step of the inclusive prefix sum over the histogram bins.
+// Run log2(bins) times with the stride doubling, the last step leaves the cumulative count of every bin
+
+out vec4 SumOut;
+
+uniform sampler2D u_partial_sums;
+uniform int u_stride;
+
+void main()
+{
+	int bin = int(gl_FragCoord.x);
+	float sum = texelFetch(u_partial_sums, ivec2(bin, 0), 0).r;
+	if (bin >= u_stride)
+		sum += texelFetch(u_partial_sums, ivec2(bin - u_stride, 0), 0).r;
+	SumOut = vec4(sum, 0.0, 0.0, 0.0);
+}
\ No newline at end of file
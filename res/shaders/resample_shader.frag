@@ -0,0 +1,27 @@
+#version 330 core
+
+// Draws the previous iteration buffer scaled and shifted into the current view, used as a preview while the new frame computes
+
+out vec2 IterationOut;
+
+uniform vec2 u_resolution;
+uniform sampler2D u_previous_frame;
+// new zoom / previous zoom
+uniform vec2 u_resample_scale;
+// (previous offset - new offset) / previous zoom
+uniform vec2 u_resample_bias;
+
+#define UNKNOWN			(-2.0) // see colour_shader.frag
+
+void main()
+{
+	vec2 translated = (gl_FragCoord.xy / u_resolution) - 0.5;
+	vec2 uv = translated * u_resample_scale + u_resample_bias + 0.5;
+
+	if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) {
+		IterationOut = vec2(UNKNOWN, 0.0); // outside of what the previous frame covered
+		return;
+	}
+
+	IterationOut = texture(u_previous_frame, uv).rg;
+}
\ No newline at end of file
@@ -4,7 +4,13 @@
 #include <vector>
 #include "ConsoleArgumentCpp/ArgumentParser.hpp"
 
+#include <algorithm>
+#include <filesystem>
+#include <map>
 #include <regex>
+#include <sstream>
+
+#include "arb_prec_gen.hpp"
 
 #include "git_rev.h"
 #include <stdio.h>
@@ -19,6 +25,194 @@
 
 using namespace ArgPar;
 
+// a uniform declaration of a shader, name[array_size] of type, or a uniform block when type is empty
+struct uniform_t {
+	std::string type;
+	std::string name;
+	int array_size;
+};
+
+// "layout(...) uniform <qualifiers> type name[size]" or "layout(...) uniform block_name {"
+static const std::regex UNIFORM_REGEX(
+	R"(^\s*(?:layout\s*\([^)]*\)\s*)?uniform\s+(?:(?:highp|mediump|lowp|readonly|writeonly|coherent|volatile|restrict)\s+)*)"
+	R"((\w+)(?:\s+(\w+)\s*(?:\[\s*(\d+)\s*\])?)?\s*([;={]))");
+
+// fills every @key@ of a template in a single pass, values are copied as they are and never searched for keys, an @
+// that does not start a known key is copied too
+std::string fill_template(const std::string& text, const std::map<std::string, std::string>& values)
+{
+	std::string filled;
+	filled.reserve(text.size());
+	size_t position = 0;
+	while (position < text.size()) {
+		size_t start = text.find('@', position);
+		if (start == std::string::npos)
+			break;
+		filled.append(text, position, start - position);
+		size_t end = text.find('@', start + 1);
+		auto value = end == std::string::npos ? values.end() : values.find(text.substr(start + 1, end - start - 1));
+		if (value == values.end()) {
+			filled += '@';
+			position = start + 1;
+		} else {
+			filled += value->second;
+			position = end + 1;
+		}
+	}
+	filled.append(text, position, std::string::npos);
+	return filled;
+}
+
+// the uniforms a shader declares, every line is appended to content indented by a tab when it is given
+bool parse_shader(const std::string& path, std::vector<uniform_t>& uniforms, std::string* content)
+{
+	std::ifstream shader_file(path, std::ios::in);
+	if (!shader_file.is_open())
+		return false;
+
+	std::string temp_line;
+	std::smatch match;
+	while (std::getline(shader_file, temp_line)) {
+		// the regex only runs on the few lines that can declare one
+		if (temp_line.find("uniform") != std::string::npos && std::regex_search(temp_line, match, UNIFORM_REGEX)) {
+			if (match[4] == "{")
+				uniforms.push_back({"", match[1], 0});
+			else if (match[2].matched)
+				uniforms.push_back({match[1], match[2], match[3].matched ? std::stoi(match[3]) : 0});
+		}
+		if (content)
+			*content += "\t" + temp_line + "\n";
+	}
+	return true;
+}
+
+// locations of the plain uniforms of one shader, resolved once after linking instead of looked up by name every use,
+// empty when it has none
+std::string uniform_struct(const std::string& file_name, const std::string& struct_name,
+	const std::vector<uniform_t>& uniforms)
+{
+	std::string members, resolve;
+	for (const uniform_t& uniform : uniforms) {
+		if (uniform.type.empty())
+			continue; // blocks are bound through their block index
+		members += "\tint " + uniform.name + " = -1; /* " + uniform.type + " */\n";
+		if (uniform.array_size)
+			members += "\tstatic constexpr int " + uniform.name + "_size = " + std::to_string(uniform.array_size) + ";\n";
+		resolve += "\t\t" + uniform.name + " = glGetUniformLocation(program, \"" + uniform.name + "\");\n";
+	}
+	if (members.empty())
+		return "";
+	return fill_template(
+		"\n"
+		"/* uniform locations of @file_name@, -1 until resolved or when optimised out */\n"
+		"struct @struct_name@_uniforms_t {\n"
+		"@members@"
+		"\n"
+		"\t/* looks every location up, once after the program is linked */\n"
+		"\tvoid resolve(unsigned int program)\n"
+		"\t{\n"
+		"@resolve@"
+		"\t}\n"
+		"};\n",
+		{{"file_name", file_name}, {"struct_name", struct_name}, {"members", members}, {"resolve", resolve}});
+}
+
+// writes path only when its content changed, so what includes it is not rebuilt for nothing
+int write_if_changed(const std::string& path, const std::string& content)
+{
+	std::ifstream existing(path, std::ios::in | std::ios::binary);
+	std::stringstream existing_content;
+	existing_content << existing.rdbuf();
+	if (existing.is_open() && existing_content.str() == content)
+		return 0;
+	existing.close();
+
+	std::cout << "saving to " << path << std::endl;
+	std::ofstream file(path, std::ios::out | std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "unable to create " << path << std::endl;
+		return -3;
+	}
+	file << content;
+	return 0;
+}
+
+// writes gen_uniforms.h, one struct per shader below directory that declares plain uniforms, subdirectories prefix
+// their names the way gen_shaders.sh prefixes the shader sources
+int generate_uniforms(const std::string& directory, std::string path)
+{
+	std::vector<std::filesystem::path> shaders;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+		if (entry.is_regular_file())
+			shaders.push_back(entry.path());
+	if (error) {
+		std::cout << "unable to read " << directory << std::endl;
+		return -2;
+	}
+	std::sort(shaders.begin(), shaders.end());
+
+	std::string structs;
+	for (const std::filesystem::path& shader : shaders) {
+		std::vector<uniform_t> uniforms;
+		if (!parse_shader(shader.string(), uniforms, nullptr)) {
+			std::cout << "unable to open " << shader.string() << std::endl;
+			return -2;
+		}
+		std::string relative = std::filesystem::relative(shader, directory).generic_string();
+		std::string struct_name = std::filesystem::path(relative).replace_extension().generic_string();
+		std::replace(struct_name.begin(), struct_name.end(), '/', '_');
+		structs += uniform_struct(relative, struct_name, uniforms);
+	}
+
+	if (!path.empty() && path.back() != '/' && path.back() != '\\')
+		path += "/";
+	return write_if_changed(path + "gen_uniforms.h", fill_template(
+		"#ifndef __GEN_UNIFORMS_H__\n"
+		"#define __GEN_UNIFORMS_H__\n"
+		"\n"
+		"/* File generated by ShaderGenTool */\n"
+		"\n"
+		"/* One struct per shader file with the locations of its uniforms, a program resolves the structs of its stages */\n"
+		"\n"
+		"#include <glad/glad.h>\n"
+		"\n"
+		"/* GSV: Generates Shader Value */\n"
+		"namespace GSV {\n"
+		"@structs@"
+		"\n"
+		"}; // namespace GSV\n"
+		"\n"
+		"#endif /* __GEN_UNIFORMS_H__ */\n",
+		{{"structs", structs}}));
+}
+
+constexpr int ARB_PREC_TRIALS = 20000; // random operands per operation and limb count checked before writing
+
+// writes arb_prec_ops.glsl for a limb range such as "2-8", only when it changed so shaders are not rebuilt for nothing
+int generate_arb_prec(const std::string& range, std::string path)
+{
+	int min_limbs = 0, max_limbs = 0;
+	char separator = 0;
+	std::istringstream range_stream(range);
+	if (!(range_stream >> min_limbs >> separator >> max_limbs) || separator != '-' ||
+		min_limbs < arb_prec_gen::MIN_LIMBS || max_limbs > arb_prec_gen::MAX_LIMBS || min_limbs > max_limbs) {
+		std::cout << "\"" << range << "\" is not a limb range within " << arb_prec_gen::MIN_LIMBS << "-"
+			<< arb_prec_gen::MAX_LIMBS << std::endl;
+		return -1;
+	}
+
+	std::cout << "Checking arbitrary precision operations of " << min_limbs << " to " << max_limbs << " limbs" << std::endl;
+	if (!arb_prec_gen::check(min_limbs, max_limbs, ARB_PREC_TRIALS))
+		return -4;
+
+	if (!path.empty() && path.back() != '/' && path.back() != '\\')
+		path += "/";
+	path += "arb_prec_ops.glsl";
+
+	return write_if_changed(path, arb_prec_gen::glsl(min_limbs, max_limbs));
+}
+
 int main(int argc, const char* argv[]) {
 
 	ArgumentParser AP("ShaderGenTool", 1, 0);
@@ -33,8 +227,8 @@ int main(int argc, const char* argv[]) {
 
 	AP.addArgument<std::string>("-S", "--Shader")
 		.Help("Input shader file full path")
-		.Required()
 		.ParameterName("Input File")
+		.DefaultValue("")
 		.Validator([](const std::vector<std::string>& parameters){
 			if (FILE *file = fopen(parameters[0].c_str(), "r")) {
 				fclose(file);
@@ -49,6 +243,16 @@ int main(int argc, const char* argv[]) {
 		.Help("Specifies the output directory")
 		.DefaultValue(".");
 
+	AP.addArgument<std::string>("-A", "--ArbPrec")
+		.Help("Generates arb_prec_ops.glsl, the unrolled arb_prec_t operations for a range of limb counts such as 2-8")
+		.ParameterName("Limb Range")
+		.DefaultValue("");
+
+	AP.addArgument<std::string>("-U", "--Uniforms")
+		.Help("Generates gen_uniforms.h, the uniform location structs of every shader in a directory")
+		.ParameterName("Shader Directory")
+		.DefaultValue("");
+
 
 	try{
 		AP.ParseArguments(argc, argv);
@@ -67,7 +271,19 @@ int main(int argc, const char* argv[]) {
 		return -1;
 	}
 
+	std::string arb_prec_range = AP["--ArbPrec"].Parse<std::string>(0);
+	if (!arb_prec_range.empty())
+		return generate_arb_prec(arb_prec_range, AP["-O"].Parse<std::string>(0));
+
+	std::string uniforms_directory = AP["--Uniforms"].Parse<std::string>(0);
+	if (!uniforms_directory.empty())
+		return generate_uniforms(uniforms_directory, AP["-O"].Parse<std::string>(0));
+
 	std::string file_path = AP["--Shader"].Parse<std::string>(0);
+	if (file_path.empty()) {
+		std::cout << "one of --Shader, --ArbPrec or --Uniforms is required" << std::endl;
+		return -1;
+	}
 	std::string file_name;
 	std::string file_ext = ""; // will be .frag, .vert, etc...
 	std::size_t pos = file_path.find_last_of("\\/");
@@ -85,22 +301,9 @@ int main(int argc, const char* argv[]) {
 	
 	std::cout << "Parsing shader file: " << file_name << file_ext << std::endl;
 
-	std::ifstream shader_file;
-	shader_file.open(file_path, std::ios::in);
-
 	std::string file_content;
-
-	std::vector<std::string> uniforms;
-
-	if (shader_file.is_open()) {
-		std::string temp_line;
-		while(std::getline(shader_file, temp_line)) {
-			if (temp_line.find("uniform") != std::string::npos)
-				uniforms.push_back(temp_line);
-			file_content += "\t" + temp_line + "\n";
-		}
-		shader_file.close();
-	} else {
+	std::vector<uniform_t> uniforms;
+	if (!parse_shader(file_path, uniforms, &file_content)) {
 		std::cout << "unable to open " << file_path << std::endl;
 		return -2;
 	}
@@ -161,29 +364,20 @@ int main(int argc, const char* argv[]) {
 						"#endif\n"
 						"\n";
 
+	// the location structs of every shader are written to gen_uniforms.h by --Uniforms
 	std::string extern_uniforms;
 	std::string str_uniforms;
-	for (size_t i = 0; i < uniforms.size(); i++) {
-		size_t pos = uniforms[i].find_last_of(" ");
-		uniforms[i] = uniforms[i].substr(pos+1);
-		pos = uniforms[i].find_first_of(";");
-		uniforms[i] = uniforms[i].substr(0, pos);
-		pos = uniforms[i].find_first_of("[");
-		if (pos != std::string::npos)
-			uniforms[i] = uniforms[i].substr(0, pos);
-		extern_uniforms += "extern uniform_name_t " + uniforms[i] + ";\n";
-		str_uniforms += "uniform_name_t " + uniforms[i] + " = \"" + uniforms[i] + "\";\n";
+	for (const uniform_t& uniform : uniforms) {
+		extern_uniforms += "extern uniform_name_t " + uniform.name + ";\n";
+		str_uniforms += "uniform_name_t " + uniform.name + " = \"" + uniform.name + "\";\n";
 	}
 
 	std::string uppercase_file_name = file_name;
 	std::transform(uppercase_file_name.begin(), uppercase_file_name.end(), uppercase_file_name.begin(), ::toupper);
-	header_output = std::regex_replace(header_output, std::regex("@FILE_NAME@"), uppercase_file_name);
-	header_output = std::regex_replace(header_output, std::regex("@file_name@"), file_name);
-	header_output = std::regex_replace(header_output, std::regex("@extern_uniforms@"), extern_uniforms);
-
-	source_output = std::regex_replace(source_output, std::regex("@file_name@"), file_name);
-	source_output = std::regex_replace(source_output, std::regex("@uniforms@"), str_uniforms);
-	source_output = std::regex_replace(source_output, std::regex("@file_content@"), file_content);
+	header_output = fill_template(header_output, {{"FILE_NAME", uppercase_file_name}, {"file_name", file_name},
+		{"extern_uniforms", extern_uniforms}});
+	source_output = fill_template(source_output, {{"file_name", file_name}, {"uniforms", str_uniforms},
+		{"file_content", file_content}});
 
 	std::ofstream header_file, source_file;
 	std::string path = AP["-O"].Parse<std::string>(0);
@@ -0,0 +1,458 @@
+#include "arb_prec_gen.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <random>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
+#include "arb_prec.hpp"
+
+namespace {
+
+enum op_t { INPUT, CONSTANT, ADD, SUB, MUL, AND, OR, XOR, SHL, SHR, LESS, EQUAL, SELECT };
+
+struct node_t {
+	op_t op;
+	int a, b, c;		// operand nodes, -1 when unused
+	uint32_t value;		// CONSTANT: the value, INPUT: its slot
+	std::string name;	// INPUT: how GLSL reads it
+};
+
+uint32_t apply(op_t op, uint32_t a, uint32_t b, uint32_t c)
+{
+	switch (op) {
+		case ADD:    return a + b;
+		case SUB:    return a - b;
+		case MUL:    return a * b;
+		case AND:    return a & b;
+		case OR:     return a | b;
+		case XOR:    return a ^ b;
+		case SHL:    return a << b;
+		case SHR:    return a >> b;
+		case LESS:   return a < b;
+		case EQUAL:  return a == b;
+		case SELECT: return a != 0u ? b : c;
+		default:     return 0u;
+	}
+}
+
+// straight line program over 32 bit unsigned values, identical instructions are only kept once and constants folded
+class program_t {
+	std::vector<node_t> nodes;
+	std::map<std::tuple<int, int, int, int>, int> known;
+	int inputs = 0;
+
+	bool is_constant(int node, uint32_t value) const { return nodes[node].op == CONSTANT && nodes[node].value == value; }
+
+	int append(const node_t& node)
+	{
+		nodes.push_back(node);
+		return (int)nodes.size() - 1;
+	}
+
+	std::string operand(int node) const
+	{
+		if (nodes[node].op == INPUT)
+			return nodes[node].name;
+		if (nodes[node].op == CONSTANT)
+			return std::to_string(nodes[node].value) + "u";
+		return "t" + std::to_string(node);
+	}
+
+public:
+	std::vector<std::pair<std::string, int>> outputs; // GLSL lvalue and the node written to it
+
+	int input(const std::string& name)
+	{
+		return append({INPUT, -1, -1, -1, (uint32_t)inputs++, name});
+	}
+
+	int constant(uint32_t value)
+	{
+		auto key = std::make_tuple((int)CONSTANT, (int)value, (int)(value >> 16), -1);
+		auto found = known.find(key);
+		if (found != known.end())
+			return found->second;
+		return known[key] = append({CONSTANT, -1, -1, -1, value, ""});
+	}
+
+	int op(op_t op, int a, int b, int c = -1)
+	{
+		if (op == ADD || op == MUL || op == AND || op == OR || op == XOR || op == EQUAL) {
+			if (a > b)
+				std::swap(a, b); // commutative, a * b and b * a are one node
+		}
+
+		// folding, the zero initialised accumulators of mul and the carries into them mostly vanish here
+		bool constant_operands = nodes[a].op == CONSTANT && nodes[b].op == CONSTANT && (c < 0 || nodes[c].op == CONSTANT);
+		if (constant_operands)
+			return constant(apply(op, nodes[a].value, nodes[b].value, c < 0 ? 0u : nodes[c].value));
+		switch (op) {
+			case ADD:    if (is_constant(a, 0u)) return b; if (is_constant(b, 0u)) return a; break;
+			case SUB:    if (is_constant(b, 0u)) return a; if (a == b) return constant(0u); break;
+			case MUL:    if (is_constant(a, 0u)) return a; if (is_constant(a, 1u)) return b; break;
+			case AND:    if (is_constant(a, 0u)) return a; if (a == b) return a; break;
+			case OR:     if (is_constant(a, 0u)) return b; if (a == b) return a; break;
+			case XOR:    if (is_constant(a, 0u)) return b; if (a == b) return constant(0u); break;
+			case SHL:
+			case SHR:    if (is_constant(b, 0u)) return a; break;
+			case LESS:   if (a == b || is_constant(b, 0u)) return constant(0u); break;
+			case EQUAL:  if (a == b) return constant(1u); break;
+			case SELECT:
+				if (nodes[a].op == CONSTANT)
+					return nodes[a].value ? b : c;
+				if (b == c)
+					return b;
+				if ((nodes[a].op == LESS || nodes[a].op == EQUAL) && is_constant(b, 1u) && is_constant(c, 0u))
+					return a; // already 0 or 1
+				break;
+			default: break;
+		}
+
+		auto key = std::make_tuple((int)op, a, b, c);
+		auto found = known.find(key);
+		if (found != known.end())
+			return found->second;
+		return known[key] = append({op, a, b, c, 0u, ""});
+	}
+
+	// instructions the outputs depend on, the rest is left out
+	std::vector<bool> live(void) const
+	{
+		std::vector<bool> used(nodes.size(), false);
+		for (const auto& output : outputs)
+			used[output.second] = true;
+		for (int node = (int)nodes.size() - 1; node >= 0; node--) {
+			if (!used[node])
+				continue;
+			for (int operand : {nodes[node].a, nodes[node].b, nodes[node].c}) {
+				if (operand >= 0)
+					used[operand] = true;
+			}
+		}
+		return used;
+	}
+
+	std::string glsl(void) const
+	{
+		std::ostringstream out;
+		std::vector<bool> used = live();
+		for (size_t node = 0; node < nodes.size(); node++) {
+			const node_t& n = nodes[node];
+			if (!used[node] || n.op == INPUT || n.op == CONSTANT)
+				continue;
+			std::string a = operand(n.a), b = n.b >= 0 ? operand(n.b) : "";
+			out << "\tuint t" << node << " = ";
+			switch (n.op) {
+				case ADD:    out << a << " + " << b; break;
+				case SUB:    out << a << " - " << b; break;
+				case MUL:    out << a << " * " << b; break;
+				case AND:    out << a << " & " << b; break;
+				case OR:     out << a << " | " << b; break;
+				case XOR:    out << a << " ^ " << b; break;
+				case SHL:    out << a << " << " << b; break;
+				case SHR:    out << a << " >> " << b; break;
+				case LESS:   out << "uint(" << a << " < " << b << ")"; break;
+				case EQUAL:  out << "uint(" << a << " == " << b << ")"; break;
+				case SELECT: out << a << " != 0u ? " << b << " : " << operand(n.c); break;
+				default: break;
+			}
+			out << ";\n";
+		}
+		for (const auto& output : outputs)
+			out << "\t" << output.first << " = " << operand(output.second) << ";\n";
+		return out.str();
+	}
+
+	std::vector<uint32_t> run(const std::vector<uint32_t>& input_values) const
+	{
+		std::vector<uint32_t> values(nodes.size());
+		for (size_t node = 0; node < nodes.size(); node++) {
+			const node_t& n = nodes[node];
+			if (n.op == INPUT)
+				values[node] = input_values[n.value];
+			else if (n.op == CONSTANT)
+				values[node] = n.value;
+			else
+				values[node] = apply(n.op, values[n.a], values[n.b], n.c >= 0 ? values[n.c] : 0u);
+		}
+
+		std::vector<uint32_t> results;
+		for (const auto& output : outputs)
+			results.push_back(values[output.second]);
+		return results;
+	}
+};
+
+std::vector<int> limbs(program_t& program, const std::string& name, int precision)
+{
+	std::vector<int> x;
+	for (int i = 0; i <= precision; i++)
+		x.push_back(program.input(name + "[" + std::to_string(i) + "]"));
+	return x;
+}
+
+void write(program_t& program, const std::vector<int>& r, int precision)
+{
+	for (int i = 0; i <= precision; i++)
+		program.outputs.push_back({"r[" + std::to_string(i) + "]", r[i]});
+}
+
+// arb_prec_n_t::operator+=, every path is computed and the signs select the result, sub negates b first
+program_t build_add(int precision, bool subtract)
+{
+	program_t p;
+	std::vector<int> a = limbs(p, "a", precision), b = limbs(p, "b", precision), r(precision + 1);
+	int zero = p.constant(0u), one = p.constant(1u);
+
+	int pa = p.op(EQUAL, a[0], zero);
+	int pb = p.op(EQUAL, b[0], zero);
+	if (subtract)
+		pb = p.op(XOR, pb, one);
+	int same = p.op(EQUAL, pa, pb);
+
+	// same signs, the magnitudes add up, a carry out of the integer limb is lost as in the C++ type
+	std::vector<int> sum(precision + 1);
+	int carry = zero;
+	for (int i = precision; i > 0; i--) {
+		int partial = p.op(ADD, a[i], b[i]);
+		int next = p.op(LESS, partial, a[i]);
+		sum[i] = p.op(ADD, partial, carry);
+		carry = next;
+	}
+
+	// opposite signs, the smaller magnitude is taken from the larger one, the leading differing limb decides which
+	int flip = zero;
+	for (int i = precision; i > 0; i--)
+		flip = p.op(SELECT, p.op(LESS, a[i], b[i]), one, p.op(SELECT, p.op(LESS, b[i], a[i]), zero, flip));
+	int keep = p.op(XOR, flip, one);
+	std::vector<int> difference(precision + 1);
+	int borrow = zero;
+	for (int i = precision; i > 0; i--) {
+		int larger = p.op(SELECT, flip, b[i], a[i]);
+		int smaller = p.op(SELECT, flip, a[i], b[i]);
+		difference[i] = p.op(SUB, p.op(SUB, larger, smaller), borrow);
+		// the unflipped loop of the C++ type also borrows when smaller + borrow wraps around
+		borrow = p.op(OR, p.op(LESS, larger, p.op(ADD, smaller, borrow)), p.op(AND, keep, p.op(LESS, larger, smaller)));
+	}
+
+	for (int i = 1; i <= precision; i++)
+		r[i] = p.op(SELECT, same, sum[i], difference[i]);
+	r[0] = p.op(SELECT, same, p.op(XOR, pa, one), p.op(EQUAL, pa, flip));
+	write(p, r, precision);
+	return p;
+}
+
+// arb_prec_n_t::operator*=, squaring passes a for both operands so the mirrored partial products are shared
+program_t build_mul(int precision, bool square)
+{
+	program_t p;
+	std::vector<int> a = limbs(p, "a", precision);
+	std::vector<int> b = square ? a : limbs(p, "b", precision);
+	std::vector<int> r(precision + 1);
+	int zero = p.constant(0u), mask = p.constant(0xFFFFu), sixteen = p.constant(16u);
+
+	std::vector<int> product(2 * precision - 1, zero);
+	for (int i = 0; i < precision; i++) {
+		int carry = zero;
+		for (int j = 0; j < precision; j++) {
+			int x = a[precision - i], y = b[precision - j];
+			int& limb = product[i + j];
+
+			int value = p.op(MUL, x, y);
+			int next = p.op(LESS, p.op(ADD, limb, value), limb);
+			limb = p.op(ADD, limb, value);
+			next = p.op(ADD, next, p.op(LESS, p.op(ADD, limb, carry), limb));
+			limb = p.op(ADD, limb, carry);
+
+			// high word of x * y from 16 bit halves
+			int lower_x = p.op(AND, x, mask), upper_x = p.op(SHR, x, sixteen);
+			int lower_y = p.op(AND, y, mask), upper_y = p.op(SHR, y, sixteen);
+			int lower = p.op(MUL, lower_x, lower_y);
+			int upper = p.op(MUL, upper_x, upper_y);
+			int mid = p.op(MUL, lower_x, upper_y);
+			upper = p.op(ADD, upper, p.op(SHR, mid, sixteen));
+			mid = p.op(SHL, mid, sixteen);
+			upper = p.op(ADD, upper, p.op(LESS, p.op(ADD, lower, mid), lower));
+			lower = p.op(ADD, lower, mid);
+			mid = p.op(MUL, lower_y, upper_x);
+			upper = p.op(ADD, upper, p.op(SHR, mid, sixteen));
+			mid = p.op(SHL, mid, sixteen);
+			upper = p.op(ADD, upper, p.op(LESS, p.op(ADD, lower, mid), lower));
+
+			carry = p.op(ADD, upper, next);
+		}
+		if (i + precision < 2 * precision - 1)
+			product[i + precision] = p.op(ADD, product[i + precision], carry);
+	}
+
+	// round half up on the limb below the last one kept, the increment runs on while limbs wrap to zero
+	int increment = p.op(LESS, p.constant(0x7FFFFFFFu), product[precision - 2]);
+	for (int i = precision - 1; i < 2 * precision - 1; i++) {
+		product[i] = p.op(ADD, product[i], increment);
+		increment = p.op(AND, increment, p.op(EQUAL, product[i], zero));
+	}
+
+	for (int i = 0; i < precision; i++)
+		r[i + 1] = product[2 * precision - 2 - i];
+	r[0] = p.op(XOR, p.op(EQUAL, a[0], zero), p.op(EQUAL, b[0], zero));
+	write(p, r, precision);
+	return p;
+}
+
+// arb_prec_n_t::shift, every limb picks its source by comparing n against the distances it can come from
+program_t build_shift(int precision)
+{
+	program_t p;
+	std::vector<int> x = limbs(p, "x", precision), r(precision + 1);
+	int n = p.input("uint(n)");
+
+	r[0] = x[0];
+	for (int i = 1; i <= precision; i++) {
+		r[i] = p.constant(0u);
+		for (int k = 0; k < i; k++)
+			r[i] = p.op(SELECT, p.op(EQUAL, n, p.constant((uint32_t)k)), x[i - k], r[i]);
+	}
+	for (int i = 0; i <= precision; i++)
+		p.outputs.push_back({"x[" + std::to_string(i) + "]", r[i]});
+	return p;
+}
+
+std::string function(const std::string& signature, const program_t& program)
+{
+	return signature + "\n{\n" + program.glsl() + "}\n";
+}
+
+std::string glsl_limbs(int precision)
+{
+	std::string size = std::to_string(precision + 1);
+	std::string operand = "uint a[" + size + "], in uint b[" + size + "], out uint r[" + size + "])";
+	std::string text = "#if PRECISION == " + std::to_string(precision) + "\n\n";
+	text += function("void arb_add(in " + operand, build_add(precision, false)) + "\n";
+	text += function("void arb_sub(in " + operand, build_add(precision, true)) + "\n";
+	text += function("void arb_mul(in " + operand, build_mul(precision, false)) + "\n";
+	text += function("void arb_sqr(in uint a[" + size + "], out uint r[" + size + "])", build_mul(precision, true)) + "\n";
+	text += function("void arb_shift(inout uint x[" + size + "], in int n)", build_shift(precision)) + "\n";
+	text += "#endif // PRECISION == " + std::to_string(precision) + "\n";
+	return text;
+}
+
+// operands that reach the carry, borrow, comparison and rounding corner cases far more often than uniform ones would
+uint32_t random_limb(std::mt19937& random)
+{
+	static const uint32_t special[] = {0u, 1u, 0xFFFFu, 0x10000u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFEu, 0xFFFFFFFFu};
+	if (random() % 2)
+		return random();
+	return special[random() % (sizeof(special) / sizeof(special[0]))];
+}
+
+template <int PRECISION>
+arb_prec_n_t<PRECISION> random_value(std::mt19937& random)
+{
+	arb_prec_n_t<PRECISION> x;
+	x.buffer()[0] = random() % 2;
+	for (int i = 1; i <= PRECISION; i++)
+		x.buffer()[i] = random_limb(random);
+	return x;
+}
+
+template <int PRECISION>
+std::vector<uint32_t> words(std::initializer_list<const arb_prec_n_t<PRECISION>*> values)
+{
+	std::vector<uint32_t> result;
+	for (const arb_prec_n_t<PRECISION>* value : values)
+		result.insert(result.end(), value->buffer(), value->buffer() + PRECISION + 1);
+	return result;
+}
+
+template <int PRECISION>
+bool matches(const char* name, const std::vector<uint32_t>& generated, const arb_prec_n_t<PRECISION>& expected,
+	const std::vector<uint32_t>& operands)
+{
+	if (std::equal(generated.begin(), generated.end(), expected.buffer()))
+		return true;
+
+	std::cout << "[ARBPREC] [ERR]: \"Generated " << name << " of " << PRECISION << " limbs differs from arb_prec_n_t\", "
+		<< std::hex << std::setfill('0');
+	for (const auto& part : {std::make_pair("operands", operands), std::make_pair("generated", generated),
+		std::make_pair("expected", std::vector<uint32_t>(expected.buffer(), expected.buffer() + PRECISION + 1))}) {
+		std::cout << part.first << ":";
+		for (uint32_t word : part.second)
+			std::cout << " " << std::setw(8) << word;
+		std::cout << " ";
+	}
+	std::cout << std::dec << std::endl;
+	return false;
+}
+
+template <int PRECISION>
+bool check_limbs(int trials, std::mt19937& random)
+{
+	program_t add = build_add(PRECISION, false), sub = build_add(PRECISION, true);
+	program_t mul = build_mul(PRECISION, false), sqr = build_mul(PRECISION, true), shift = build_shift(PRECISION);
+
+	for (int trial = 0; trial < trials; trial++) {
+		arb_prec_n_t<PRECISION> a = random_value<PRECISION>(random), b = random_value<PRECISION>(random);
+		if (random() % 4 == 0) {
+			// a shared leading part, the comparison has to look further down
+			int from = 1 + random() % PRECISION;
+			for (int i = 1; i < from; i++)
+				b.buffer()[i] = a.buffer()[i];
+		}
+		std::vector<uint32_t> both = words<PRECISION>({&a, &b}), single = words<PRECISION>({&a});
+		int n = random() % (PRECISION + 2);
+		std::vector<uint32_t> shifted = single;
+		shifted.push_back((uint32_t)n);
+
+		if (!matches("add", add.run(both), arb_prec_n_t<PRECISION>(a) += b, both) ||
+			!matches("sub", sub.run(both), arb_prec_n_t<PRECISION>(a) -= b, both) ||
+			!matches("mul", mul.run(both), arb_prec_n_t<PRECISION>(a) *= b, both) ||
+			!matches("sqr", sqr.run(single), arb_prec_n_t<PRECISION>(a) *= a, single) ||
+			!matches("shift", shift.run(shifted), arb_prec_n_t<PRECISION>(a).shift(n), shifted))
+			return false;
+	}
+	return true;
+}
+
+template <int... LIMBS>
+bool check_all(int min_limbs, int max_limbs, int trials, std::integer_sequence<int, LIMBS...>)
+{
+	std::mt19937 random(0x4d42u); // fixed, a failing build fails the same way every time
+	bool passed = true;
+	((passed = passed && (LIMBS + arb_prec_gen::MIN_LIMBS < min_limbs || LIMBS + arb_prec_gen::MIN_LIMBS > max_limbs ||
+		check_limbs<LIMBS + arb_prec_gen::MIN_LIMBS>(trials, random))), ...);
+	return passed;
+}
+
+}; // namespace
+
+namespace arb_prec_gen {
+
+std::string glsl(int min_limbs, int max_limbs)
+{
+	std::string text =
+		"// Generated by ShaderGenTool --ArbPrec from arb_prec_n_t (app/inc/arb_prec.hpp), do not edit\n"
+		"// Unrolled operations of the arbprec tiers, spliced in after mandelbrot.glsl which declares them. The set of the\n"
+		"// tier's PRECISION is compiled, limb 0 holds the sign, limb 1 the integer part and the rest fractions of 2^-32.\n"
+		"#if PRECISION_TIER == TIER_ARBPREC\n"
+		"#if PRECISION < " + std::to_string(min_limbs) + " || PRECISION > " + std::to_string(max_limbs) + "\n"
+		"#error no operations generated for this PRECISION\n"
+		"#endif\n\n";
+	for (int precision = min_limbs; precision <= max_limbs; precision++)
+		text += glsl_limbs(precision) + "\n";
+	text += "#endif // PRECISION_TIER";
+	return text;
+}
+
+bool check(int min_limbs, int max_limbs, int trials)
+{
+	return check_all(min_limbs, max_limbs, trials, std::make_integer_sequence<int, MAX_LIMBS - MIN_LIMBS + 1>());
+}
+
+}; // namespace arb_prec_gen
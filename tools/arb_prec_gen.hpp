@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+/**
+ * Generates the arbitrary precision operations of mandelbrot.glsl as unrolled, branch free GLSL, one set of functions
+ * per limb count.
+ * Every operation is built once as a straight list of 32 bit integer instructions that follows arb_prec_n_t
+ * (app/inc/arb_prec.hpp) step for step, with its loops unrolled and its branches turned into selects. The same list is
+ * printed as GLSL and run on random operands next to arb_prec_n_t, so the shader and the C++ type cannot drift apart.
+ */
+namespace arb_prec_gen {
+	constexpr int MIN_LIMBS = 2; // the rounding of a product reads the limb below the last one kept
+	constexpr int MAX_LIMBS = 8; // arb_prec_t, the deepest tier
+
+	// arb_add, arb_sub, arb_mul, arb_sqr and arb_shift for every PRECISION from min_limbs to max_limbs
+	std::string glsl(int min_limbs, int max_limbs);
+
+	// runs every operation of every limb count on random operands, prints the first mismatch and returns false
+	bool check(int min_limbs, int max_limbs, int trials);
+};